@@ -0,0 +1,133 @@
+#ifndef BLOCK_RENDERER_H
+#define BLOCK_RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include "BlockWorld.h"
+#include "RigidWorld.h"
+
+/*
+Draws a whole BlockWorld or RigidWorld in one draw call.
+
+Every block, its outline and its velocity arrow are written as quads into
+one vertex array that is kept between frames, so there are no per-block
+shapes and no allocation once the array has grown to size.
+*/
+
+class BlockRenderer {
+public:
+    bool outlines;
+    bool arrows;
+
+    BlockRenderer() : vertices(sf::Quads) {
+        outlines = true;
+        arrows = true;
+    }
+
+    void update(const BlockWorld& world, const std::vector<sf::Color>& colors) {
+        int n = world.size();
+        size_t perBlock = 4 + (outlines ? 4 : 0) + (arrows ? 4 : 0);
+        vertices.resize(n * perBlock);
+
+        size_t k = 0;
+        for (int i = 0; i < n; i++) {
+            float x = world.x[i], y = world.y[i];
+            float w = world.w[i], h = world.h[i];
+
+            // Outline is a black quad under the block
+            if (outlines) {
+                setQuad(k, x - 2, y - 2, x + w + 2, y + h + 2, sf::Color::Black);
+            }
+            setQuad(k, x, y, x + w, y + h, colors[i]);
+
+            // Velocity arrow as a thin quad; zero area if not moving
+            if (arrows) {
+                float cx = x + w / 2;
+                float cy = y + h / 2;
+                float ex = cx + world.vx[i];
+                float ey = cy + world.vy[i];
+                float length = std::sqrt(world.vx[i] * world.vx[i] + world.vy[i] * world.vy[i]);
+                float nx = 0.0f, ny = 0.0f;
+                if (length > 0.0f) {
+                    nx = -world.vy[i] / length * 0.75f;
+                    ny = world.vx[i] / length * 0.75f;
+                }
+                vertices[k++] = sf::Vertex(sf::Vector2f(cx + nx, cy + ny), colors[i]);
+                vertices[k++] = sf::Vertex(sf::Vector2f(ex + nx, ey + ny), colors[i]);
+                vertices[k++] = sf::Vertex(sf::Vector2f(ex - nx, ey - ny), colors[i]);
+                vertices[k++] = sf::Vertex(sf::Vector2f(cx - nx, cy - ny), colors[i]);
+            }
+        }
+    }
+
+    // Rotated boxes. Static bodies are drawn grey, sleeping ones faded.
+    void update(const RigidWorld& world, const std::vector<sf::Color>& colors) {
+        int n = world.size();
+        vertices.resize(n * (outlines ? 8 : 4));
+
+        size_t k = 0;
+        Vec2 c[4];
+        for (int i = 0; i < n; i++) {
+            const RigidBody& b = world.bodies[i];
+            world.corners(i, c);
+
+            if (outlines) {
+                // Corners pushed out 1.5 px along the box's own axes
+                Mat22 rot(b.angle);
+                Vec2 ex = rot.col1 * 1.5f, ey = rot.col2 * 1.5f;
+                setQuad(k, c[0] - ex - ey, c[1] + ex - ey, c[2] + ex + ey, c[3] - ex + ey, sf::Color::Black);
+            }
+            sf::Color color = b.isStatic() ? sf::Color(150, 150, 150) : colors[i];
+            if (!b.isStatic() && !b.awake) {
+                color = sf::Color((color.r + 240) / 2, (color.g + 240) / 2, (color.b + 240) / 2);
+            }
+            setQuad(k, c[0], c[1], c[2], c[3], color);
+        }
+    }
+
+    void draw(sf::RenderWindow& window) const {
+        window.draw(vertices);
+    }
+
+private:
+    sf::VertexArray vertices;
+
+    void setQuad(size_t& k, Vec2 a, Vec2 b, Vec2 c, Vec2 d, sf::Color color) {
+        vertices[k++] = sf::Vertex(sf::Vector2f(a.x, a.y), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(b.x, b.y), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(c.x, c.y), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(d.x, d.y), color);
+    }
+
+    void setQuad(size_t& k, float left, float top, float right, float bottom, sf::Color color) {
+        vertices[k++] = sf::Vertex(sf::Vector2f(left, top), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(right, top), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(right, bottom), color);
+        vertices[k++] = sf::Vertex(sf::Vector2f(left, bottom), color);
+    }
+};
+
+// HUD text that only rebuilds its string when the values it shows change.
+// Call changed() with the values (rounded to what is displayed) and only
+// format a new string when it returns true.
+class HudText {
+public:
+    sf::Text text;
+
+    bool changed(std::initializer_list<double> values) {
+        if (shown.size() == values.size() && std::equal(values.begin(), values.end(), shown.begin())) {
+            return false;
+        }
+        shown.assign(values.begin(), values.end());
+        return true;
+    }
+
+private:
+    std::vector<double> shown;
+};
+
+#endif // BLOCK_RENDERER_H
@@ -0,0 +1,476 @@
+#ifndef BLOCK_WORLD_H
+#define BLOCK_WORLD_H
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include "SweepAndPrune.h"
+#include "UnionFind.h"
+#include "ThreadPool.h"
+
+/*
+N axis-aligned blocks bouncing elastically inside a box.
+
+Block state is stored as structure-of-arrays so a tick streams through
+memory. Each tick:
+  1. Sweep-and-prune over each block's swept box (everywhere it could
+     reach this tick) finds candidate pairs. The box is a cheap guess;
+     a tick in which some block leaves its box is run again with a box
+     no block can leave (see findCandidates).
+  2. Union-find over the pairs splits the blocks into islands. Blocks in
+     different islands can't touch this tick, so each island is solved on
+     its own, and islands are shared out over a thread pool.
+  3. Within an island the time of impact of every candidate pair and every
+     wall is worked out and queued, and impacts are resolved in time
+     order. After each one the blocks involved get their walls and
+     candidate partners re-predicted, so a block that is knocked into a
+     neighbour mid-tick still hits it.
+
+An island is solved the same way whichever thread gets it, and stats are
+added up in island order, so results don't depend on the thread count.
+
+Positions are the top-left corner, like Block in collision.cpp.
+*/
+
+class BlockWorld {
+public:
+    float width, height;
+
+    // Block state
+    std::vector<float> x, y;
+    std::vector<float> w, h;
+    std::vector<float> vx, vy;
+    std::vector<float> mass;
+
+    // Stats from the last step
+    int candidatePairs;
+    int impacts;
+    int islandCount;
+    long long totalCollisions;   // block-block, since the world was made
+    long long totalWallHits;     // block-wall, since the world was made
+
+    // Momentum the walls have put in, so momentum() - wall impulse should
+    // stay at its starting value
+    double wallImpulseX, wallImpulseY;
+
+    BlockWorld(float worldWidth, float worldHeight) {
+        width = worldWidth;
+        height = worldHeight;
+        candidatePairs = 0;
+        impacts = 0;
+        islandCount = 0;
+        totalCollisions = 0;
+        totalWallHits = 0;
+        wallImpulseX = 0.0;
+        wallImpulseY = 0.0;
+        setThreads(1);
+    }
+
+    // Threads used to solve islands. 1 runs everything on the caller.
+    void setThreads(int count) {
+        pool.reset(new ThreadPool(count));
+        queues.resize(pool->size());
+    }
+
+    int threads() const {
+        return pool->size();
+    }
+
+    int addBlock(float px, float py, float bw, float bh, float m, float velx, float vely = 0.0f) {
+        x.push_back(px);
+        y.push_back(py);
+        w.push_back(bw);
+        h.push_back(bh);
+        vx.push_back(velx);
+        vy.push_back(vely);
+        mass.push_back(m);
+        localTime.push_back(0.0f);
+        version.push_back(0);
+        return size() - 1;
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        w.clear();
+        h.clear();
+        vx.clear();
+        vy.clear();
+        mass.clear();
+        localTime.clear();
+        version.clear();
+        sweep.reset();
+        totalCollisions = 0;
+        totalWallHits = 0;
+        wallImpulseX = 0.0;
+        wallImpulseY = 0.0;
+    }
+
+    int size() const {
+        return (int)x.size();
+    }
+
+    void step(float dt) {
+        startX = x;
+        startY = y;
+        startVx = vx;
+        startVy = vy;
+
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1) {
+                // A block got out of its swept box, so it may have passed a
+                // block it was never paired with. Run the tick again with
+                // boxes it can't leave.
+                x = startX;
+                y = startY;
+                vx = startVx;
+                vy = startVy;
+            }
+            findCandidates(dt, pass == 1);
+            findIslands();
+
+            islandStats.assign(islandCount, IslandStats());
+            pool->parallelFor(islandCount, 256, [&](int begin, int end, int worker) {
+                for (int island = begin; island < end; island++) {
+                    solveIsland(island, dt, queues[worker], islandStats[island]);
+                }
+            });
+
+            bool escaped = false;
+            for (const IslandStats& stats : islandStats) escaped = escaped || stats.escaped;
+            if (!escaped) break;
+        }
+
+        // Add up in island order so sums don't depend on who ran what
+        impacts = 0;
+        for (const IslandStats& stats : islandStats) {
+            impacts += stats.impacts;
+            totalCollisions += stats.collisions;
+            totalWallHits += stats.impacts - stats.collisions;
+            wallImpulseX += stats.wallImpulseX;
+            wallImpulseY += stats.wallImpulseY;
+        }
+    }
+
+    float kineticEnergy() const {
+        double energy = 0.0;
+        for (int i = 0; i < size(); i++) {
+            energy += 0.5 * mass[i] * (vx[i] * vx[i] + vy[i] * vy[i]);
+        }
+        return (float)energy;
+    }
+
+    void momentum(float& px, float& py) const {
+        double sx = 0.0, sy = 0.0;
+        for (int i = 0; i < size(); i++) {
+            sx += mass[i] * vx[i];
+            sy += mass[i] * vy[i];
+        }
+        px = (float)sx;
+        py = (float)sy;
+    }
+
+private:
+    static const int kWall = -1;
+
+    struct Impact {
+        float time;
+        int a, b;           // b is kWall for a wall
+        int axis;           // 0 = x, 1 = y
+        int versionA, versionB;
+
+        bool operator>(const Impact& other) const {
+            if (time != other.time) return time > other.time;
+            if (a != other.a) return a > other.a;
+            return b > other.b;
+        }
+    };
+
+    // Min-heap of impacts. One per worker so its storage is reused.
+    typedef std::vector<Impact> ImpactQueue;
+
+    struct IslandStats {
+        int impacts = 0;
+        long long collisions = 0;
+        double wallImpulseX = 0.0;
+        double wallImpulseY = 0.0;
+        bool escaped = false;   // a block left its swept box
+    };
+
+    std::vector<float> localTime;   // time into the tick that x, y are at
+    std::vector<int> version;       // bumped on every impact
+    std::vector<float> startX, startY, startVx, startVy;   // to run a tick again
+
+    // Broadphase
+    SweepAndPrune sweep;
+    std::vector<float> sweptMinX, sweptMaxX, sweptMinY, sweptMaxY;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<int> partnerStart, partners;   // candidate pairs per block
+
+    // Islands, as runs of block indices
+    UnionFind unionFind;
+    std::vector<int> islandId;
+    std::vector<int> islandStart, islandBlocks, islandPairs;
+    std::vector<IslandStats> islandStats;
+
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<ImpactQueue> queues;
+
+    // How far a block could get this tick, either way since a wall or an
+    // impact can turn it round.
+    //
+    // The guess is its own speed plus the fastest speed in the world. That
+    // is only a guess: a block hit by a heavier one moving at V can leave
+    // at up to 2V plus its own speed, and a chain of impacts in one tick
+    // can do better still (heavy into medium into light sends the light
+    // block off at nearly 4V). So solveIsland flags any block that leaves
+    // its box, and the tick is run again with a bound that holds however
+    // the impacts go: impacts are elastic and push along one axis only, so
+    // each axis keeps its kinetic energy, and no block can move faster
+    // along x than if it had all of it, sqrt(2 Ex / m). That bound is far
+    // looser in a busy world (the example gases run 10x slower on it),
+    // which is why it isn't used every tick.
+    void findCandidates(float dt, bool energyBound) {
+        int n = size();
+        sweptMinX.resize(n);
+        sweptMaxX.resize(n);
+        sweptMinY.resize(n);
+        sweptMaxY.resize(n);
+
+        float fastestX = 0.0f, fastestY = 0.0f;
+        double energyX = 0.0, energyY = 0.0;   // twice the kinetic energy
+        for (int i = 0; i < n; i++) {
+            fastestX = std::max(fastestX, std::fabs(vx[i]));
+            fastestY = std::max(fastestY, std::fabs(vy[i]));
+            energyX += (double)mass[i] * vx[i] * vx[i];
+            energyY += (double)mass[i] * vy[i] * vy[i];
+        }
+        pool->parallelFor(n, 4096, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                float reachX, reachY;
+                if (energyBound) {
+                    // A hair over, so rounding can't put the fastest block outside
+                    reachX = (float)std::sqrt(energyX / mass[i]) * dt * 1.001f;
+                    reachY = (float)std::sqrt(energyY / mass[i]) * dt * 1.001f;
+                } else {
+                    reachX = (std::fabs(vx[i]) + fastestX) * dt;
+                    reachY = (std::fabs(vy[i]) + fastestY) * dt;
+                }
+                sweptMinX[i] = x[i] - reachX;
+                sweptMaxX[i] = x[i] + w[i] + reachX;
+                sweptMinY[i] = y[i] - reachY;
+                sweptMaxY[i] = y[i] + h[i] + reachY;
+            }
+        });
+        sweep.findPairs(sweptMinX, sweptMaxX, sweptMinY, sweptMaxY, pairs, pool.get());
+        candidatePairs = (int)pairs.size();
+
+        // Pairs per block, so re-prediction after an impact is local
+        partnerStart.assign(n + 1, 0);
+        for (const std::pair<int, int>& p : pairs) {
+            partnerStart[p.first + 1]++;
+            partnerStart[p.second + 1]++;
+        }
+        for (int i = 0; i < n; i++) partnerStart[i + 1] += partnerStart[i];
+        partners.resize(partnerStart[n]);
+        std::vector<int> fill(partnerStart.begin(), partnerStart.end() - 1);
+        for (const std::pair<int, int>& p : pairs) {
+            partners[fill[p.first]++] = p.second;
+            partners[fill[p.second]++] = p.first;
+        }
+    }
+
+    // Islands are numbered in order of their lowest block and list their
+    // blocks in index order, so the split is the same every run
+    void findIslands() {
+        int n = size();
+        unionFind.reset(n);
+        for (const std::pair<int, int>& p : pairs) unionFind.unite(p.first, p.second);
+
+        islandId.assign(n, -1);
+        islandCount = 0;
+        for (int i = 0; i < n; i++) {
+            int root = unionFind.find(i);
+            if (islandId[root] < 0) islandId[root] = islandCount++;
+            islandId[i] = islandId[root];
+        }
+
+        islandStart.assign(islandCount + 1, 0);
+        for (int i = 0; i < n; i++) islandStart[islandId[i] + 1]++;
+        for (int k = 0; k < islandCount; k++) islandStart[k + 1] += islandStart[k];
+        islandBlocks.resize(n);
+        std::vector<int> fill(islandStart.begin(), islandStart.end() - 1);
+        for (int i = 0; i < n; i++) islandBlocks[fill[islandId[i]]++] = i;
+
+        islandPairs.assign(islandCount, 0);
+        for (const std::pair<int, int>& p : pairs) islandPairs[islandId[p.first]]++;
+    }
+
+    void solveIsland(int island, float dt, ImpactQueue& queue, IslandStats& stats) {
+        queue.clear();
+        int begin = islandStart[island];
+        int end = islandStart[island + 1];
+
+        // Queue every impact inside this tick
+        for (int k = begin; k < end; k++) {
+            int i = islandBlocks[k];
+            localTime[i] = 0.0f;
+            predictWall(i, 0.0f, dt, queue);
+        }
+        for (int k = begin; k < end; k++) {
+            int i = islandBlocks[k];
+            for (int m = partnerStart[i]; m < partnerStart[i + 1]; m++) {
+                if (partners[m] > i) predictPair(i, partners[m], 0.0f, dt, queue);
+            }
+        }
+
+        // Resolve them in order. The cap only matters for blocks jammed
+        // together, which would otherwise trade impacts forever.
+        int maxImpacts = 16 * (end - begin + islandPairs[island]) + 64;
+        while (!queue.empty() && stats.impacts < maxImpacts) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<Impact>());
+            Impact e = queue.back();
+            queue.pop_back();
+            if (version[e.a] != e.versionA) continue;
+            if (e.b >= 0 && version[e.b] != e.versionB) continue;
+
+            stats.impacts++;
+            advanceTo(e.a, e.time, stats);
+            if (e.b < 0) {
+                resolveWall(e.a, e.axis, stats);
+                repredict(e.a, e.time, dt, queue);
+            } else {
+                advanceTo(e.b, e.time, stats);
+                resolvePair(e.a, e.b, e.axis);
+                stats.collisions++;
+                repredict(e.a, e.time, dt, queue);
+                repredict(e.b, e.time, dt, queue);
+            }
+        }
+
+        for (int k = begin; k < end; k++) advanceTo(islandBlocks[k], dt, stats);
+    }
+
+    // Blocks move in straight lines between impacts, so checking the box
+    // at every impact and at the end of the tick covers the whole path
+    void advanceTo(int i, float t, IslandStats& stats) {
+        x[i] += vx[i] * (t - localTime[i]);
+        y[i] += vy[i] * (t - localTime[i]);
+        localTime[i] = t;
+        if (x[i] < sweptMinX[i] || x[i] + w[i] > sweptMaxX[i] ||
+            y[i] < sweptMinY[i] || y[i] + h[i] > sweptMaxY[i]) {
+            stats.escaped = true;
+        }
+    }
+
+    void repredict(int i, float now, float dt, ImpactQueue& queue) {
+        predictWall(i, now, dt, queue);
+        for (int k = partnerStart[i]; k < partnerStart[i + 1]; k++) {
+            predictPair(i, partners[k], now, dt, queue);
+        }
+    }
+
+    void push(float t, int a, int b, int axis, ImpactQueue& queue) {
+        Impact e;
+        e.time = t;
+        e.a = a;
+        e.b = b;
+        e.axis = axis;
+        e.versionA = version[a];
+        e.versionB = (b >= 0) ? version[b] : 0;
+        queue.push_back(e);
+        std::push_heap(queue.begin(), queue.end(), std::greater<Impact>());
+    }
+
+    // When block i next reaches a wall, if before the end of the tick
+    void predictWall(int i, float now, float dt, ImpactQueue& queue) {
+        float best = dt - now;
+        int axis = -1;
+
+        float px = x[i] + vx[i] * (now - localTime[i]);
+        float py = y[i] + vy[i] * (now - localTime[i]);
+        float t;
+        if (vx[i] < 0 && (t = std::max(0.0f, -px / vx[i])) <= best) { best = t; axis = 0; }
+        if (vx[i] > 0 && (t = std::max(0.0f, (width - w[i] - px) / vx[i])) <= best) { best = t; axis = 0; }
+        if (vy[i] < 0 && (t = std::max(0.0f, -py / vy[i])) <= best) { best = t; axis = 1; }
+        if (vy[i] > 0 && (t = std::max(0.0f, (height - h[i] - py) / vy[i])) <= best) { best = t; axis = 1; }
+
+        if (axis >= 0) push(now + best, i, kWall, axis, queue);
+    }
+
+    // Times j's interval [b, b + wb] (moving at rv relative to i) overlaps
+    // i's interval [a, a + wa]. False if never.
+    static bool overlapInterval(float a, float wa, float b, float wb, float rv,
+                                float& entry, float& exit) {
+        if (rv == 0.0f) {
+            if (b >= a + wa || b + wb <= a) return false;
+            entry = -INFINITY;
+            exit = INFINITY;
+        } else if (rv > 0.0f) {
+            entry = (a - wb - b) / rv;
+            exit = (a + wa - b) / rv;
+        } else {
+            entry = (a + wa - b) / rv;
+            exit = (a - wb - b) / rv;
+        }
+        return true;
+    }
+
+    void predictPair(int i, int j, float now, float dt, ImpactQueue& queue) {
+        float xi = x[i] + vx[i] * (now - localTime[i]);
+        float yi = y[i] + vy[i] * (now - localTime[i]);
+        float xj = x[j] + vx[j] * (now - localTime[j]);
+        float yj = y[j] + vy[j] * (now - localTime[j]);
+        float rvx = vx[j] - vx[i];
+        float rvy = vy[j] - vy[i];
+
+        float entryX, exitX, entryY, exitY;
+        if (!overlapInterval(xi, w[i], xj, w[j], rvx, entryX, exitX)) return;
+        if (!overlapInterval(yi, h[i], yj, h[j], rvy, entryY, exitY)) return;
+
+        float entry = std::max(entryX, entryY);
+        float exit = std::min(exitX, exitY);
+        if (entry >= exit || exit <= 0.0f || entry > dt - now) return;
+
+        // The axis they met on is the one whose overlap started last.
+        // Only an impact if they are closing along it.
+        int axis = (entryX > entryY) ? 0 : 1;
+        float separation = (axis == 0) ? (xj + w[j] / 2) - (xi + w[i] / 2)
+                                       : (yj + h[j] / 2) - (yi + h[i] / 2);
+        float closing = (axis == 0) ? rvx : rvy;
+        if (separation * closing >= 0.0f) return;
+
+        push(now + std::max(0.0f, entry), std::min(i, j), std::max(i, j), axis, queue);
+    }
+
+    void resolveWall(int i, int axis, IslandStats& stats) {
+        if (axis == 0) {
+            stats.wallImpulseX -= 2.0 * mass[i] * vx[i];
+            vx[i] = -vx[i];
+            x[i] = std::min(std::max(x[i], 0.0f), width - w[i]);
+        } else {
+            stats.wallImpulseY -= 2.0 * mass[i] * vy[i];
+            vy[i] = -vy[i];
+            y[i] = std::min(std::max(y[i], 0.0f), height - h[i]);
+        }
+        version[i]++;
+    }
+
+    // 1D elastic collision along the contact axis
+    void resolvePair(int i, int j, int axis) {
+        std::vector<float>& v = (axis == 0) ? vx : vy;
+        float m1 = mass[i];
+        float m2 = mass[j];
+        float v1 = v[i];
+        float v2 = v[j];
+        v[i] = ((m1 - m2) * v1 + 2 * m2 * v2) / (m1 + m2);
+        v[j] = ((m2 - m1) * v2 + 2 * m1 * v1) / (m1 + m2);
+        version[i]++;
+        version[j]++;
+    }
+};
+
+#endif // BLOCK_WORLD_H
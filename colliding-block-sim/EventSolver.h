@@ -0,0 +1,258 @@
+#ifndef EVENT_SOLVER_H
+#define EVENT_SOLVER_H
+
+#include <cmath>
+#include <queue>
+#include <algorithm>
+#include <vector>
+
+/*
+Event-driven solver for blocks sliding along x between two walls.
+
+Instead of moving everything by the frame dt and checking for overlap
+afterwards, it works out analytically when the next block-block or
+block-wall impact happens and jumps straight there. Pending impacts sit in
+a priority queue. An event goes stale when either block has collided since
+it was predicted, and is skipped when popped.
+
+Collisions happen at the exact time of contact, so nothing tunnels however
+fast the blocks or however long the frame. The cost of a run is per event
+rather than per frame.
+
+Blocks only collide if their y ranges overlap, same as Block::collidesWith.
+*/
+
+class EventSolver {
+public:
+    double worldWidth;
+    double time;
+
+    // Stats
+    long long collisions;   // block-block
+    long long wallHits;
+    long long staleEvents;
+
+    EventSolver(double width) {
+        worldWidth = width;
+        clear();
+    }
+
+    void clear() {
+        bodies.clear();
+        events = EventQueue();
+        time = 0.0;
+        collisions = 0;
+        wallHits = 0;
+        staleEvents = 0;
+    }
+
+    // Returns the block's index
+    int addBlock(double x, double y, double width, double height, double mass, double vx) {
+        Body b;
+        b.x = x;
+        b.y = y;
+        b.width = width;
+        b.height = height;
+        b.vx = vx;
+        b.mass = mass;
+        b.t = time;
+        b.version = 0;
+        bodies.push_back(b);
+
+        int i = (int)bodies.size() - 1;
+        predictWalls(i);
+        for (int j = 0; j < i; j++) predictPair(j, i);
+        return i;
+    }
+
+    int size() const {
+        return (int)bodies.size();
+    }
+
+    // State at the current solver time
+    double x(int i) const {
+        return bodies[i].x + bodies[i].vx * (time - bodies[i].t);
+    }
+
+    double vx(int i) const {
+        return bodies[i].vx;
+    }
+
+    double mass(int i) const {
+        return bodies[i].mass;
+    }
+
+    // Process every impact up to time + dt, then leave the blocks there.
+    // maxEvents stops a pathological setup from hanging a frame; returns
+    // false if it was hit.
+    bool advance(double dt, long long maxEvents = 1000000) {
+        double target = time + dt;
+        long long processed = 0;
+        while (skipStale() && events.top().time <= target) {
+            if (processed++ >= maxEvents) return false;
+            step();
+        }
+        time = target;
+        return true;
+    }
+
+    // Jump to the next valid event and resolve it. Returns false if
+    // nothing is ever going to hit anything again.
+    bool step() {
+        if (!skipStale()) return false;
+
+        Event e = events.top();
+        events.pop();
+        time = e.time;
+        if (e.b < 0) resolveWall(e.a, e.b);
+        else resolvePair(e.a, e.b);
+
+        // Far-off predictions that went stale would otherwise pile up
+        if (events.size() > 64 + 8 * bodies.size()) dropStaleEvents();
+        return true;
+    }
+
+    // Time of the next event, or infinity
+    double nextEventTime() {
+        return skipStale() ? events.top().time : INFINITY;
+    }
+
+private:
+    struct Body {
+        double x;       // left edge at time t
+        double y;
+        double width, height;
+        double vx;
+        double mass;
+        double t;       // time x was last brought up to date
+        int version;    // bumped on every collision
+    };
+
+    static const int kLeftWall = -1;
+    static const int kRightWall = -2;
+
+    struct Event {
+        double time;
+        int a, b;                   // b < 0 for a wall
+        int versionA, versionB;
+
+        // Earliest first; ties broken by index so runs are repeatable
+        bool operator>(const Event& other) const {
+            if (time != other.time) return time > other.time;
+            if (a != other.a) return a > other.a;
+            return b > other.b;
+        }
+    };
+
+    typedef std::priority_queue<Event, std::vector<Event>, std::greater<Event>> EventQueue;
+
+    std::vector<Body> bodies;
+    EventQueue events;
+
+    bool isStale(const Event& e) const {
+        if (bodies[e.a].version != e.versionA) return true;
+        return e.b >= 0 && bodies[e.b].version != e.versionB;
+    }
+
+    // Pop stale events off the top; false if the queue runs dry
+    bool skipStale() {
+        while (!events.empty() && isStale(events.top())) {
+            events.pop();
+            staleEvents++;
+        }
+        return !events.empty();
+    }
+
+    void dropStaleEvents() {
+        std::vector<Event> live;
+        while (!events.empty()) {
+            if (!isStale(events.top())) live.push_back(events.top());
+            else staleEvents++;
+            events.pop();
+        }
+        events = EventQueue(std::greater<Event>(), std::move(live));
+    }
+
+    // Bring a block's position up to the current time
+    void sync(int i) {
+        Body& b = bodies[i];
+        b.x += b.vx * (time - b.t);
+        b.t = time;
+    }
+
+    void push(double t, int a, int b) {
+        Event e;
+        e.time = t;
+        e.a = a;
+        e.b = b;
+        e.versionA = bodies[a].version;
+        e.versionB = (b >= 0) ? bodies[b].version : 0;
+        events.push(e);
+    }
+
+    void predictWalls(int i) {
+        const Body& b = bodies[i];
+        double x0 = x(i);
+        if (b.vx < 0) {
+            push(time + std::max(0.0, -x0 / b.vx), i, kLeftWall);
+        } else if (b.vx > 0) {
+            push(time + std::max(0.0, (worldWidth - b.width - x0) / b.vx), i, kRightWall);
+        }
+    }
+
+    void predictPair(int i, int j) {
+        const Body& bi = bodies[i];
+        const Body& bj = bodies[j];
+        if (bi.y >= bj.y + bj.height || bj.y >= bi.y + bi.height) return;
+
+        // Order them left to right
+        int left = i, right = j;
+        if (x(j) < x(i)) std::swap(left, right);
+        const Body& l = bodies[left];
+        const Body& r = bodies[right];
+
+        double closing = l.vx - r.vx;
+        if (closing <= 0) return;
+        double gap = x(right) - (x(left) + l.width);
+        push(time + std::max(0.0, gap / closing), std::min(i, j), std::max(i, j));
+    }
+
+    void predict(int i) {
+        predictWalls(i);
+        for (int j = 0; j < (int)bodies.size(); j++) {
+            if (j != i) predictPair(i, j);
+        }
+    }
+
+    void resolveWall(int i, int wall) {
+        sync(i);
+        Body& b = bodies[i];
+        b.x = (wall == kLeftWall) ? 0.0 : worldWidth - b.width;
+        b.vx = -b.vx;
+        b.version++;
+        wallHits++;
+        predict(i);
+    }
+
+    // 1D elastic collision, same formulas as handleCollision
+    void resolvePair(int i, int j) {
+        sync(i);
+        sync(j);
+        Body& b1 = bodies[i];
+        Body& b2 = bodies[j];
+        double m1 = b1.mass;
+        double m2 = b2.mass;
+        double v1 = b1.vx;
+        double v2 = b2.vx;
+        b1.vx = ((m1 - m2) * v1 + 2 * m2 * v2) / (m1 + m2);
+        b2.vx = ((m2 - m1) * v2 + 2 * m1 * v1) / (m1 + m2);
+        b1.version++;
+        b2.version++;
+        collisions++;
+
+        predict(i);
+        predict(j);
+    }
+};
+
+#endif // EVENT_SOLVER_H
@@ -0,0 +1,847 @@
+/*
+The box-box collision (collide, clipSegmentToLine, incidentEdge and the
+FeaturePair / Edge numbering with its tolerances), the contact merge
+that carries accumulated impulses between steps, the Vec2 / Mat22 math
+and the preStep / warmStart / impulse solve are adapted from Box2D-Lite
+by Erin Catto. Changed from the original: renamed and restyled, a
+sweep-and-prune broadphase, and the solver extended with restitution,
+an early exit on velocityTolerance, islands and sleeping. The original
+carries this notice:
+
+  Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+
+  Permission to use, copy, modify, distribute and sell this software
+  and its documentation for any purpose is hereby granted without fee,
+  provided that the above copyright notice appear in all copies.
+  Erin Catto makes no representations about the suitability
+  of this software for any purpose.
+  It is provided "as is" without express or implied warranty.
+*/
+
+#ifndef RIGID_WORLD_H
+#define RIGID_WORLD_H
+
+#include <cmath>
+#include <map>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "SweepAndPrune.h"
+
+/*
+2D rigid-body boxes: rotation, gravity, friction and restitution, solved
+with sequential impulses.
+
+Each step:
+  1. Sweep-and-prune over the boxes' bounding boxes finds candidate pairs,
+     and box-box clipping turns each touching pair into a manifold of up
+     to two contact points.
+  2. Manifolds live in a contact cache keyed by body pair. A contact that
+     is still there next step (same pair of features) keeps the impulse it
+     ended the last step with, and that impulse is applied up front (warm
+     starting). A settled stack then starts each step almost solved.
+  3. Impulses are iterated until the largest velocity change they make
+     drops under velocityTolerance, or maxIterations is hit.
+  4. Bodies joined by contacts form islands. An island whose bodies have
+     all been nearly still for timeToSleep goes to sleep: its bodies stop
+     being integrated, their bounds stop being refreshed, and contacts
+     between sleeping bodies are neither re-clipped nor solved. A contact
+     from an awake body, or applyImpulse(), wakes the whole island again.
+     A settled pile then costs little more than the bodies still moving.
+
+Positions are box centres and y points down, same as the window.
+Static bodies (mass 0) never move; use them for the floor and walls.
+*/
+
+struct Vec2 {
+    float x, y;
+
+    Vec2() : x(0.0f), y(0.0f) {}
+    Vec2(float px, float py) : x(px), y(py) {}
+
+    Vec2 operator+(const Vec2& v) const { return Vec2(x + v.x, y + v.y); }
+    Vec2 operator-(const Vec2& v) const { return Vec2(x - v.x, y - v.y); }
+    Vec2 operator-() const { return Vec2(-x, -y); }
+    Vec2 operator*(float s) const { return Vec2(x * s, y * s); }
+    void operator+=(const Vec2& v) { x += v.x; y += v.y; }
+    void operator-=(const Vec2& v) { x -= v.x; y -= v.y; }
+};
+
+inline float dot(const Vec2& a, const Vec2& b) { return a.x * b.x + a.y * b.y; }
+inline float cross(const Vec2& a, const Vec2& b) { return a.x * b.y - a.y * b.x; }
+inline Vec2 cross(float w, const Vec2& r) { return Vec2(-w * r.y, w * r.x); }
+inline Vec2 absolute(const Vec2& v) { return Vec2(std::fabs(v.x), std::fabs(v.y)); }
+
+// 2x2 matrix stored by columns
+struct Mat22 {
+    Vec2 col1, col2;
+
+    Mat22() {}
+    Mat22(const Vec2& c1, const Vec2& c2) : col1(c1), col2(c2) {}
+    explicit Mat22(float angle) {
+        float c = std::cos(angle), s = std::sin(angle);
+        col1 = Vec2(c, s);
+        col2 = Vec2(-s, c);
+    }
+
+    Mat22 transpose() const {
+        return Mat22(Vec2(col1.x, col2.x), Vec2(col1.y, col2.y));
+    }
+    Vec2 operator*(const Vec2& v) const {
+        return Vec2(col1.x * v.x + col2.x * v.y, col1.y * v.x + col2.y * v.y);
+    }
+    Mat22 operator*(const Mat22& m) const {
+        return Mat22((*this) * m.col1, (*this) * m.col2);
+    }
+    Mat22 abs() const {
+        return Mat22(absolute(col1), absolute(col2));
+    }
+};
+
+struct RigidBody {
+    Vec2 position;
+    float angle;
+    Vec2 velocity;
+    float angularVelocity;
+    Vec2 halfSize;
+
+    float mass, invMass;
+    float inertia, invInertia;
+    float friction;
+    float restitution;
+
+    bool awake;
+    float sleepTime;        // seconds spent under the sleep thresholds
+
+    RigidBody(float x, float y, float width, float height, float m, float a = 0.0f) {
+        position = Vec2(x, y);
+        angle = a;
+        angularVelocity = 0.0f;
+        halfSize = Vec2(width / 2, height / 2);
+        friction = 0.5f;
+        restitution = 0.0f;
+        awake = true;
+        sleepTime = 0.0f;
+
+        mass = m;
+        if (m > 0.0f) {
+            invMass = 1.0f / m;
+            inertia = m * (width * width + height * height) / 12.0f;
+            invInertia = 1.0f / inertia;
+        } else {
+            invMass = 0.0f;
+            inertia = 0.0f;
+            invInertia = 0.0f;
+        }
+    }
+
+    bool isStatic() const {
+        return invMass == 0.0f;
+    }
+};
+
+// Which edges of the two boxes made a contact point. Stays the same from
+// step to step while the boxes rest on each other, so it identifies a
+// contact in the cache.
+struct FeaturePair {
+    char inEdge1, outEdge1, inEdge2, outEdge2;
+
+    int key() const {
+        return (inEdge1 << 24) | (outEdge1 << 16) | (inEdge2 << 8) | outEdge2;
+    }
+};
+
+struct Contact {
+    Vec2 position;
+    Vec2 normal;            // from body a to body b
+    float separation;       // negative when overlapping
+    FeaturePair feature;
+
+    // Accumulated impulses, carried between steps for warm starting
+    float normalImpulse;
+    float tangentImpulse;
+
+    float massNormal, massTangent;
+    float bias;
+
+    Contact() : separation(0.0f), normalImpulse(0.0f), tangentImpulse(0.0f),
+                massNormal(0.0f), massTangent(0.0f), bias(0.0f) {}
+};
+
+// Contact points between one pair of bodies
+struct Manifold {
+    int a, b;               // a < b
+    Contact contacts[2];
+    int count;
+    float friction;
+    float restitution;
+    bool touched;           // seen by this step's broadphase
+    bool queued;            // already in this step's island
+};
+
+class RigidWorld {
+public:
+    Vec2 gravity;
+    std::vector<RigidBody> bodies;
+
+    // Solver settings
+    int maxIterations;
+    float velocityTolerance;     // px/s, stop iterating below this
+    bool warmStarting;
+    float allowedPenetration;    // px
+    float biasFactor;            // fraction of overlap removed per step
+    float restitutionThreshold;  // px/s, slower impacts don't bounce
+
+    // Sleep settings
+    bool sleeping;
+    float sleepVelocity;         // px/s
+    float sleepAngularVelocity;  // rad/s
+    float timeToSleep;           // s
+
+    // Metrics from the last step
+    int iterations;
+    int contactCount;            // contact points solved
+    int awakeCount;              // moving bodies left after the step
+    int islandCount;             // awake islands solved
+    float solveMs;               // impulse iterations only
+    float stepMs;                // whole step
+
+    RigidWorld(float gravityY = 600.0f) {
+        gravity = Vec2(0.0f, gravityY);
+        maxIterations = 20;
+        velocityTolerance = 0.02f;
+        warmStarting = true;
+        allowedPenetration = 0.5f;
+        biasFactor = 0.2f;
+        restitutionThreshold = 40.0f;
+        sleeping = true;
+        sleepVelocity = 2.0f;
+        sleepAngularVelocity = 0.035f;
+        timeToSleep = 0.5f;
+        iterations = 0;
+        contactCount = 0;
+        awakeCount = 0;
+        islandCount = 0;
+        solveMs = 0.0f;
+        stepMs = 0.0f;
+    }
+
+    int addBody(const RigidBody& body) {
+        bodies.push_back(body);
+        return (int)bodies.size() - 1;
+    }
+
+    void clear() {
+        bodies.clear();
+        manifolds.clear();
+        bodyManifolds.clear();
+        boundedCount = 0;
+        sweep.reset();
+    }
+
+    void wake(int i) {
+        bodies[i].awake = true;
+        bodies[i].sleepTime = 0.0f;
+    }
+
+    // Push from outside the simulation, e.g. the mouse. Wakes the body,
+    // and its island follows on the next step.
+    void applyImpulse(int i, const Vec2& impulse, const Vec2& point) {
+        RigidBody& b = bodies[i];
+        if (b.isStatic()) return;
+        wake(i);
+        b.velocity += impulse * b.invMass;
+        b.angularVelocity += b.invInertia * cross(point - b.position, impulse);
+    }
+
+    // Body containing point, or -1
+    int findBody(const Vec2& point) const {
+        for (int i = 0; i < size(); i++) {
+            const RigidBody& b = bodies[i];
+            Vec2 local = Mat22(b.angle).transpose() * (point - b.position);
+            if (std::fabs(local.x) <= b.halfSize.x && std::fabs(local.y) <= b.halfSize.y) return i;
+        }
+        return -1;
+    }
+
+    int size() const {
+        return (int)bodies.size();
+    }
+
+    void step(float dt) {
+        auto start = std::chrono::steady_clock::now();
+        float invDt = (dt > 0.0f) ? 1.0f / dt : 0.0f;
+
+        findContacts();
+        buildIslands();
+
+        // Forces
+        for (int i : islandBodies) {
+            bodies[i].velocity += gravity * dt;
+        }
+
+        for (Manifold* m : active) preStep(*m, invDt);
+        if (warmStarting) {
+            for (Manifold* m : active) warmStart(*m);
+        }
+
+        auto solveStart = std::chrono::steady_clock::now();
+        iterations = 0;
+        while (iterations < maxIterations && !active.empty()) {
+            iterations++;
+            float largest = 0.0f;
+            for (Manifold* m : active) {
+                largest = std::max(largest, applyImpulses(*m));
+            }
+            if (largest < velocityTolerance) break;
+        }
+        auto solveEnd = std::chrono::steady_clock::now();
+
+        // Move
+        for (int i : islandBodies) {
+            RigidBody& b = bodies[i];
+            b.position += b.velocity * dt;
+            b.angle += b.angularVelocity * dt;
+        }
+
+        updateSleep(dt);
+
+        auto end = std::chrono::steady_clock::now();
+        solveMs = std::chrono::duration<float, std::milli>(solveEnd - solveStart).count();
+        stepMs = std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    // Corners in window coordinates, for drawing
+    void corners(int i, Vec2 out[4]) const {
+        const RigidBody& b = bodies[i];
+        Mat22 rot(b.angle);
+        Vec2 h = b.halfSize;
+        out[0] = b.position + rot * Vec2(-h.x, -h.y);
+        out[1] = b.position + rot * Vec2(h.x, -h.y);
+        out[2] = b.position + rot * Vec2(h.x, h.y);
+        out[3] = b.position + rot * Vec2(-h.x, h.y);
+    }
+
+    float kineticEnergy() const {
+        double energy = 0.0;
+        for (const RigidBody& b : bodies) {
+            if (b.isStatic()) continue;
+            energy += 0.5 * b.mass * dot(b.velocity, b.velocity);
+            energy += 0.5 * b.inertia * b.angularVelocity * b.angularVelocity;
+        }
+        return (float)energy;
+    }
+
+private:
+    enum Axis { FACE_A_X, FACE_A_Y, FACE_B_X, FACE_B_Y };
+    enum Edge { NO_EDGE = 0, EDGE1, EDGE2, EDGE3, EDGE4 };
+
+    struct ClipVertex {
+        Vec2 v;
+        FeaturePair fp;
+    };
+
+    // The contact cache. std::map so manifolds can be sorted into the same
+    // order every step, and pointers into it stay valid.
+    std::map<std::pair<int, int>, Manifold> manifolds;
+    std::vector<std::vector<Manifold*>> bodyManifolds;
+
+    SweepAndPrune sweep;
+    std::vector<float> boundMinX, boundMaxX, boundMinY, boundMaxY;
+    std::vector<std::pair<int, int>> pairs;
+    int boundedCount = 0;        // bodies whose bounds have been set once
+
+    // This step's awake islands: body lists back to back, and every
+    // manifold touching them
+    std::vector<int> islandBodies;
+    std::vector<int> islandStart;
+    std::vector<Manifold*> active;
+    std::vector<char> visited;
+    std::vector<int> stack;
+    std::vector<std::pair<int, int>> stale;
+
+    bool isMoving(int i) const {
+        return bodies[i].awake && !bodies[i].isStatic();
+    }
+
+    void findContacts() {
+        int n = size();
+        boundMinX.resize(n);
+        boundMaxX.resize(n);
+        boundMinY.resize(n);
+        boundMaxY.resize(n);
+        bodyManifolds.resize(n);
+
+        // Sleeping and static bodies keep the bounds they had
+        bool anyMoving = false;
+        for (int i = 0; i < n; i++) {
+            if (i < boundedCount && !isMoving(i)) continue;
+            const RigidBody& b = bodies[i];
+            Vec2 extent = Mat22(b.angle).abs() * b.halfSize;
+            boundMinX[i] = b.position.x - extent.x;
+            boundMaxX[i] = b.position.x + extent.x;
+            boundMinY[i] = b.position.y - extent.y;
+            boundMaxY[i] = b.position.y + extent.y;
+            anyMoving = anyMoving || isMoving(i);
+        }
+        boundedCount = n;
+
+        // Nothing moved, so there are no new pairs to find
+        if (!anyMoving) return;
+        sweep.findPairs(boundMinX, boundMaxX, boundMinY, boundMaxY, pairs);
+
+        // Only moving bodies' contacts can have changed
+        for (int i = 0; i < n; i++) {
+            if (!isMoving(i)) continue;
+            for (Manifold* m : bodyManifolds[i]) m->touched = false;
+        }
+
+        for (const std::pair<int, int>& p : pairs) {
+            bool movingA = isMoving(p.first);
+            bool movingB = isMoving(p.second);
+            if (!movingA && !movingB) continue;
+
+            Manifold fresh;
+            fresh.a = p.first;
+            fresh.b = p.second;
+            fresh.count = collide(fresh.contacts, bodies[p.first], bodies[p.second]);
+            if (fresh.count == 0) continue;
+            fresh.friction = std::sqrt(bodies[p.first].friction * bodies[p.second].friction);
+            fresh.restitution = std::max(bodies[p.first].restitution, bodies[p.second].restitution);
+            fresh.touched = true;
+            fresh.queued = false;
+
+            // Woken by contact
+            if (!movingA && !bodies[p.first].isStatic()) wake(p.first);
+            if (!movingB && !bodies[p.second].isStatic()) wake(p.second);
+
+            auto found = manifolds.find(p);
+            if (found == manifolds.end()) {
+                Manifold* m = &manifolds.insert(std::make_pair(p, fresh)).first->second;
+                bodyManifolds[p.first].push_back(m);
+                bodyManifolds[p.second].push_back(m);
+            } else {
+                merge(found->second, fresh);
+            }
+        }
+
+        // Pairs that stopped touching drop out of the cache
+        stale.clear();
+        for (int i = 0; i < n; i++) {
+            if (!isMoving(i)) continue;
+            for (Manifold* m : bodyManifolds[i]) {
+                if (!m->touched && m->a == i) stale.push_back(std::make_pair(m->a, m->b));
+                if (!m->touched && m->b == i && !isMoving(m->a)) stale.push_back(std::make_pair(m->a, m->b));
+            }
+        }
+        for (const std::pair<int, int>& p : stale) {
+            Manifold* m = &manifolds.find(p)->second;
+            for (int body : {p.first, p.second}) {
+                std::vector<Manifold*>& list = bodyManifolds[body];
+                list.erase(std::find(list.begin(), list.end(), m));
+            }
+            manifolds.erase(p);
+        }
+    }
+
+    // Flood fill from each moving body through its contacts. Sleeping
+    // bodies reached this way are woken; static bodies join no island.
+    void buildIslands() {
+        int n = size();
+        visited.resize(n, 0);
+        islandBodies.clear();
+        islandStart.clear();
+        active.clear();
+
+        for (int seed = 0; seed < n; seed++) {
+            if (!isMoving(seed) || visited[seed]) continue;
+            islandStart.push_back((int)islandBodies.size());
+            visited[seed] = 1;
+            stack.push_back(seed);
+            while (!stack.empty()) {
+                int i = stack.back();
+                stack.pop_back();
+                islandBodies.push_back(i);
+                for (Manifold* m : bodyManifolds[i]) {
+                    if (!m->queued) {
+                        m->queued = true;
+                        active.push_back(m);
+                    }
+                    int other = (m->a == i) ? m->b : m->a;
+                    if (bodies[other].isStatic() || visited[other]) continue;
+                    if (!bodies[other].awake) wake(other);
+                    visited[other] = 1;
+                    stack.push_back(other);
+                }
+            }
+        }
+        islandStart.push_back((int)islandBodies.size());
+        islandCount = (int)islandStart.size() - 1;
+
+        for (int i : islandBodies) visited[i] = 0;
+
+        // Same solve order as walking the whole cache
+        std::sort(active.begin(), active.end(), [](const Manifold* x, const Manifold* y) {
+            return std::make_pair(x->a, x->b) < std::make_pair(y->a, y->b);
+        });
+        contactCount = 0;
+        for (Manifold* m : active) {
+            m->queued = false;
+            contactCount += m->count;
+        }
+    }
+
+    // An island sleeps once every body in it has been slow for timeToSleep
+    void updateSleep(float dt) {
+        float linear = sleepVelocity * sleepVelocity;
+        float angular = sleepAngularVelocity * sleepAngularVelocity;
+        awakeCount = (int)islandBodies.size();
+
+        for (int k = 0; k < islandCount; k++) {
+            float slowest = timeToSleep;
+            for (int j = islandStart[k]; j < islandStart[k + 1]; j++) {
+                RigidBody& b = bodies[islandBodies[j]];
+                if (dot(b.velocity, b.velocity) > linear ||
+                    b.angularVelocity * b.angularVelocity > angular) {
+                    b.sleepTime = 0.0f;
+                } else {
+                    b.sleepTime += dt;
+                }
+                slowest = std::min(slowest, b.sleepTime);
+            }
+            if (!sleeping || slowest < timeToSleep) continue;
+
+            for (int j = islandStart[k]; j < islandStart[k + 1]; j++) {
+                RigidBody& b = bodies[islandBodies[j]];
+                b.awake = false;
+                b.velocity = Vec2();
+                b.angularVelocity = 0.0f;
+            }
+            awakeCount -= islandStart[k + 1] - islandStart[k];
+        }
+    }
+
+    // New contact points take the impulse of the old point with the same
+    // features, if there was one
+    void merge(Manifold& cached, const Manifold& fresh) {
+        Contact merged[2];
+        for (int i = 0; i < fresh.count; i++) {
+            merged[i] = fresh.contacts[i];
+            for (int j = 0; j < cached.count; j++) {
+                if (cached.contacts[j].feature.key() == fresh.contacts[i].feature.key()) {
+                    if (warmStarting) {
+                        merged[i].normalImpulse = cached.contacts[j].normalImpulse;
+                        merged[i].tangentImpulse = cached.contacts[j].tangentImpulse;
+                    }
+                    break;
+                }
+            }
+        }
+        cached = fresh;
+        for (int i = 0; i < fresh.count; i++) cached.contacts[i] = merged[i];
+    }
+
+    void applyImpulse(RigidBody& a, RigidBody& b, const Vec2& ra, const Vec2& rb, const Vec2& impulse) {
+        a.velocity -= impulse * a.invMass;
+        a.angularVelocity -= a.invInertia * cross(ra, impulse);
+        b.velocity += impulse * b.invMass;
+        b.angularVelocity += b.invInertia * cross(rb, impulse);
+    }
+
+    static Vec2 relativeVelocity(const RigidBody& a, const RigidBody& b, const Vec2& ra, const Vec2& rb) {
+        return b.velocity + cross(b.angularVelocity, rb) - a.velocity - cross(a.angularVelocity, ra);
+    }
+
+    void preStep(Manifold& m, float invDt) {
+        RigidBody& a = bodies[m.a];
+        RigidBody& b = bodies[m.b];
+        for (int i = 0; i < m.count; i++) {
+            Contact& c = m.contacts[i];
+            Vec2 ra = c.position - a.position;
+            Vec2 rb = c.position - b.position;
+
+            float rna = dot(ra, c.normal);
+            float rnb = dot(rb, c.normal);
+            float kNormal = a.invMass + b.invMass
+                          + a.invInertia * (dot(ra, ra) - rna * rna)
+                          + b.invInertia * (dot(rb, rb) - rnb * rnb);
+            c.massNormal = 1.0f / kNormal;
+
+            Vec2 tangent(c.normal.y, -c.normal.x);
+            float rta = dot(ra, tangent);
+            float rtb = dot(rb, tangent);
+            float kTangent = a.invMass + b.invMass
+                           + a.invInertia * (dot(ra, ra) - rta * rta)
+                           + b.invInertia * (dot(rb, rb) - rtb * rtb);
+            c.massTangent = 1.0f / kTangent;
+
+            // Push overlap apart a bit each step, and bounce fast impacts
+            c.bias = -biasFactor * invDt * std::min(0.0f, c.separation + allowedPenetration);
+            float vn = dot(relativeVelocity(a, b, ra, rb), c.normal);
+            if (vn < -restitutionThreshold) {
+                c.bias = std::max(c.bias, -m.restitution * vn);
+            }
+
+            if (!warmStarting) {
+                c.normalImpulse = 0.0f;
+                c.tangentImpulse = 0.0f;
+            }
+        }
+    }
+
+    // Runs after every preStep, so the bounce check above sees the
+    // velocities from before any cached impulse was applied
+    void warmStart(Manifold& m) {
+        RigidBody& a = bodies[m.a];
+        RigidBody& b = bodies[m.b];
+        for (int i = 0; i < m.count; i++) {
+            const Contact& c = m.contacts[i];
+            Vec2 tangent(c.normal.y, -c.normal.x);
+            Vec2 impulse = c.normal * c.normalImpulse + tangent * c.tangentImpulse;
+            applyImpulse(a, b, c.position - a.position, c.position - b.position, impulse);
+        }
+    }
+
+    // One pass over a manifold. Returns the largest change in contact
+    // velocity it made, for the convergence check.
+    float applyImpulses(Manifold& m) {
+        RigidBody& a = bodies[m.a];
+        RigidBody& b = bodies[m.b];
+        float largest = 0.0f;
+        for (int i = 0; i < m.count; i++) {
+            Contact& c = m.contacts[i];
+            Vec2 ra = c.position - a.position;
+            Vec2 rb = c.position - b.position;
+
+            // Normal: accumulated impulse stays pushing, never pulling
+            float vn = dot(relativeVelocity(a, b, ra, rb), c.normal);
+            float dPn = c.massNormal * (-vn + c.bias);
+            float old = c.normalImpulse;
+            c.normalImpulse = std::max(old + dPn, 0.0f);
+            dPn = c.normalImpulse - old;
+            applyImpulse(a, b, ra, rb, c.normal * dPn);
+
+            // Friction, limited by the normal impulse
+            Vec2 tangent(c.normal.y, -c.normal.x);
+            float vt = dot(relativeVelocity(a, b, ra, rb), tangent);
+            float dPt = c.massTangent * -vt;
+            float maxPt = m.friction * c.normalImpulse;
+            old = c.tangentImpulse;
+            c.tangentImpulse = std::max(-maxPt, std::min(old + dPt, maxPt));
+            dPt = c.tangentImpulse - old;
+            applyImpulse(a, b, ra, rb, tangent * dPt);
+
+            largest = std::max(largest, std::fabs(dPn) / c.massNormal);
+            largest = std::max(largest, std::fabs(dPt) / c.massTangent);
+        }
+        return largest;
+    }
+
+    // Box-box contact by separating axes, then clipping the incident edge
+    // against the reference face.
+
+    static int clipSegmentToLine(ClipVertex out[2], const ClipVertex in[2],
+                                 const Vec2& normal, float offset, char clipEdge) {
+        int count = 0;
+        float d0 = dot(normal, in[0].v) - offset;
+        float d1 = dot(normal, in[1].v) - offset;
+
+        if (d0 <= 0.0f) out[count++] = in[0];
+        if (d1 <= 0.0f) out[count++] = in[1];
+
+        if (d0 * d1 < 0.0f) {
+            float t = d0 / (d0 - d1);
+            out[count].v = in[0].v + (in[1].v - in[0].v) * t;
+            if (d0 > 0.0f) {
+                out[count].fp = in[0].fp;
+                out[count].fp.inEdge1 = clipEdge;
+                out[count].fp.inEdge2 = NO_EDGE;
+            } else {
+                out[count].fp = in[1].fp;
+                out[count].fp.outEdge1 = clipEdge;
+                out[count].fp.outEdge2 = NO_EDGE;
+            }
+            count++;
+        }
+        return count;
+    }
+
+    // Edge of a box most anti-parallel to normal
+    static void incidentEdge(ClipVertex c[2], const Vec2& h, const Vec2& pos,
+                             const Mat22& rot, const Vec2& normal) {
+        Vec2 n = -(rot.transpose() * normal);
+        Vec2 nAbs = absolute(n);
+
+        if (nAbs.x > nAbs.y) {
+            if (n.x > 0.0f) {
+                c[0].v = Vec2(h.x, -h.y);
+                c[0].fp.inEdge2 = EDGE3;
+                c[0].fp.outEdge2 = EDGE4;
+                c[1].v = Vec2(h.x, h.y);
+                c[1].fp.inEdge2 = EDGE4;
+                c[1].fp.outEdge2 = EDGE1;
+            } else {
+                c[0].v = Vec2(-h.x, h.y);
+                c[0].fp.inEdge2 = EDGE1;
+                c[0].fp.outEdge2 = EDGE2;
+                c[1].v = Vec2(-h.x, -h.y);
+                c[1].fp.inEdge2 = EDGE2;
+                c[1].fp.outEdge2 = EDGE3;
+            }
+        } else {
+            if (n.y > 0.0f) {
+                c[0].v = Vec2(h.x, h.y);
+                c[0].fp.inEdge2 = EDGE4;
+                c[0].fp.outEdge2 = EDGE1;
+                c[1].v = Vec2(-h.x, h.y);
+                c[1].fp.inEdge2 = EDGE1;
+                c[1].fp.outEdge2 = EDGE2;
+            } else {
+                c[0].v = Vec2(-h.x, -h.y);
+                c[0].fp.inEdge2 = EDGE2;
+                c[0].fp.outEdge2 = EDGE3;
+                c[1].v = Vec2(h.x, -h.y);
+                c[1].fp.inEdge2 = EDGE3;
+                c[1].fp.outEdge2 = EDGE4;
+            }
+        }
+        c[0].fp.inEdge1 = c[0].fp.outEdge1 = NO_EDGE;
+        c[1].fp.inEdge1 = c[1].fp.outEdge1 = NO_EDGE;
+
+        c[0].v = pos + rot * c[0].v;
+        c[1].v = pos + rot * c[1].v;
+    }
+
+    static int collide(Contact contacts[2], const RigidBody& bodyA, const RigidBody& bodyB) {
+        Vec2 hA = bodyA.halfSize;
+        Vec2 hB = bodyB.halfSize;
+        Vec2 posA = bodyA.position;
+        Vec2 posB = bodyB.position;
+        Mat22 rotA(bodyA.angle), rotB(bodyB.angle);
+        Mat22 rotAT = rotA.transpose();
+        Mat22 rotBT = rotB.transpose();
+
+        Vec2 dp = posB - posA;
+        Vec2 dA = rotAT * dp;
+        Vec2 dB = rotBT * dp;
+
+        Mat22 C = rotAT * rotB;
+        Mat22 absC = C.abs();
+        Mat22 absCT = absC.transpose();
+
+        // Separation along each box's face normals
+        Vec2 faceA = absolute(dA) - hA - absC * hB;
+        if (faceA.x > 0.0f || faceA.y > 0.0f) return 0;
+        Vec2 faceB = absolute(dB) - absCT * hA - hB;
+        if (faceB.x > 0.0f || faceB.y > 0.0f) return 0;
+
+        // Least-penetrating axis, preferring A's faces so the choice
+        // doesn't flicker between near-equal axes
+        const float relativeTol = 0.95f;
+        const float absoluteTol = 0.01f;
+
+        Axis axis = FACE_A_X;
+        float separation = faceA.x;
+        Vec2 normal = dA.x > 0.0f ? rotA.col1 : -rotA.col1;
+
+        if (faceA.y > relativeTol * separation + absoluteTol * hA.y) {
+            axis = FACE_A_Y;
+            separation = faceA.y;
+            normal = dA.y > 0.0f ? rotA.col2 : -rotA.col2;
+        }
+        if (faceB.x > relativeTol * separation + absoluteTol * hB.x) {
+            axis = FACE_B_X;
+            separation = faceB.x;
+            normal = dB.x > 0.0f ? rotB.col1 : -rotB.col1;
+        }
+        if (faceB.y > relativeTol * separation + absoluteTol * hB.y) {
+            axis = FACE_B_Y;
+            separation = faceB.y;
+            normal = dB.y > 0.0f ? rotB.col2 : -rotB.col2;
+        }
+
+        // Reference face and the side planes that bound it
+        Vec2 frontNormal, sideNormal;
+        ClipVertex incident[2];
+        float front, negSide, posSide;
+        char negEdge, posEdge;
+
+        switch (axis) {
+        case FACE_A_X: {
+            frontNormal = normal;
+            front = dot(posA, frontNormal) + hA.x;
+            sideNormal = rotA.col2;
+            float side = dot(posA, sideNormal);
+            negSide = -side + hA.y;
+            posSide = side + hA.y;
+            negEdge = EDGE3;
+            posEdge = EDGE1;
+            incidentEdge(incident, hB, posB, rotB, frontNormal);
+            break;
+        }
+        case FACE_A_Y: {
+            frontNormal = normal;
+            front = dot(posA, frontNormal) + hA.y;
+            sideNormal = rotA.col1;
+            float side = dot(posA, sideNormal);
+            negSide = -side + hA.x;
+            posSide = side + hA.x;
+            negEdge = EDGE2;
+            posEdge = EDGE4;
+            incidentEdge(incident, hB, posB, rotB, frontNormal);
+            break;
+        }
+        case FACE_B_X: {
+            frontNormal = -normal;
+            front = dot(posB, frontNormal) + hB.x;
+            sideNormal = rotB.col2;
+            float side = dot(posB, sideNormal);
+            negSide = -side + hB.y;
+            posSide = side + hB.y;
+            negEdge = EDGE3;
+            posEdge = EDGE1;
+            incidentEdge(incident, hA, posA, rotA, frontNormal);
+            break;
+        }
+        default: {
+            frontNormal = -normal;
+            front = dot(posB, frontNormal) + hB.y;
+            sideNormal = rotB.col1;
+            float side = dot(posB, sideNormal);
+            negSide = -side + hB.x;
+            posSide = side + hB.x;
+            negEdge = EDGE2;
+            posEdge = EDGE4;
+            incidentEdge(incident, hA, posA, rotA, frontNormal);
+            break;
+        }
+        }
+
+        // Clip the incident edge to the side planes
+        ClipVertex clip1[2], clip2[2];
+        if (clipSegmentToLine(clip1, incident, -sideNormal, negSide, negEdge) < 2) return 0;
+        if (clipSegmentToLine(clip2, clip1, sideNormal, posSide, posEdge) < 2) return 0;
+
+        // Keep the points behind the reference face
+        int count = 0;
+        for (int i = 0; i < 2; i++) {
+            float depth = dot(frontNormal, clip2[i].v) - front;
+            if (depth > 0.0f) continue;
+
+            Contact& c = contacts[count++];
+            c = Contact();
+            c.separation = depth;
+            c.normal = normal;
+            c.position = clip2[i].v - frontNormal * depth;   // on the reference face
+            c.feature = clip2[i].fp;
+            if (axis == FACE_B_X || axis == FACE_B_Y) {
+                std::swap(c.feature.inEdge1, c.feature.inEdge2);
+                std::swap(c.feature.outEdge1, c.feature.outEdge2);
+            }
+        }
+        return count;
+    }
+};
+
+#endif // RIGID_WORLD_H
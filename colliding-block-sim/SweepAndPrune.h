@@ -0,0 +1,192 @@
+#ifndef SWEEP_AND_PRUNE_H
+#define SWEEP_AND_PRUNE_H
+
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include "ThreadPool.h"
+
+/*
+Sweep-and-prune broadphase over axis-aligned boxes.
+
+A single sorted axis stops pruning once lots of boxes share the same x
+range (a 2D gas of 100k blocks has ~100 in any thin vertical slab). So
+the world is cut into horizontal bands at least as tall as the tallest
+box, and each band keeps its boxes sorted by min x. A box can then only
+touch boxes in its own band or the one below, and each band is swept
+against itself and its neighbour.
+
+Bodies move a little each tick, so the order from the last call is
+nearly right: boxes are regrouped by band keeping that order, and an
+insertion sort fixes each band in close to O(n). Bands don't share any
+state, so with a thread pool they are sorted and swept in parallel and
+their pairs joined up in band order.
+*/
+
+class SweepAndPrune {
+public:
+    std::vector<int> order;   // box indices by (band, min x), kept between calls
+    float bandHeight;
+
+    SweepAndPrune() {
+        bandHeight = 0.0f;
+        origin = 0.0f;
+    }
+
+    // Forget the order and band height, for a new set of boxes
+    void reset() {
+        order.clear();
+        bandHeight = 0.0f;
+    }
+
+    // Fills pairs (i < j) whose boxes overlap. Boxes are given as
+    // structure-of-arrays bounds.
+    void findPairs(const std::vector<float>& minX, const std::vector<float>& maxX,
+                   const std::vector<float>& minY, const std::vector<float>& maxY,
+                   std::vector<std::pair<int, int>>& pairs, ThreadPool* pool = nullptr) {
+        int n = (int)minX.size();
+        pairs.clear();
+        if (n == 0) return;
+
+        // Bands are resized only when the tallest box outgrows them or
+        // drops well under them (one tick of much taller boxes shouldn't
+        // leave the bands too coarse for good), so keys stay stable
+        // between most calls
+        float tallest = 0.0f;
+        float top = minY[0];
+        for (int i = 0; i < n; i++) {
+            tallest = std::max(tallest, maxY[i] - minY[i]);
+            top = std::min(top, minY[i]);
+        }
+        bool fresh = (int)order.size() != n || tallest > bandHeight || tallest * 4.0f < bandHeight;
+        if (fresh) {
+            bandHeight = tallest * 1.25f + 1e-3f;
+            // Relative to a fixed origin so a band's key doesn't drift
+            origin = top - bandHeight;
+            order.resize(n);
+            std::iota(order.begin(), order.end(), 0);
+        }
+
+        band.resize(n);
+        int lowest = (int)std::floor((top - origin) / bandHeight);
+        int highest = lowest;
+        for (int i = 0; i < n; i++) {
+            band[i] = (int)std::floor((minY[i] - origin) / bandHeight);
+            highest = std::max(highest, band[i]);
+        }
+        int bands = highest - lowest + 1;
+
+        // Regroup by band, keeping last call's order within each
+        bandStart.assign(bands + 1, 0);
+        for (int i = 0; i < n; i++) bandStart[band[i] - lowest + 1]++;
+        for (int b = 0; b < bands; b++) bandStart[b + 1] += bandStart[b];
+        grouped.resize(n);
+        fill.assign(bandStart.begin(), bandStart.end() - 1);
+        for (int k = 0; k < n; k++) {
+            int id = order[k];
+            grouped[fill[band[id] - lowest]++] = id;
+        }
+        order.swap(grouped);
+
+        // Sort and sweep each band against itself and the band below
+        bandPairs.resize(bands);
+        auto work = [&](int begin, int end, int) {
+            for (int b = begin; b < end; b++) {
+                sortBand(bandStart[b], bandStart[b + 1], minX, fresh);
+            }
+        };
+        auto sweep = [&](int begin, int end, int) {
+            for (int b = begin; b < end; b++) {
+                std::vector<std::pair<int, int>>& out = bandPairs[b];
+                out.clear();
+                sweepBand(bandStart[b], bandStart[b + 1], minX, maxX, minY, maxY, out);
+                if (b + 1 < bands) {
+                    sweepBands(bandStart[b], bandStart[b + 1], bandStart[b + 1], bandStart[b + 2],
+                               minX, maxX, minY, maxY, out);
+                }
+            }
+        };
+        if (pool) {
+            pool->parallelFor(bands, 16, work);
+            pool->parallelFor(bands, 16, sweep);
+        } else {
+            work(0, bands, 0);
+            sweep(0, bands, 0);
+        }
+
+        for (const std::vector<std::pair<int, int>>& out : bandPairs) {
+            pairs.insert(pairs.end(), out.begin(), out.end());
+        }
+    }
+
+private:
+    std::vector<int> band;
+    std::vector<int> bandStart, fill, grouped;
+    std::vector<std::vector<std::pair<int, int>>> bandPairs;
+    float origin;
+
+    void sortBand(int start, int end, const std::vector<float>& minX, bool fresh) {
+        if (fresh) {
+            std::sort(order.begin() + start, order.begin() + end,
+                      [&](int a, int b) { return minX[a] < minX[b]; });
+            return;
+        }
+        for (int k = start + 1; k < end; k++) {
+            int id = order[k];
+            float value = minX[id];
+            int m = k;
+            while (m > start && minX[order[m - 1]] > value) {
+                order[m] = order[m - 1];
+                m--;
+            }
+            order[m] = id;
+        }
+    }
+
+    static void addPair(int i, int j, std::vector<std::pair<int, int>>& pairs) {
+        pairs.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+    }
+
+    void sweepBand(int start, int end,
+                   const std::vector<float>& minX, const std::vector<float>& maxX,
+                   const std::vector<float>& minY, const std::vector<float>& maxY,
+                   std::vector<std::pair<int, int>>& pairs) const {
+        for (int k = start; k < end; k++) {
+            int i = order[k];
+            for (int m = k + 1; m < end; m++) {
+                int j = order[m];
+                if (minX[j] > maxX[i]) break;
+                if (minY[i] > maxY[j] || minY[j] > maxY[i]) continue;
+                addPair(i, j, pairs);
+            }
+        }
+    }
+
+    // Two sorted runs merged on min x: each box is checked against the
+    // boxes of the other run that start inside it.
+    void sweepBands(int a, int aEnd, int b, int bEnd,
+                    const std::vector<float>& minX, const std::vector<float>& maxX,
+                    const std::vector<float>& minY, const std::vector<float>& maxY,
+                    std::vector<std::pair<int, int>>& pairs) const {
+        while (a < aEnd && b < bEnd) {
+            int i = order[a];
+            int j = order[b];
+            bool fromA = minX[i] <= minX[j];
+            int box = fromA ? i : j;
+            int k = fromA ? b : a;
+            int kEnd = fromA ? bEnd : aEnd;
+            for (; k < kEnd; k++) {
+                int other = order[k];
+                if (minX[other] > maxX[box]) break;
+                if (minY[box] > maxY[other] || minY[other] > maxY[box]) continue;
+                addPair(box, other, pairs);
+            }
+            if (fromA) a++;
+            else b++;
+        }
+    }
+};
+
+#endif // SWEEP_AND_PRUNE_H
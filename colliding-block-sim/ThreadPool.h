@@ -0,0 +1,112 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed pool of worker threads for splitting a loop across cores.
+
+parallelFor hands out [begin, end) chunks from a shared counter until the
+range is used up and returns once every chunk is done. The calling thread
+works too, as worker 0, so a pool of 1 runs everything inline and never
+starts a thread.
+*/
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) {
+        for (int i = 1; i < std::max(1, threads); i++) {
+            workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return (int)workers.size() + 1;
+    }
+
+    // fn(begin, end, worker) is called for chunks covering [0, count).
+    // worker is in [0, size()) so callers can keep scratch space per thread.
+    void parallelFor(int count, int chunk, const std::function<void(int, int, int)>& fn) {
+        if (count <= 0) return;
+        if (workers.empty() || count <= chunk) {
+            fn(0, count, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            jobChunk = std::max(1, chunk);
+            next = 0;
+            busy = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runChunks(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Current job, set under the mutex
+    const std::function<void(int, int, int)>* job = nullptr;
+    int jobCount = 0;
+    int jobChunk = 1;
+    std::atomic<int> next{0};
+    int busy = 0;
+    int generation = 0;
+    bool stopping = false;
+
+    void runChunks(int worker) {
+        int begin;
+        while ((begin = next.fetch_add(jobChunk)) < jobCount) {
+            (*job)(begin, std::min(begin + jobChunk, jobCount), worker);
+        }
+    }
+
+    void workerLoop(int worker) {
+        int seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            runChunks(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,42 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <vector>
+#include <numeric>
+#include <utility>
+
+/*
+Disjoint sets over 0..n-1, with union by size and path halving.
+*/
+
+class UnionFind {
+public:
+    void reset(int n) {
+        parent.resize(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        size.assign(n, 1);
+    }
+
+    int find(int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+
+private:
+    std::vector<int> parent;
+    std::vector<int> size;
+};
+
+#endif // UNION_FIND_H
@@ -0,0 +1,297 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "BlockWorld.h"
+
+/*
+Headless batch runner for BlockWorld.
+
+Loads block setups from a config file, runs them across all cores, and
+checks each one conserves what it should:
+  - kinetic energy, since every collision is elastic
+  - momentum, once the impulse the walls have put in is taken off
+
+It prints the largest drift seen over the run (relative to the starting
+value) and flags runs over the tolerance. It also flags any two blocks
+found overlapping after a step, which is what a missed impact leaves
+behind.
+
+Config format, one item per line, # starts a comment:
+
+  run <name> <width> <height> <seconds> <dt>
+  block <x> <y> <w> <h> <mass> <vx> [vy]
+  gas <count> <size> <speed> <seed>
+
+block and gas lines add to the most recent run. gas scatters count
+blocks of the given size on a grid with random velocities up to speed.
+*/
+
+struct BlockSpec {
+    float x, y, w, h, mass, vx, vy;
+};
+
+struct RunConfig {
+    std::string name;
+    float width, height;
+    float duration;
+    float dt;
+    std::vector<BlockSpec> blocks;
+};
+
+struct RunResult {
+    long long collisions;   // block-block
+    long long wallHits;
+    double finalEnergy;
+    double maxEnergyDrift;
+    double maxMomentumDrift;
+    double maxOverlap;   // px, deepest two blocks ever went into each other
+    double seconds;
+    bool flagged;
+    std::vector<BlockSpec> finalState;
+};
+
+// Lays blocks out on a grid so none start overlapping
+void addGas(RunConfig& run, int count, float size, float speed, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> velocity(-speed, speed);
+    std::uniform_real_distribution<float> mass(1.0f, 4.0f);
+
+    float spacing = size * 2.0f;
+    int columns = std::max(1, (int)(run.width / spacing));
+    for (int i = 0; i < count; i++) {
+        BlockSpec b;
+        b.x = (i % columns) * spacing + size / 2;
+        b.y = (i / columns) * spacing + size / 2;
+        b.w = size;
+        b.h = size;
+        b.mass = mass(rng);
+        b.vx = velocity(rng);
+        b.vy = velocity(rng);
+        run.blocks.push_back(b);
+    }
+}
+
+bool loadConfigs(const std::string& filename, std::vector<RunConfig>& runs) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Could not open " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream in(line);
+        std::string kind;
+        if (!(in >> kind)) continue;
+
+        bool ok = true;
+        if (kind == "run") {
+            RunConfig run;
+            ok = (bool)(in >> run.name >> run.width >> run.height >> run.duration >> run.dt);
+            if (ok) runs.push_back(run);
+        } else if (kind == "block" && !runs.empty()) {
+            BlockSpec b;
+            b.vy = 0.0f;
+            ok = (bool)(in >> b.x >> b.y >> b.w >> b.h >> b.mass >> b.vx);
+            in >> b.vy;
+            if (ok) runs.back().blocks.push_back(b);
+        } else if (kind == "gas" && !runs.empty()) {
+            int count;
+            float size, speed;
+            unsigned seed;
+            ok = (bool)(in >> count >> size >> speed >> seed);
+            if (ok) addGas(runs.back(), count, size, speed, seed);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << filename << ":" << lineNumber << ": can't read \"" << line << "\"" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Deepest overlap between any two blocks, by a sweep along x
+float deepestOverlap(const BlockWorld& world, std::vector<int>& order) {
+    order.resize(world.size());
+    for (int i = 0; i < world.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return world.x[a] < world.x[b]; });
+
+    float deepest = 0.0f;
+    for (size_t k = 0; k < order.size(); k++) {
+        int i = order[k];
+        for (size_t m = k + 1; m < order.size(); m++) {
+            int j = order[m];
+            float overlapX = world.x[i] + world.w[i] - world.x[j];
+            if (overlapX <= 0.0f) break;
+            float overlapY = std::min(world.y[i] + world.h[i], world.y[j] + world.h[j]) - std::max(world.y[i], world.y[j]);
+            float overlap = std::min(std::min(overlapX, world.w[j]), overlapY);
+            deepest = std::max(deepest, overlap);
+        }
+    }
+    return deepest;
+}
+
+RunResult simulate(const RunConfig& config, double tolerance, float overlapTolerance) {
+    auto start = std::chrono::steady_clock::now();
+
+    BlockWorld world(config.width, config.height);
+    for (const BlockSpec& b : config.blocks) {
+        world.addBlock(b.x, b.y, b.w, b.h, b.mass, b.vx, b.vy);
+    }
+
+    // Sums in double so the check measures the solver, not the check
+    double energy0 = 0.0, px0 = 0.0, py0 = 0.0, momentumScale = 0.0;
+    for (int i = 0; i < world.size(); i++) {
+        energy0 += 0.5 * world.mass[i] * ((double)world.vx[i] * world.vx[i] + (double)world.vy[i] * world.vy[i]);
+        px0 += world.mass[i] * world.vx[i];
+        py0 += world.mass[i] * world.vy[i];
+        momentumScale += world.mass[i] * std::hypot(world.vx[i], world.vy[i]);
+    }
+
+    RunResult result;
+    result.maxEnergyDrift = 0.0;
+    result.maxMomentumDrift = 0.0;
+    result.maxOverlap = 0.0;
+    std::vector<int> order;
+
+    int steps = (int)std::ceil(config.duration / config.dt);
+    for (int s = 0; s < steps; s++) {
+        world.step(config.dt);
+
+        double energy = 0.0, px = 0.0, py = 0.0;
+        for (int i = 0; i < world.size(); i++) {
+            energy += 0.5 * world.mass[i] * ((double)world.vx[i] * world.vx[i] + (double)world.vy[i] * world.vy[i]);
+            px += world.mass[i] * world.vx[i];
+            py += world.mass[i] * world.vy[i];
+        }
+        px -= world.wallImpulseX;
+        py -= world.wallImpulseY;
+
+        if (energy0 > 0.0) {
+            result.maxEnergyDrift = std::max(result.maxEnergyDrift, std::fabs(energy - energy0) / energy0);
+        }
+        if (momentumScale > 0.0) {
+            double drift = std::hypot(px - px0, py - py0) / momentumScale;
+            result.maxMomentumDrift = std::max(result.maxMomentumDrift, drift);
+        }
+        result.finalEnergy = energy;
+        result.maxOverlap = std::max(result.maxOverlap, (double)deepestOverlap(world, order));
+    }
+    if (steps == 0) result.finalEnergy = energy0;
+
+    result.collisions = world.totalCollisions;
+    result.wallHits = world.totalWallHits;
+    result.flagged = result.maxEnergyDrift > tolerance || result.maxMomentumDrift > tolerance ||
+                     result.maxOverlap > overlapTolerance;
+    for (int i = 0; i < world.size(); i++) {
+        BlockSpec b = {world.x[i], world.y[i], world.w[i], world.h[i], world.mass[i], world.vx[i], world.vy[i]};
+        result.finalState.push_back(b);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: batch <config file> [--tolerance t] [--overlap px] [--threads n] [--state]" << std::endl;
+        return 2;
+    }
+
+    std::string filename = argv[1];
+    double tolerance = 1e-4;
+    float overlapTolerance = 0.01f;
+    int threadCount = (int)std::thread::hardware_concurrency();
+    bool printState = false;
+    for (int a = 2; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--tolerance" && a + 1 < argc) tolerance = std::atof(argv[++a]);
+        else if (arg == "--overlap" && a + 1 < argc) overlapTolerance = (float)std::atof(argv[++a]);
+        else if (arg == "--threads" && a + 1 < argc) threadCount = std::atoi(argv[++a]);
+        else if (arg == "--state") printState = true;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+    threadCount = std::max(1, threadCount);
+
+    std::vector<RunConfig> runs;
+    if (!loadConfigs(filename, runs)) return 2;
+
+    // Workers take the next run off a shared counter. Results go in the
+    // run's own slot so the report comes out in file order.
+    std::vector<RunResult> results(runs.size());
+    std::atomic<size_t> next(0);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            size_t i;
+            while ((i = next++) < runs.size()) {
+                results[i] = simulate(runs[i], tolerance, overlapTolerance);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << std::left << std::setw(20) << "run" << std::right
+              << std::setw(8) << "blocks" << std::setw(12) << "collisions" << std::setw(11) << "wall hits"
+              << std::setw(14) << "final energy" << std::setw(13) << "energy drift"
+              << std::setw(15) << "momentum drift" << std::setw(10) << "overlap" << std::endl;
+
+    int flagged = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const RunResult& r = results[i];
+        if (r.flagged) flagged++;
+
+        std::cout << std::left << std::setw(20) << runs[i].name << std::right
+                  << std::setw(8) << runs[i].blocks.size()
+                  << std::setw(12) << r.collisions
+                  << std::setw(11) << r.wallHits
+                  << std::setw(14) << std::fixed << std::setprecision(2) << r.finalEnergy
+                  << std::setw(13) << std::scientific << std::setprecision(2) << r.maxEnergyDrift
+                  << std::setw(15) << r.maxMomentumDrift
+                  << std::setw(10) << std::fixed << std::setprecision(3) << r.maxOverlap
+                  << (r.maxEnergyDrift > tolerance || r.maxMomentumDrift > tolerance ? "  DRIFT" : "")
+                  << (r.maxOverlap > overlapTolerance ? "  OVERLAP" : "") << std::endl;
+
+        if (printState) {
+            std::cout << std::fixed << std::setprecision(3);
+            for (const BlockSpec& b : r.finalState) {
+                std::cout << "    block " << b.x << " " << b.y << " " << b.w << " " << b.h << " "
+                          << b.mass << " " << b.vx << " " << b.vy << std::endl;
+            }
+        }
+    }
+
+    std::cout << std::defaultfloat << std::setprecision(3)
+              << runs.size() << " runs, " << flagged << " flagged (drift over " << tolerance
+              << " or overlap over " << overlapTolerance << " px)"
+              << ", " << seconds << " s on " << threadCount << " threads" << std::endl;
+
+    return flagged > 0 ? 1 : 0;
+}
@@ -2,84 +2,68 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <thread>
+#include "BlockWorld.h"
+#include "BlockRenderer.h"
+#include "EventSolver.h"
+
+const float WORLD_WIDTH = 800.0f;
+const float WORLD_HEIGHT = 600.0f;
+const int GAS_BLOCKS = 2000;
+const int BIG_GAS_BLOCKS = 50000;
+
+// The original setup: two blocks sliding along the ground
+void loadTwoBlocks(BlockWorld& world, std::vector<sf::Color>& colors) {
+    world.clear();
+    colors.clear();
+    world.addBlock(100, 250, 80, 100, 2.0f, 150.0f);
+    colors.push_back(sf::Color(49, 130, 206));
+    world.addBlock(600, 250, 80, 100, 1.0f, -100.0f);
+    colors.push_back(sf::Color(229, 62, 62));
+}
 
-class Block {
-    public: 
-        float x, y;
-        float width, height;
-        float vx, vy;
-        float mass;
-        sf::Color color;
-
-    Block(float px, float py, float w, float h, float m, float velx, sf::Color c) {
-        x = px; y = py;
-        width = w; height = h;
-        mass = m;
-        vx = velx; vy = 0;
-        color = c;
-    }
-
-    void update(float dt) {
-        x += vx * dt;
-        y += vy * dt;
+// A box of small blocks flying about in 2D
+void loadGas(BlockWorld& world, std::vector<sf::Color>& colors, int count) {
+    world.clear();
+    colors.clear();
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> speed(-120.0f, 120.0f);
+
+    int columns = (int)std::ceil(std::sqrt(count * WORLD_WIDTH / WORLD_HEIGHT));
+    float spacing = WORLD_WIDTH / columns;
+    float size = spacing * 0.5f;
+    for (int i = 0; i < count; i++) {
+        float px = (i % columns) * spacing + size / 2;
+        float py = (i / columns) * spacing + size / 2;
+        float mass = 1.0f + (i % 3);
+        world.addBlock(px, py, size, size, mass, speed(rng), speed(rng));
+        colors.push_back(sf::Color(60 + 60 * (i % 3), 130, 206 - 60 * (i % 3)));
     }
+}
 
-    void draw(sf::RenderWindow& window) {
-        sf::RectangleShape rect(sf::Vector2f(width, height));
-        rect.setPosition(x, y);
-        rect.setFillColor(color);
-        rect.setOutlineThickness(2);
-        rect.setOutlineColor(sf::Color::Black);
-        window.draw(rect);
-
-        //draw velocity arrows
-        if (vx != 0) {
-            sf::Vertex line[] = {
-                sf::Vertex(sf::Vector2f(x + width / 2, y + height / 2)),
-                sf::Vertex(sf::Vector2f(x + width / 2 + vx + .5f, y + height/2))
-            };
-            line[0].color = color;
-            line[1].color = color;
-            window.draw(line, 2, sf::Lines);
-        }
+// EventSolver only does motion along x
+bool isOneDimensional(const BlockWorld& world) {
+    for (int i = 0; i < world.size(); i++) {
+        if (world.vy[i] != 0.0f) return false;
     }
+    return true;
+}
 
-    bool collidesWith(Block& other) {
-        return (x < other.x + other.width && 
-                x + width > other.x &&
-                y < other.y + other.height &&
-                y + height > other.y);
+void loadSolver(EventSolver& solver, const BlockWorld& world) {
+    solver.clear();
+    for (int i = 0; i < world.size(); i++) {
+        solver.addBlock(world.x[i], world.y[i], world.w[i], world.h[i], world.mass[i], world.vx[i]);
     }
-
-    void bounceOffWalls(float windowWidth){
-        if (x <= 0 || x + width > windowWidth) {
-            vx *= -1;
-            x = (x <= 0) ? 0 : windowWidth - width;
-        }
-    }  
-};
-
-void handleCollision(Block& b1, Block& b2) {
-    float m1 = b1.mass;
-    float m2 = b2.mass;
-    float v1 = b1.vx;
-    float v2 = b2.vx;
-
-    // Elastic collision formulas
-    b1.vx = ((m1 - m2) * v1 + 2 * m2 * v2) / (m1 + m2);
-    b2.vx = ((m1 - m2) * v2 + 2 * m1 * v1) / (m1 + m2);
-
-    // Separate blocks to prevent overlap
-    float overlap = (b1.x + b1.width) - b2.x;
-    b1.x -= overlap / 2;
-    b2.x += overlap / 2;
 }
 
 int main() {
         // Create window
-    sf::RenderWindow window(sf::VideoMode(800, 600), "2D Block Collision Simulator");
+    sf::RenderWindow window(sf::VideoMode(WORLD_WIDTH, WORLD_HEIGHT), "2D Block Collision Simulator");
     window.setFramerateLimit(60);
-    
+
     // Load font for text
     sf::Font font;
     if (!font.loadFromFile("/System/Library/Fonts/Helvetica.ttc")) {
@@ -93,12 +77,56 @@ int main() {
     }
 
     // Create blocks
-    Block block1(100, 250, 80, 100, 2.0f, 150.0f, sf::Color(49, 130, 206));
-    Block block2(600, 250, 80, 100, 1.0f, -100.0f, sf::Color(229, 62, 62));
+    BlockWorld world(WORLD_WIDTH, WORLD_HEIGHT);
+    world.setThreads(std::thread::hardware_concurrency());
+    std::vector<sf::Color> colors;
+    int scene = 1;
+    loadTwoBlocks(world, colors);
+
+    BlockRenderer renderer;
+
+    // Event-driven mode: exact impacts, no tunnelling. Only for blocks
+    // moving along x; E switches to stepping the world by the frame dt.
+    EventSolver solver(WORLD_WIDTH);
+    bool eventMode = true;
+    loadSolver(solver, world);
+
+    // HUD is built once; strings are only reformatted when what they show
+    // changes
+    HudText block1Text, block2Text, statsText, energyText, instructions;
+    for (HudText* hud : {&block1Text, &block2Text, &statsText, &energyText, &instructions}) {
+        hud->text.setFont(font);
+        hud->text.setCharacterSize(18);
+        hud->text.setFillColor(sf::Color::Black);
+    }
+    block1Text.text.setPosition(10, 10);
+    block2Text.text.setPosition(10, 120);
+    statsText.text.setPosition(10, 10);
+    instructions.text.setCharacterSize(16);
+    instructions.text.setPosition(10, 575);
+
+    sf::Text collisionText;
+    collisionText.setFont(font);
+    collisionText.setCharacterSize(30);
+    collisionText.setFillColor(sf::Color::Red);
+    collisionText.setString("COLLISION!");
+    collisionText.setPosition(300, 50);
+
+    sf::RectangleShape ground(sf::Vector2f(WORLD_WIDTH, 2));
+    ground.setPosition(0, 350);
+    ground.setFillColor(sf::Color(150, 150, 150));
+
+    sf::RectangleShape statsBg(sf::Vector2f(270, 150));
+    statsBg.setPosition(5, 5);
+    statsBg.setFillColor(sf::Color(240, 240, 240, 200));
 
-    bool collisionHappened = false;
     sf::Clock clock;
     sf::Clock collisionTimer;
+    sf::Clock stepTimer;
+    sf::Clock statsTimer;
+    float stepMs = 0.0f;
+    float fps = 0.0f;
+    int frames = 0;
     bool showCollisionText = false;
     bool showEnergyText = true;
 
@@ -108,33 +136,76 @@ int main() {
             if (event.type == sf::Event::Closed) {
                 window.close();
             }
-        
-            // Reset on R key
-            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R) {
-                    Block block1(100, 250, 80, 100, 2.0f, 150.0f, sf::Color(49, 130, 206));
-                    Block block2(600, 250, 80, 100, 1.0f, -100.0f, sf::Color(229, 62, 62));
-                    bool collisionHappened = true;
-                    bool showCollisionText = true;
-                    collisionTimer.restart();
+
+            if (event.type != sf::Event::KeyPressed) continue;
+
+            // Reset on R key, 1-3 pick the scene
+            bool reload = false;
+            if (event.key.code == sf::Keyboard::R) reload = true;
+            if (event.key.code == sf::Keyboard::Num1) { scene = 1; reload = true; }
+            if (event.key.code == sf::Keyboard::Num2) { scene = 2; reload = true; }
+            if (event.key.code == sf::Keyboard::Num3) { scene = 3; reload = true; }
+            if (reload) {
+                if (scene == 1) loadTwoBlocks(world, colors);
+                else loadGas(world, colors, (scene == 2) ? GAS_BLOCKS : BIG_GAS_BLOCKS);
+                eventMode = eventMode && isOneDimensional(world);
+                if (eventMode) loadSolver(solver, world);
+                showCollisionText = false;
+                collisionTimer.restart();
+
+                // Outlines and arrows only help while blocks are big
+                renderer.outlines = world.size() <= 100;
+                renderer.arrows = world.size() <= 100;
+            }
+
+            // Velocity arrows on V key
+            if (event.key.code == sf::Keyboard::V) {
+                renderer.arrows = !renderer.arrows;
+            }
+
+            // Toggle event-driven / frame-stepped on E key
+            if (event.key.code == sf::Keyboard::E) {
+                if (!eventMode && !isOneDimensional(world)) {
+                    std::cout << "Event-driven mode only handles blocks moving along x" << std::endl;
+                } else {
+                    eventMode = !eventMode;
+                    // Pick up from wherever frame stepping left the blocks
+                    if (eventMode) loadSolver(solver, world);
+                    std::cout << "Mode: " << (eventMode ? "event-driven" : "frame-stepped") << std::endl;
+                }
             }
         }
 
         // Update physics
         float dt = clock.restart().asSeconds();
-        block1.update(dt);
-        block2.update(dt);
+        long long before;
+        long long after;
+        stepTimer.restart();
+        if (eventMode) {
+            before = solver.collisions;
+            solver.advance(dt);
+            after = solver.collisions;
+            for (int i = 0; i < world.size(); i++) {
+                world.x[i] = solver.x(i);
+                world.vx[i] = solver.vx(i);
+            }
+        } else {
+            before = world.totalCollisions;
+            world.step(dt);
+            after = world.totalCollisions;
+        }
 
-        // Check collision
-        if (block1.collidesWith(block2) && !collisionHappened){
-            handleCollision(block1, block2);
-            collisionHappened = true;
-            showCollisionText = true;
-            collisionTimer.restart();
+        // Timings change every frame, so only refresh them twice a second
+        frames++;
+        if (statsTimer.getElapsedTime().asSeconds() >= 0.5f) {
+            stepMs = stepTimer.getElapsedTime().asSeconds() * 1000.0f;
+            fps = frames / statsTimer.restart().asSeconds();
+            frames = 0;
         }
 
-        // Reset collision flag when blocks separate
-        if (collisionHappened && !block1.collidesWith(block2)) {
-            collisionHappened = false;
+        if (after != before && world.size() <= 2) {
+            showCollisionText = true;
+            collisionTimer.restart();
         }
 
         // Hide collision text after 2 seconds
@@ -142,88 +213,84 @@ int main() {
             showCollisionText = false;
         }
 
-        //Bounce off walls
-        block1.bounceOffWalls(800);
-        block2.bounceOffWalls(800);
-
         // drawing
         window.clear(sf::Color(240, 240, 240));
 
         // draw around line
-        sf::RectangleShape ground(sf::Vector2f(800,2));
-        ground.setPosition(0, 350);
-        ground.setFillColor(sf::Color(150, 150, 150));
-        window.draw(ground);
+        if (scene == 1) {
+            window.draw(ground);
+        }
 
         //Draw Blocks
-        block1.draw(window);
-        block2.draw(window);
+        renderer.update(world, colors);
+        renderer.draw(window);
 
         // Draw text info
-        sf::Text text;
-        text.setFont(font);
-        text.setCharacterSize(18);
-        text.setFillColor(sf::Color::Black);
-
-        // Block 1 info
-        std::stringstream ss1;
-        ss1 << "Block 1 (Blue)\n"
-            << "Position: " << std::fixed << std::setprecision(1) << block1.x << "\n"
-            << "Velocity: " << block1.vx << " px/s\n"
-            << "Mass: " << block1.mass << " kg";
-        text.setString(ss1.str());
-        text.setPosition(10, 10);
-        window.draw(text);
-
-        // Block 2 info
-        std::stringstream ss2;
-        ss2 << "Block 2 (Red)\n"
-            << "Position: " << std::fixed << std::setprecision(1) << block2.x << "\n"
-            << "Velocity: " << block2.vx << " px/s\n"
-            << "Mass: " << block2.mass << " kg";
-        text.setString(ss2.str());
-        text.setPosition(10, 120);
-        window.draw(text);
+        if (scene == 1) {
+            // Block 1 info
+            if (block1Text.changed({std::round(world.x[0] * 10), std::round(world.vx[0] * 10), world.mass[0]})) {
+                std::stringstream ss1;
+                ss1 << "Block 1 (Blue)\n"
+                    << "Position: " << std::fixed << std::setprecision(1) << world.x[0] << "\n"
+                    << "Velocity: " << world.vx[0] << " px/s\n"
+                    << "Mass: " << world.mass[0] << " kg";
+                block1Text.text.setString(ss1.str());
+            }
+            window.draw(block1Text.text);
+
+            // Block 2 info
+            if (block2Text.changed({std::round(world.x[1] * 10), std::round(world.vx[1] * 10), world.mass[1]})) {
+                std::stringstream ss2;
+                ss2 << "Block 2 (Red)\n"
+                    << "Position: " << std::fixed << std::setprecision(1) << world.x[1] << "\n"
+                    << "Velocity: " << world.vx[1] << " px/s\n"
+                    << "Mass: " << world.mass[1] << " kg";
+                block2Text.text.setString(ss2.str());
+            }
+            window.draw(block2Text.text);
+        } else {
+            if (statsText.changed({(double)world.size(), (double)world.totalCollisions,
+                                   (double)world.candidatePairs, (double)world.islandCount, stepMs, fps})) {
+                std::stringstream ss;
+                ss << "Blocks: " << world.size() << "\n"
+                   << "Collisions: " << world.totalCollisions << "\n"
+                   << "Candidate pairs: " << world.candidatePairs << "\n"
+                   << "Islands: " << world.islandCount << " on " << world.threads() << " threads\n"
+                   << "Step: " << std::fixed << std::setprecision(2) << stepMs << " ms\n"
+                   << "FPS: " << std::setprecision(0) << fps;
+                statsText.text.setString(ss.str());
+            }
+            window.draw(statsBg);
+            window.draw(statsText.text);
+        }
 
         // Collision alert
         if (showCollisionText) {
-            sf::Text collisionText;
-            collisionText.setFont(font);
-            collisionText.setCharacterSize(30);
-            collisionText.setFillColor(sf::Color::Red);
-            collisionText.setString("COLLISION!");
-            collisionText.setPosition(300, 50);
             window.draw(collisionText);
         }
 
         if (showEnergyText) {
 
-            // Total system energy
-            sf::Text energyText;
-            energyText.setFont(font);
-            energyText.setCharacterSize(18);
-            energyText.setFillColor(sf::Color::Black);
-            
-            // KE = 1/2mv^2 for each block
-            float block1_energy = .5 * block1.mass * block1.vx * block1.vx;
-            float block2_energy = .5 * block2.mass * block2.vx * block2.vx;
-            float totalEnergy = block1_energy + block2_energy;
-
-            std::stringstream ssEnergy;
-            ssEnergy << "Total System Energy: " << std::fixed << std::setprecision(2) << totalEnergy << " J";
-            energyText.setString(ssEnergy.str());
-            energyText.setString(ssEnergy.str());
-
-            sf::FloatRect textbounds = energyText.getLocalBounds();
-            energyText.setPosition(800 - textbounds.width - 10, 10);
-            window.draw(energyText);
+            // Total system energy, KE = 1/2mv^2 for each block
+            float totalEnergy = world.kineticEnergy();
+
+            if (energyText.changed({std::round(totalEnergy * 100)})) {
+                std::stringstream ssEnergy;
+                ssEnergy << "Total System Energy: " << std::fixed << std::setprecision(2) << totalEnergy << " J";
+                energyText.text.setString(ssEnergy.str());
+
+                sf::FloatRect textbounds = energyText.text.getLocalBounds();
+                energyText.text.setPosition(WORLD_WIDTH - textbounds.width - 10, 10);
+            }
+            window.draw(energyText.text);
 
             // Instructions
-            text.setCharacterSize(16);
-            text.setString("Press R to Reset");
-            text.setPosition(10, 550);
-            window.draw(text);
-            
+            if (instructions.changed({(double)eventMode})) {
+                instructions.text.setString(eventMode ? "R: reset  1-3: scene  V: arrows  E: frame stepping"
+                                                      : "R: reset  1-3: scene  V: arrows  E: event-driven");
+            }
+            window.draw(instructions.text);
+
             window.display();
         }
 
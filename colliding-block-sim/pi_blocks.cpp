@@ -0,0 +1,139 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+/*
+Headless collision counter for the blocks-and-wall setup that computes pi.
+
+A block of mass 1 sits at rest between a wall and a block of mass 100^N
+sliding towards it. Counting every block-block and block-wall collision
+gives the first N+1 digits of pi (3, 31, 314, 3141, ...).
+
+Each collision is stepped analytically (time to contact from positions
+and velocities), same as EventSolver, but the numbers get hard fast: at
+N = 8 there are 3e8 collisions and the mass ratio is 1e16. So:
+
+  - Velocities are kept scaled by sqrt(mass), u = sqrt(m) v1 and
+    w = sqrt(M) v2. Then a block-block collision is a reflection of
+    (u, w) and the wall flips u. Both keep u^2 + w^2 (the energy) fixed,
+    so rounding doesn't build up in one direction.
+  - The reflection is [[-c, s], [s, c]] with c = 1 - d and
+    d = 2m / (m + M). For huge M, c rounds to 1 and the tiny angle it
+    carries is lost, so c*w is worked out as w - d*w instead.
+  - Everything is long double.
+
+The count is checked against the closed form ceil(pi / theta) - 1 with
+theta = atan(sqrt(m / M)), and against the digits of pi.
+*/
+
+const std::string PI_DIGITS = "31415926535897932384";
+
+struct PiResult {
+    long long collisions;
+    long long wallHits;
+    long double lastCollisionTime;
+    long double energyError;    // relative
+    double seconds;
+};
+
+PiResult countCollisions(int digits) {
+    const long double m = 1.0L;
+    const long double M = powl(100.0L, digits - 1);
+    const long double rootM = sqrtl(M);
+    const long double d = 2.0L * m / (m + M);               // 1 - c
+    const long double s = 2.0L * sqrtl(m * M) / (m + M);
+
+    // Small block at x1, big block at x2, wall at 0. Blocks are points;
+    // their widths only shift where things happen, not how often.
+    long double x1 = 1.0L;
+    long double x2 = 2.0L;
+    long double u = 0.0L;                // sqrt(m) * v1
+    long double w = -1.0L * rootM;       // sqrt(M) * v2, 1 unit/s left
+    long double t = 0.0L;
+    long double energy = u * u + w * w;
+
+    PiResult result;
+    result.collisions = 0;
+    result.wallHits = 0;
+    result.lastCollisionTime = 0.0L;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Collisions alternate: they separate after hitting each other, so
+    // the next one can only be the small block off the wall, and after
+    // the wall the only thing it can hit is the big block.
+    while (true) {
+        long double v1 = u;              // m = 1
+        long double v2 = w / rootM;
+
+        // Block-block, if the small one is catching up
+        if (v1 <= v2) break;
+        long double dt = std::max(0.0L, (x2 - x1) / (v1 - v2));
+        t += dt;
+        x1 += v1 * dt;
+        x2 += v2 * dt;
+        x2 = std::max(x2, x1);
+        long double newU = -u + d * u + s * w;
+        long double newW = s * u + w - d * w;
+        u = newU;
+        w = newW;
+        result.collisions++;
+
+        // Wall, if the small one is heading for it
+        if (u >= 0.0L) break;
+        dt = x1 / -u;
+        t += dt;
+        x1 = 0.0L;
+        x2 += (w / rootM) * dt;
+        u = -u;
+        result.collisions++;
+        result.wallHits++;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.lastCollisionTime = t;
+    result.energyError = fabsl(u * u + w * w - energy) / energy;
+    return result;
+}
+
+long long closedFormCount(int digits) {
+    long double theta = atanl(sqrtl(1.0L / powl(100.0L, digits - 1)));
+    return (long long)ceill(3.14159265358979323846264338327950288L / theta) - 1;
+}
+
+int main(int argc, char* argv[]) {
+    // pi_blocks [maxDigits] [minDigits]
+    int maxDigits = (argc > 1) ? std::atoi(argv[1]) : 8;
+    int minDigits = (argc > 2) ? std::atoi(argv[2]) : 1;
+    if (maxDigits > (int)PI_DIGITS.size()) maxDigits = (int)PI_DIGITS.size();
+
+    std::cout << std::setw(7) << "digits" << std::setw(14) << "mass ratio"
+              << std::setw(13) << "collisions" << std::setw(10) << "seconds"
+              << std::setw(14) << "collisions/s" << std::setw(12) << "energy err"
+              << "  check" << std::endl;
+
+    bool allOk = true;
+    for (int digits = minDigits; digits <= maxDigits; digits++) {
+        PiResult r = countCollisions(digits);
+
+        long long expected = std::stoll(PI_DIGITS.substr(0, digits));
+        bool ok = (r.collisions == expected) && (r.collisions == closedFormCount(digits));
+        allOk = allOk && ok;
+
+        double rate = (r.seconds > 0.0) ? r.collisions / r.seconds : 0.0;
+        std::cout << std::setw(7) << digits
+                  << std::setw(14) << std::scientific << std::setprecision(0) << (double)powl(100.0L, digits - 1)
+                  << std::setw(13) << r.collisions
+                  << std::setw(10) << std::fixed << std::setprecision(3) << r.seconds
+                  << std::setw(14) << std::scientific << std::setprecision(3) << rate
+                  << std::setw(12) << std::setprecision(1) << (double)r.energyError
+                  << "  " << (ok ? "OK" : "MISMATCH (expected " + std::to_string(expected) + ")")
+                  << std::endl;
+    }
+
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "RigidWorld.h"
+#include "BlockRenderer.h"
+
+const float WORLD_WIDTH = 800.0f;
+const float WORLD_HEIGHT = 600.0f;
+const float TIME_STEP = 1.0f / 60.0f;
+const int PILE_BOXES = 300;
+
+// Floor and side walls
+void addWalls(RigidWorld& world, std::vector<sf::Color>& colors) {
+    world.addBody(RigidBody(WORLD_WIDTH / 2, WORLD_HEIGHT - 10, WORLD_WIDTH, 20, 0.0f));
+    world.addBody(RigidBody(5, WORLD_HEIGHT / 2, 10, WORLD_HEIGHT, 0.0f));
+    world.addBody(RigidBody(WORLD_WIDTH - 5, WORLD_HEIGHT / 2, 10, WORLD_HEIGHT, 0.0f));
+    colors.resize(world.size(), sf::Color(150, 150, 150));
+}
+
+sf::Color boxColor(int i) {
+    return sf::Color(60 + 60 * (i % 3), 130, 206 - 60 * (i % 3));
+}
+
+// Rows of boxes, each one shorter than the one below
+void loadPyramid(RigidWorld& world, std::vector<sf::Color>& colors) {
+    world.clear();
+    colors.clear();
+    addWalls(world, colors);
+
+    const int base = 15;
+    const float size = 30.0f;
+    float floor = WORLD_HEIGHT - 20;
+    for (int row = 0; row < base; row++) {
+        float left = WORLD_WIDTH / 2 - (base - row - 1) * size * 0.5f;
+        for (int i = 0; i < base - row; i++) {
+            world.addBody(RigidBody(left + i * size, floor - size / 2 - row * size, size, size, 1.0f));
+            colors.push_back(boxColor(row));
+        }
+    }
+}
+
+// One column of boxes, the hardest case for the solver
+void loadTower(RigidWorld& world, std::vector<sf::Color>& colors) {
+    world.clear();
+    colors.clear();
+    addWalls(world, colors);
+
+    const int height = 10;
+    const float size = 40.0f;
+    float floor = WORLD_HEIGHT - 20;
+    for (int i = 0; i < height; i++) {
+        world.addBody(RigidBody(WORLD_WIDTH / 2, floor - size / 2 - i * size, size, size, 1.0f));
+        colors.push_back(boxColor(i));
+    }
+}
+
+// Boxes of mixed sizes dropped at random angles
+void loadPile(RigidWorld& world, std::vector<sf::Color>& colors) {
+    world.clear();
+    colors.clear();
+    addWalls(world, colors);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> side(10.0f, 30.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 3.14159f);
+    int columns = 20;
+    float spacing = (WORLD_WIDTH - 40) / columns;
+    for (int i = 0; i < PILE_BOXES; i++) {
+        float w = side(rng), h = side(rng);
+        RigidBody box(30 + spacing / 2 + (i % columns) * spacing, 40 + (i / columns) * spacing * 0.8f,
+                      w, h, w * h / 400.0f, angle(rng));
+        box.restitution = 0.2f;
+        world.addBody(box);
+        colors.push_back(boxColor(i));
+    }
+}
+
+void loadScene(int scene, RigidWorld& world, std::vector<sf::Color>& colors) {
+    if (scene == 1) loadPyramid(world, colors);
+    else if (scene == 2) loadTower(world, colors);
+    else loadPile(world, colors);
+}
+
+int main() {
+    // Create window
+    sf::RenderWindow window(sf::VideoMode(WORLD_WIDTH, WORLD_HEIGHT), "2D Rigid Block Simulator");
+    window.setFramerateLimit(60);
+
+    // Load font for text
+    sf::Font font;
+    if (!font.loadFromFile("/System/Library/Fonts/Helvetica.ttc")) {
+        // Try Windows font path
+        if (!font.loadFromFile("C:\\Windows\\Fonts\\arial.ttf")) {
+            // Try Linux font path
+            if (!font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf")) {
+                std::cout << "Warning: Could not load font. Text will not display." << std::endl;
+            }
+        }
+    }
+
+    RigidWorld world;
+    std::vector<sf::Color> colors;
+    int scene = 1;
+    loadScene(scene, world, colors);
+
+    BlockRenderer renderer;
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dropX(60.0f, WORLD_WIDTH - 60.0f);
+
+    HudText statsText, instructions;
+    for (HudText* hud : {&statsText, &instructions}) {
+        hud->text.setFont(font);
+        hud->text.setCharacterSize(18);
+        hud->text.setFillColor(sf::Color::Black);
+    }
+    statsText.text.setPosition(20, 10);
+    instructions.text.setCharacterSize(16);
+    instructions.text.setPosition(20, 555);
+    instructions.text.setString("R: reset  1-3: scene  W: warm start  S: sleep  Space: drop  Click: push");
+
+    sf::RectangleShape statsBg(sf::Vector2f(250, 170));
+    statsBg.setPosition(15, 5);
+    statsBg.setFillColor(sf::Color(240, 240, 240, 200));
+
+    // Fixed step so the solver sees the same dt every time; frames that
+    // run long take more than one step
+    sf::Clock clock;
+    sf::Clock statsTimer;
+    float accumulator = 0.0f;
+    float solveMs = 0.0f, stepMs = 0.0f, iterations = 0.0f;
+    float solveSum = 0.0f, stepSum = 0.0f, iterationSum = 0.0f;
+    int steps = 0;
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                window.close();
+            }
+
+            // Clicking a box knocks it upwards, waking its island
+            if (event.type == sf::Event::MouseButtonPressed) {
+                Vec2 point((float)event.mouseButton.x, (float)event.mouseButton.y);
+                int hit = world.findBody(point);
+                if (hit >= 0) {
+                    world.applyImpulse(hit, Vec2(0.0f, -300.0f * world.bodies[hit].mass), point);
+                }
+            }
+
+            if (event.type != sf::Event::KeyPressed) continue;
+
+            // Reset on R key, 1-3 pick the scene
+            bool reload = false;
+            if (event.key.code == sf::Keyboard::R) reload = true;
+            if (event.key.code == sf::Keyboard::Num1) { scene = 1; reload = true; }
+            if (event.key.code == sf::Keyboard::Num2) { scene = 2; reload = true; }
+            if (event.key.code == sf::Keyboard::Num3) { scene = 3; reload = true; }
+            if (reload) {
+                loadScene(scene, world, colors);
+                renderer.outlines = world.size() <= 150;
+            }
+
+            // Warm starting on W key
+            if (event.key.code == sf::Keyboard::W) {
+                world.warmStarting = !world.warmStarting;
+                std::cout << "Warm starting: " << (world.warmStarting ? "on" : "off") << std::endl;
+            }
+
+            // Sleeping on S
+            if (event.key.code == sf::Keyboard::S) {
+                world.sleeping = !world.sleeping;
+                std::cout << "Sleeping: " << (world.sleeping ? "on" : "off") << std::endl;
+            }
+
+            // Drop a box on Space
+            if (event.key.code == sf::Keyboard::Space) {
+                world.addBody(RigidBody(dropX(rng), 40, 40, 40, 2.0f, 0.3f));
+                colors.push_back(sf::Color(229, 62, 62));
+            }
+        }
+
+        accumulator += std::min(clock.restart().asSeconds(), 0.25f);
+        while (accumulator >= TIME_STEP) {
+            world.step(TIME_STEP);
+            accumulator -= TIME_STEP;
+            solveSum += world.solveMs;
+            stepSum += world.stepMs;
+            iterationSum += world.iterations;
+            steps++;
+        }
+
+        // Averages over the last half second
+        if (statsTimer.getElapsedTime().asSeconds() >= 0.5f && steps > 0) {
+            solveMs = solveSum / steps;
+            stepMs = stepSum / steps;
+            iterations = iterationSum / steps;
+            solveSum = stepSum = iterationSum = 0.0f;
+            steps = 0;
+            statsTimer.restart();
+        }
+
+        window.clear(sf::Color(240, 240, 240));
+
+        renderer.update(world, colors);
+        renderer.draw(window);
+
+        if (statsText.changed({(double)world.size(), (double)world.awakeCount, (double)world.islandCount,
+                               (double)world.contactCount, iterations, solveMs, stepMs,
+                               (double)world.warmStarting})) {
+            std::stringstream ss;
+            ss << "Bodies: " << world.size() << " (" << world.awakeCount << " awake)\n"
+               << "Islands: " << world.islandCount << "\n"
+               << "Contacts: " << world.contactCount << "\n"
+               << "Iterations: " << std::fixed << std::setprecision(1) << iterations
+               << " / " << world.maxIterations << "\n"
+               << "Solve: " << std::setprecision(3) << solveMs << " ms\n"
+               << "Step: " << stepMs << " ms\n"
+               << "Warm starting: " << (world.warmStarting ? "on" : "off");
+            statsText.text.setString(ss.str());
+        }
+        window.draw(statsBg);
+        window.draw(statsText.text);
+
+        window.draw(instructions.text);
+
+        window.display();
+    }
+
+    return 0;
+}
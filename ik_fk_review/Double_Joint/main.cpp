@@ -1,20 +1,31 @@
 #include <iostream>
 #include <cmath>
-#include "kinematics.h"
-#include "controller.h"
+#include "../common/kinematics.h"
+#include "../common/trajectory.h"
+#include "../common/pid_bank.h"
+#include "../common/gains.h"
+#include "../common/dynamics.h"
 #include "visualize.h"
 
-int main() {
+int main(int, char** argv) {
     // Setup
-    Kinematics robot(2.0, 1.0);  // 1 meter arm
+    Kinematics<2> robot(2.0, 1.0);  // 1 meter arm
+    Dynamics<2> dynamics(robot);  // uniform rods, 1 kg/m, under gravity
 
-    // 2 PID controllers for each joint
-    PIDController pid1(5.0, 0.1, 0.5);
-    PIDController pid2(5.0, 0.1, 0.5);
+    // A PID controller for each joint, stepped together
+    PIDBank<2> pids(5.0, 0.1, 0.5);
+    // Tuned per joint by tools/tune, when there's a gains file
+    std::string gains_file = gainsFileFor(argv[0]);
+    if (loadGains<2, double>(gains_file, "double", pids.kp, pids.ki, pids.kd, pids.output_limit)) {
+        std::cout << "Gains from " << gains_file << "\n";
+    } else {
+        std::cerr << "Can't read " << gains_file << ", using untuned gains that may not settle\n";
+    }
     
     double theta1 = 0.0, theta2 = 0.0;
     double vel1 = 0.0, vel2 = 0.0;
     double dt = 0.01;  // 10ms timestep
+    const int substeps = 100;  // arm simulated at 10 kHz
     
     // Get target from user
     Position target;
@@ -22,9 +33,23 @@ int main() {
     target.y = 1;
     std::cout << "Target: (" << target.x << ", " << target.y << ")\n"; 
     
-    JointAngles target_angles = robot.inverse(target);
-    std::cout << "Target angles: theta1=" << target_angles.theta1 * (180/M_PI) 
-              << " deg, theta2=" << target_angles.theta2 * (180/M_PI) << " deg\n\n";
+    // Of the elbow branches, take the one needing least motion. The
+    // shoulder swings the whole arm, so weigh each joint by the length
+    // outboard of it.
+    Kinematics<2>::Solutions solutions = robot.inverseAll(target);
+    Kinematics<2>::JointAngles target_angles = solutions.empty()
+        ? robot.inverse(target)
+        : Kinematics<2>::nearest(solutions, {theta1, theta2},
+                                 {robot.lengths[0] + robot.lengths[1], robot.lengths[1]});
+    std::cout << solutions.size() << " IK solution(s)\n";
+    std::cout << "Target angles: theta1=" << target_angles[0] * (180/M_PI) 
+              << " deg, theta2=" << target_angles[1] * (180/M_PI) << " deg\n";
+
+    // Get there within velocity and acceleration limits rather than
+    // handing PID a step; both joints arrive together
+    Trajectory<2> move;
+    move.plan({theta1, theta2}, target_angles, {1.5, 1.5}, {3.0, 3.0});
+    std::cout << "Move takes " << move.duration() << " s\n\n";
     
     // Create visualizer
     float space_size = 10.0;
@@ -40,21 +65,27 @@ int main() {
         
         // Continue simulation if not reached target
         if (!reached_target && t < 5) {
-            // PID control
-            double control1 = pid1.compute(theta1, target_angles.theta1, dt);
-            double control2 = pid2.compute(theta2, target_angles.theta2, dt);
-            
-            // Update motion
-            vel1 += control1 * dt;
-            vel1 *= .95;
-            vel1 += vel1 * dt;
-
-            vel2 += control2 * dt;
-            vel2 *= .95;
-            vel2 += vel2 * dt;
+            // Track the move: PID corrects toward this tick's setpoint and
+            // the feedforward is the move's own acceleration
+            Trajectory<2>::Setpoint prev = move.sample(t - dt), now = move.sample(t), next = move.sample(t + dt);
+            double feedforward[2];
+            for (int j = 0; j < 2; j++) {
+                feedforward[j] = (next.position[j] - 2 * now.position[j] + prev.position[j]) / (dt * dt);
+            }
+            PIDBank<2>::Values pid_out;
+            pids.compute({theta1, theta2}, now.position, dt, pid_out);
+            double control1 = pid_out[0] + feedforward[0];
+            double control2 = pid_out[1] + feedforward[1];
             
-            theta1 += vel1 * dt;
-            theta2 += vel2 * dt;
+            // Computed torque: the model gives the torques for those
+            // accelerations, held while the arm is stepped through the tick
+            Dynamics<2>::State state{{theta1, theta2}, {vel1, vel2}};
+            Dynamics<2>::JointValues torque = dynamics.inverse(state.position, state.velocity, {control1, control2});
+            for (int k = 0; k < substeps; k++) dynamics.step(state, torque, dt / substeps);
+            theta1 = state.position[0];
+            theta2 = state.position[1];
+            vel1 = state.velocity[0];
+            vel2 = state.velocity[1];
             
             /*
             std::cout << "Control1: " << control1 
@@ -64,16 +95,16 @@ int main() {
             */
             // Print every 0.5 seconds
             if (fmod(t, 0.5) < dt) {
-                Result result = robot.forward(theta1, theta2);
+                Kinematics<2>::Result result = robot.forward({theta1, theta2});
                 std::cout << "t=" << t 
                           << " theta1=" << theta1 * (180/M_PI) 
                           << " theta2=" << theta2 * (180/M_PI) 
-                          << " pos=(" << result.pos2.x << "," << result.pos2.y << ")\n";
+                          << " pos=(" << result[1].x << "," << result[1].y << ")\n";
             }
             
             // Check if reached target
-            if (fabs(target_angles.theta1 - theta1) < 0.001 && 
-                fabs(target_angles.theta2 - theta2) < .001) {
+            if (fabs(target_angles[0] - theta1) < 0.001 && 
+                fabs(target_angles[1] - theta2) < .001) {
                 std::cout << "\nReached target! (Close window to exit)\n";
                 reached_target = true;
             }
@@ -82,7 +113,7 @@ int main() {
         }
         
         // Draw current state (keep visualizing even after reaching target)
-        viz.draw(theta1, theta2, target, robot.L1, robot.L2);
+        viz.draw(theta1, theta2, target, robot.lengths[0], robot.lengths[1]);
     }
     
     return 0;
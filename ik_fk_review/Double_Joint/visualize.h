@@ -2,7 +2,7 @@
 #define VISUALIZE_H
 
 #include <SFML/Graphics.hpp>
-#include "kinematics.h"
+#include "../common/kinematics.h"
 
 class RobotVisualizer {
 private:
@@ -48,10 +48,10 @@ public:
         window.draw(targetCircle);
 
         // Calculate end effector position using forward kinematics
-        Kinematics kin(L1, L2);
-        Result result = kin.forward(theta1, theta2);
-        Position end_pos = result.pos2;
-        Position elbow_pos = result.pos1;
+        Kinematics<2> kin(L1, L2);
+        Kinematics<2>::Result result = kin.forward({theta1, theta2});
+        Position end_pos = result[1];
+        Position elbow_pos = result[0];
 
         double elbow_x = elbow_pos.x;
         double elbow_y = elbow_pos.y;
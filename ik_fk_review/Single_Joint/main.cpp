@@ -1,17 +1,29 @@
 #include <iostream>
 #include <cmath>
-#include "kinematics.h"
-#include "controller.h"
+#include "../common/kinematics.h"
+#include "../common/trajectory.h"
+#include "../common/pid_bank.h"
+#include "../common/gains.h"
+#include "../common/dynamics.h"
 #include "visualize.h"
 
-int main() {
+int main(int, char** argv) {
     // Setup
-    Kinematics robot(1.0);  // 1 meter arm
-    PIDController pid(5.0, 0.1, 0.5);  // P, I, D gains
+    Kinematics<1> robot(1.0);  // 1 meter arm
+    Dynamics<1> dynamics(robot);  // uniform rod, 1 kg/m, under gravity
+    PIDBank<1> pid(5.0, 0.1, 0.5);  // P, I, D gains
+    // Tuned by tools/tune, when there's a gains file
+    std::string gains_file = gainsFileFor(argv[0]);
+    if (loadGains<1, double>(gains_file, "single", pid.kp, pid.ki, pid.kd, pid.output_limit)) {
+        std::cout << "Gains from " << gains_file << "\n";
+    } else {
+        std::cerr << "Can't read " << gains_file << ", using untuned gains that may not settle\n";
+    }
     
     double angle = 0.0;
     double velocity = 0.0;
     double dt = 0.01;  // 10ms timestep
+    const int substeps = 100;  // arm simulated at 10 kHz
     
     // Get target from user
     Position target;
@@ -19,8 +31,14 @@ int main() {
     target.y = 1;
     std::cout << "Target: (" << target.x << ", " << target.y << ")\n"; 
     
-    double target_angle = robot.inverse(target);
-    std::cout << "Target angle: " << target_angle * (180/M_PI) << " deg\n\n";
+    double target_angle = robot.inverse(target)[0];
+    std::cout << "Target angle: " << target_angle * (180/M_PI) << " deg\n";
+
+    // Get there within velocity and acceleration limits rather than
+    // handing PID a step
+    Trajectory<1> move;
+    move.plan({angle}, {target_angle}, {1.5}, {3.0});
+    std::cout << "Move takes " << move.duration() << " s\n\n";
     
     // Create visualizer
     float space_size = 3.0;
@@ -36,17 +54,27 @@ int main() {
         
         // Continue simulation if not reached target
         if (!reached_target && t < 5) {
-            // PID control
-            double control = pid.compute(angle, target_angle, dt);
+            // Track the move: PID corrects toward this tick's setpoint and
+            // the feedforward is the move's own acceleration
+            double prev = move.sample(t - dt).position[0];
+            double now = move.sample(t).position[0];
+            double next = move.sample(t + dt).position[0];
+            double feedforward = (next - 2 * now + prev) / (dt * dt);
+            PIDBank<1>::Values pid_out;
+            pid.compute({angle}, {now}, dt, pid_out);
+            double control = pid_out[0] + feedforward;
             
-            // Update motion
-            velocity += control * dt;
-            velocity *= 0.95;  // damping
-            angle += velocity * dt;
+            // Computed torque: the model gives the torque for that
+            // acceleration, held while the arm is stepped through the tick
+            Dynamics<1>::State state{{angle}, {velocity}};
+            Dynamics<1>::JointValues torque = dynamics.inverse(state.position, state.velocity, {control});
+            for (int k = 0; k < substeps; k++) dynamics.step(state, torque, dt / substeps);
+            angle = state.position[0];
+            velocity = state.velocity[0];
             
             // Print every 0.5 seconds
             if (fmod(t, 0.5) < dt) {
-                Position pos = robot.forward(angle);
+                Position pos = robot.endEffector({angle});
                 std::cout << "t=" << t 
                           << " angle=" << angle * (180/M_PI) 
                           << " pos=(" << pos.x << "," << pos.y << ")\n";
@@ -62,7 +90,7 @@ int main() {
         }
         
         // Draw current state (keep visualizing even after reaching target)
-        viz.draw(angle, target, robot.link_length);
+        viz.draw(angle, target, robot.lengths[0]);
     }
     
     return 0;
@@ -2,7 +2,7 @@
 #define VISUALIZE_H
 
 #include <SFML/Graphics.hpp>
-#include "kinematics.h"
+#include "../common/kinematics.h"
 
 class RobotVisualizer {
 private:
@@ -55,8 +55,8 @@ public:
         window.draw(base);
         
         // Calculate end effector position using forward kinematics
-        Kinematics kin(link_length);
-        Position end = kin.forward(angle);
+        Kinematics<1> kin(link_length);
+        Position end = kin.endEffector({angle});
         double end_x = end.x;
         double end_y = end.y;
         
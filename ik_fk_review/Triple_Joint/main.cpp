@@ -1,21 +1,46 @@
 #include <iostream>
 #include <cmath>
-#include "kinematics.h"
-#include "controller.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/ik_solver.h"
+#include "../common/trajectory.h"
+#include "../common/path.h"
+#include "../common/path_follower.h"
+#include "../common/pid_bank.h"
+#include "../common/gains.h"
+#include "../common/dynamics.h"
+#include "../common/planner.h"
 #include "visualize.h"
 
-int main() {
+int main(int argc, char** argv) {
+    // --path: once at the target, trace a path from there
+    // --obstacles: get to the target around a couple of obstacles
+    bool follow_path = false, avoid = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--path") follow_path = true;
+        if (std::string(argv[i]) == "--obstacles") avoid = true;
+    }
+
     // Setup
-    Kinematics robot(2.0, 1.0, 0.5);  // 1 meter arm
+    Kinematics<3> robot(2.0, 1.0, 0.5);  // 1 meter arm
+    Dynamics<3> dynamics(robot);  // uniform rods, 1 kg/m, under gravity
 
-    // 2 PID controllers for each joint
-    PIDController pid1(5.0, 0.1, 0.5);
-    PIDController pid2(5.0, 0.1, 0.5);
-    PIDController pid3(5.0, 0.1, 0.5);
+    // A PID controller for each joint, stepped together
+    PIDBank<3> pids(5.0, 0.1, 0.5);
+    // Tuned per joint by tools/tune, when there's a gains file
+    std::string gains_file = gainsFileFor(argv[0]);
+    if (loadGains<3, double>(gains_file, "triple", pids.kp, pids.ki, pids.kd, pids.output_limit)) {
+        std::cout << "Gains from " << gains_file << "\n";
+    } else {
+        std::cerr << "Can't read " << gains_file << ", using untuned gains that may not settle\n";
+    }
     
     double theta1 = 0.0, theta2 = 0.0, theta3 = 0.0;
     double vel1 = 0.0, vel2 = 0.0, vel3 = 0.0;
     double dt = 0.01;  // 10ms timestep
+    const int substeps = 100;  // arm simulated at 10 kHz
     
     // Get target from user
     Position target;
@@ -26,22 +51,89 @@ int main() {
 
     std::cout << "Target: (" << target.x << ", " << target.y << ")\n"; 
     
-    JointAngles target_angles = robot.inverse(target, phi);
-    std::cout << "Target angles: theta1=" << target_angles.theta1 * (180/M_PI) 
-              << " deg, theta2=" << target_angles.theta2 * (180/M_PI)
-              << " deg, theta3=" << target_angles.theta3 * (180/M_PI) << " deg\n\n";
+    // Of the elbow branches, take the one needing least motion, each
+    // joint weighed by the length outboard of it
+    Kinematics<3>::Solutions branches = robot.inverseAll(target, phi);
+    Kinematics<3>::JointAngles start = branches.empty()
+        ? robot.inverse(target, phi)
+        : Kinematics<3>::nearest(branches, {theta1, theta2, theta3},
+                                 {robot.reach(), robot.lengths[1] + robot.lengths[2], robot.lengths[2]});
+    std::cout << branches.size() << " analytic IK solution(s)\n";
+
+    // Closed form gives the answer outright when the target is in reach;
+    // numerical IK started from it then only has work to do out of reach,
+    // where it settles on the closest pose rather than a straight arm
+    IKSolver<3> solver(robot);
+    IKSolver<3>::Result solution = solver.solve(target, phi, start);
+    Kinematics<3>::JointAngles target_angles = solution.angles;
+    std::cout << "IK: " << solution.iterations << " iterations, error " << solution.error
+              << (solution.converged ? "\n" : " (out of reach, using closest pose)\n");
+    std::cout << "Target angles: theta1=" << target_angles[0] * (180/M_PI) 
+              << " deg, theta2=" << target_angles[1] * (180/M_PI)
+              << " deg, theta3=" << target_angles[2] * (180/M_PI) << " deg\n";
+
+    // With --obstacles, plan a way round them in joint space; the move
+    // then stops at each waypoint in turn
+    std::vector<Kinematics<3>::JointAngles> waypoints = {{theta1, theta2, theta3}, target_angles};
+    Obstacles<double> obstacles;
+    if (avoid) {
+        obstacles.circles.push_back({{0.5, 2.75}, 0.25});
+        obstacles.boxes.push_back({{-1.6, 2.3}, {-1.0, 2.6}});
+        Planner<3> planner(robot, obstacles);
+        Planner<3>::Result plan = planner.plan(waypoints.front(), target_angles);
+        if (plan.found) {
+            waypoints = plan.waypoints;
+            std::cout << "Planned round the obstacles in " << plan.seconds * 1000 << " ms: "
+                      << waypoints.size() - 2 << " waypoint(s), " << plan.nodes << " nodes\n";
+        } else {
+            std::cout << "No way round the obstacles found, going straight\n";
+        }
+    }
+
+    // Get there within velocity and acceleration limits rather than
+    // handing PID a step; all joints arrive together
+    std::vector<Trajectory<3>> legs(waypoints.size() - 1);
+    double move_time = 0;
+    for (size_t i = 0; i < legs.size(); i++) {
+        legs[i].plan(waypoints[i], waypoints[i + 1], {1.5, 1.5, 1.5}, {3.0, 3.0, 3.0});
+        move_time += legs[i].duration();
+    }
+    auto move = [&](double when) {
+        size_t i = 0;
+        while (i + 1 < legs.size() && when > legs[i].duration()) when -= legs[i++].duration();
+        return legs[i].sample(when);
+    };
+    std::cout << "Move takes " << move_time << " s\n\n";
     
     // DEBUG
     std::cout << "Checking wrist position:\n";
-    double x_w = target.x - robot.L3 * cos(phi);
-    double y_w = target.y - robot.L3 * sin(phi);
+    double x_w = target.x - robot.lengths[2] * cos(phi);
+    double y_w = target.y - robot.lengths[2] * sin(phi);
     std::cout << "  Wrist should be at: (" << x_w << ", " << y_w << ")\n";
     double dist = sqrt(x_w*x_w + y_w*y_w);
-    std::cout << "  Distance to wrist: " << dist << " (max reach: " << robot.L1 + robot.L2 << ")\n";
+    std::cout << "  Distance to wrist: " << dist << " (max reach: " << robot.lengths[0] + robot.lengths[1] << ")\n";
+
+    // Line, arc and curve back to the target, at 0.3 m/s; IK solved each
+    // tick from the tick before
+    const double deg = M_PI / 180;
+    Path<double> path(Pose<double>{target, phi});
+    path.lineTo({{-0.5, 2.3}, 70 * deg})
+        .arc({0.0, 1.3}, -90 * deg)
+        .curveThrough({{{2.2, 0.0}, 0 * deg}, {{0.0, -2.2}, -90 * deg},
+                       {{-2.0, -1.2}, -160 * deg}, {target, phi - 2 * M_PI}});
+    PathFollower<3> follower(solver, path, 0.3, dt, true, target_angles);
+    Kinematics<3>::JointAngles path_prev = target_angles, path_now = target_angles, path_next = target_angles;
+    Position path_target = target;
+    double worst_latency = 0;
+    int fallback_ticks = 0;
+    if (follow_path) {
+        std::cout << "Path: " << path.length() << " m, " << path.length() / follower.speed << " s\n";
+    }
 
     // Create visualizer
     float space_size = 10.0;
     RobotVisualizer viz(600, space_size);
+    viz.setObstacles(obstacles);
     
     // Simulation loop
     double t = 0.0;
@@ -52,27 +144,55 @@ int main() {
         viz.handleEvents();
         
         // Continue simulation if not reached target
-        if (!reached_target && t < 5) {
+        double time_limit = std::max(5.0, move_time + 3) + (follow_path ? path.length() / follower.speed : 0);
+        if (!reached_target && t < time_limit) {
 
-            // PID control
-            double control1 = pid1.compute(theta1, target_angles.theta1, dt);
-            double control2 = pid2.compute(theta2, target_angles.theta2, dt);
-            double control3 = pid3.compute(theta3, target_angles.theta3, dt);
+            // Setpoints for the last, this and the next tick: from the move,
+            // then in path mode from the path, one tick ahead
+            Kinematics<3>::JointAngles prev, now, next;
+            if (!follow_path || t + dt <= move_time) {
+                prev = move(t - dt).position;
+                now = move(t).position;
+                next = move(t + dt).position;
+            } else {
+                path_prev = path_now;
+                path_now = path_next;
+                if (!follower.done()) {
+                    PathFollower<3>::Step step = follower.step();
+                    path_next = step.angles;
+                    path_target = step.target.position;
+                    worst_latency = std::max(worst_latency, step.seconds);
+                    fallback_ticks += step.fallback;
+                }
+                prev = path_prev;
+                now = path_now;
+                next = path_next;
+            }
 
-            // Update motion
-            vel1 += control1 * dt;
-            vel2 += control2 * dt;
-            vel3 += control3 * dt;
-            
-            // Damping
-            vel1 *= .95;
-            vel2 *= .95;
-            vel3 *= .95;
+            // PID corrects toward this tick's setpoint and the feedforward is
+            // the setpoints' own acceleration
+            double feedforward[3];
+            for (int j = 0; j < 3; j++) {
+                feedforward[j] = (next[j] - 2 * now[j] + prev[j]) / (dt * dt);
+            }
+            PIDBank<3>::Values pid_out;
+            pids.compute({theta1, theta2, theta3}, now, dt, pid_out);
+            double control1 = pid_out[0] + feedforward[0];
+            double control2 = pid_out[1] + feedforward[1];
+            double control3 = pid_out[2] + feedforward[2];
 
-            // Update angles using velocity
-            theta1 += vel1 * dt;
-            theta2 += vel2 * dt;
-            theta3 += vel3 * dt;
+            // Computed torque: the model gives the torques for those
+            // accelerations, held while the arm is stepped through the tick
+            Dynamics<3>::State state{{theta1, theta2, theta3}, {vel1, vel2, vel3}};
+            Dynamics<3>::JointValues torque = dynamics.inverse(state.position, state.velocity,
+                                                               {control1, control2, control3});
+            for (int k = 0; k < substeps; k++) dynamics.step(state, torque, dt / substeps);
+            theta1 = state.position[0];
+            theta2 = state.position[1];
+            theta3 = state.position[2];
+            vel1 = state.velocity[0];
+            vel2 = state.velocity[1];
+            vel3 = state.velocity[2];
             
             /*
             std::cout << "Control1: " << control1 
@@ -82,19 +202,25 @@ int main() {
             */
             // Print every 0.5 seconds
             if (fmod(t, 0.5) < dt) {
-                Result result = robot.forward(theta1, theta2, theta3);
+                Kinematics<3>::Result result = robot.forward({theta1, theta2, theta3});
                 std::cout << "t=" << t 
                           << " theta1=" << theta1 * (180/M_PI) 
                           << " theta2=" << theta2 * (180/M_PI) 
                           << " theta3=" << theta3 * (180/M_PI) 
-                          << " pos=(" << result.pos2.x << "," << result.pos2.y << ")\n";
+                          << " pos=(" << result[1].x << "," << result[1].y << ")\n";
             }
             
-            // Check if reached target
-            if (fabs(target_angles.theta1 - theta1) < 0.001 && 
-                fabs(target_angles.theta2 - theta2) < .001 &&
-                fabs(target_angles.theta3 - theta3) < .001) {
+            // Check if reached target (the path's end in path mode)
+            Kinematics<3>::JointAngles goal = follow_path ? follower.angles() : target_angles;
+            if ((!follow_path || follower.done()) &&
+                fabs(goal[0] - theta1) < 0.001 && 
+                fabs(goal[1] - theta2) < .001 &&
+                fabs(goal[2] - theta3) < .001) {
                 std::cout << "\nReached target! (Close window to exit)\n";
+                if (follow_path) {
+                    std::cout << "Slowest path IK step: " << worst_latency * 1e6 << " us, "
+                              << fallback_ticks << " ticks behind the path near singularities\n";
+                }
                 reached_target = true;
             }
             
@@ -102,7 +228,7 @@ int main() {
         }
         
         // Draw current state (keep visualizing even after reaching target)
-        viz.draw(theta1, theta2, theta3, target, robot.L1, robot.L2, robot.L3);
+        viz.draw(theta1, theta2, theta3, path_target, robot.lengths[0], robot.lengths[1], robot.lengths[2]);
     }
     
     return 0;
@@ -2,7 +2,8 @@
 #define VISUALIZE_H
 
 #include <SFML/Graphics.hpp>
-#include "kinematics.h"
+#include "../common/kinematics.h"
+#include "../common/planner.h"
 
 class RobotVisualizer {
 private:
@@ -10,6 +11,7 @@ private:
     float scale;  // pixels per meter
     sf::Vector2f origin;  // screen origin
     float space_size;
+    Obstacles<double> obstacles;
     
 public:
     RobotVisualizer(float window_size = 800.0f, float meters_shown = 5.0f) 
@@ -21,6 +23,11 @@ public:
         window.setFramerateLimit(60);
     }
     
+    // Drawn behind the arm from now on
+    void setObstacles(const Obstacles<double>& scene) {
+        obstacles = scene;
+    }
+    
     bool isOpen() {
         return window.isOpen();
     }
@@ -38,6 +45,21 @@ public:
         
         // Draw grid
         drawGrid();
+
+        // Draw obstacles (grey)
+        for (const Obstacles<double>::Circle& c : obstacles.circles) {
+            sf::CircleShape shape(c.radius * scale);
+            shape.setFillColor(sf::Color(150, 150, 150));
+            shape.setOrigin(c.radius * scale, c.radius * scale);
+            shape.setPosition(toScreen(c.centre.x, c.centre.y));
+            window.draw(shape);
+        }
+        for (const Obstacles<double>::Box& b : obstacles.boxes) {
+            sf::RectangleShape shape(sf::Vector2f((b.high.x - b.low.x) * scale, (b.high.y - b.low.y) * scale));
+            shape.setFillColor(sf::Color(150, 150, 150));
+            shape.setPosition(toScreen(b.low.x, b.high.y));
+            window.draw(shape);
+        }
         
         // Draw target (red circle)
         sf::CircleShape targetCircle(8);
@@ -48,15 +70,15 @@ public:
         window.draw(targetCircle);
 
         // Calculate end effector position using forward kinematics
-        Kinematics kin(L1, L2, L3);
-        Result result = kin.forward(theta1, theta2, theta3);
+        Kinematics<3> kin(L1, L2, L3);
+        Kinematics<3>::Result result = kin.forward({theta1, theta2, theta3});
 
-        double elbow_x = result.pos1.x;
-        double elbow_y = result.pos1.y;
-        double wrist_x = result.pos2.x;
-        double wrist_y = result.pos2.y;
-        double end_x = result.pos3.x;
-        double end_y = result.pos3.y;
+        double elbow_x = result[0].x;
+        double elbow_y = result[0].y;
+        double wrist_x = result[1].x;
+        double wrist_y = result[1].y;
+        double end_x = result[2].x;
+        double end_y = result[2].y;
 
         // Draw base -> elbow link
         sf::Vertex link1[] = {
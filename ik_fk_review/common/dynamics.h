@@ -0,0 +1,231 @@
+#ifndef DYNAMICS_H
+#define DYNAMICS_H
+
+#include <array>
+#include <cmath>
+#include "kinematics.h"
+
+// Rigid-body dynamics of the planar arm, for simulating it in place of
+// the demos' velocity-damping plant.
+//
+// Each link has a mass, a centre of mass along it and a rotational inertia
+// about that centre (a uniform rod unless set otherwise), and each joint
+// viscous friction. Gravity acts in the arm's plane.
+//
+// Both directions are O(N) recursions over planar spatial vectors (angle
+// component first, then x, y), in each link's own frame: origin at its
+// joint, x along the link.
+//   inverse()  torques for given accelerations, recursive Newton-Euler
+//   forward()  accelerations for given torques, articulated-body algorithm
+// Everything lives in fixed-size arrays sized by N, so nothing touches the
+// heap and a step costs the same every time.
+
+template <int N, typename Scalar = double>
+class Dynamics {
+public:
+    typedef std::array<Scalar, N> JointValues;
+
+    struct State {
+        JointValues position, velocity;
+    };
+
+    std::array<Scalar, N> lengths;
+    std::array<Scalar, N> masses;
+    std::array<Scalar, N> centres;      // centre of mass, distance along the link
+    std::array<Scalar, N> inertias;     // about the centre of mass
+    std::array<Scalar, N> friction;     // viscous, torque per rad/s
+    Point<Scalar> gravity;
+
+    // Uniform rods of the arm's lengths at density kg/m, hanging in a
+    // vertical plane (y up)
+    explicit Dynamics(const Kinematics<N, Scalar>& arm, Scalar density = 1, Scalar g = Scalar(9.81))
+        : lengths(arm.lengths), gravity{0, -g} {
+        for (int i = 0; i < N; i++) {
+            masses[i] = density * lengths[i];
+            centres[i] = lengths[i] / 2;
+            inertias[i] = masses[i] * lengths[i] * lengths[i] / 12;
+            friction[i] = 0;
+        }
+    }
+
+    // Joint torques giving acceleration qdd at (q, qd)
+    JointValues inverse(const JointValues& q, const JointValues& qd, const JointValues& qdd) const {
+        std::array<Transform, N> X;
+        std::array<Vector, N> f;
+        Vector v = {0, 0, 0};
+        // Gravity as the base accelerating the other way
+        Vector a = {0, -gravity.x, -gravity.y};
+        for (int i = 0; i < N; i++) {
+            X[i] = transform(i, q[i]);
+            v = X[i].motion(v);
+            v[0] += qd[i];
+            a = X[i].motion(a);
+            a[0] += qdd[i];
+            // crm(v) S qd: the joint's rate seen from a moving frame
+            a[1] += v[2] * qd[i];
+            a[2] -= v[1] * qd[i];
+            f[i] = add(inertia(i).times(a), crossForce(v, inertia(i).times(v)));
+        }
+
+        JointValues tau;
+        for (int i = N - 1; i >= 0; i--) {
+            tau[i] = f[i][0] + friction[i] * qd[i];
+            if (i > 0) f[i - 1] = add(f[i - 1], X[i].force(f[i]));
+        }
+        return tau;
+    }
+
+    // Joint accelerations under torques tau at (q, qd)
+    JointValues forward(const JointValues& q, const JointValues& qd, const JointValues& tau) const {
+        std::array<Transform, N> X;
+        std::array<Vector, N> c, pA, U;
+        std::array<Inertia, N> IA;
+        JointValues D, u;
+
+        // Outwards: velocities, and each link's bias force on its own
+        Vector v = {0, 0, 0};
+        for (int i = 0; i < N; i++) {
+            X[i] = transform(i, q[i]);
+            v = X[i].motion(v);
+            v[0] += qd[i];
+            c[i] = {0, v[2] * qd[i], -v[1] * qd[i]};
+            IA[i] = inertia(i);
+            pA[i] = crossForce(v, IA[i].times(v));
+        }
+
+        // Inwards: fold each link's articulated inertia into its parent
+        for (int i = N - 1; i >= 0; i--) {
+            U[i] = IA[i].column0();
+            D[i] = U[i][0];
+            u[i] = tau[i] - friction[i] * qd[i] - pA[i][0];
+            if (i > 0) {
+                Inertia Ia = IA[i].minusOuter(U[i], 1 / D[i]);
+                Vector pa = add(add(pA[i], Ia.times(c[i])), scale(U[i], u[i] / D[i]));
+                IA[i - 1] = IA[i - 1].plus(Ia.through(X[i]));
+                pA[i - 1] = add(pA[i - 1], X[i].force(pa));
+            }
+        }
+
+        // Outwards again: accelerations
+        JointValues qdd;
+        Vector a = {0, -gravity.x, -gravity.y};
+        for (int i = 0; i < N; i++) {
+            a = add(X[i].motion(a), c[i]);
+            qdd[i] = (u[i] - dot(U[i], a)) / D[i];
+            a[0] += qdd[i];
+        }
+        return qdd;
+    }
+
+    // Torques holding the arm still at q
+    JointValues gravityTorques(const JointValues& q) const {
+        JointValues zero;
+        zero.fill(0);
+        return inverse(q, zero, zero);
+    }
+
+    // Kinetic plus potential energy, for checking the integration
+    Scalar energy(const State& s) const {
+        Scalar total = 0, angle = 0, x = 0, y = 0, vx = 0, vy = 0, w = 0;
+        for (int i = 0; i < N; i++) {
+            angle += s.position[i];
+            w += s.velocity[i];
+            Scalar ca = std::cos(angle), sa = std::sin(angle);
+            // Centre of mass and its velocity
+            Scalar cx = x + centres[i] * ca, cy = y + centres[i] * sa;
+            Scalar cvx = vx - w * centres[i] * sa, cvy = vy + w * centres[i] * ca;
+            total += Scalar(0.5) * (masses[i] * (cvx * cvx + cvy * cvy) + inertias[i] * w * w);
+            total -= masses[i] * (gravity.x * cx + gravity.y * cy);
+            x += lengths[i] * ca;
+            y += lengths[i] * sa;
+            vx -= w * lengths[i] * sa;
+            vy += w * lengths[i] * ca;
+        }
+        return total;
+    }
+
+    // One semi-implicit Euler step with tau held over it
+    void step(State& s, const JointValues& tau, Scalar dt) const {
+        JointValues qdd = forward(s.position, s.velocity, tau);
+        for (int i = 0; i < N; i++) {
+            s.velocity[i] += qdd[i] * dt;
+            s.position[i] += s.velocity[i] * dt;
+        }
+    }
+
+private:
+    typedef std::array<Scalar, 3> Vector;   // (angle, x, y)
+
+    // Parent frame to link frame: turn by the joint angle, offset by the
+    // parent's length along its x axis. As a matrix on motion vectors:
+    //   [ 1        0   0 ]
+    //   [ s*r      c   s ]
+    //   [ c*r     -s   c ]
+    struct Transform {
+        Scalar c, s, r;
+
+        Vector motion(const Vector& m) const {
+            return {m[0], s * r * m[0] + c * m[1] + s * m[2], c * r * m[0] - s * m[1] + c * m[2]};
+        }
+
+        // Transpose: link-frame force back into the parent frame
+        Vector force(const Vector& f) const {
+            Scalar fx = c * f[1] - s * f[2], fy = s * f[1] + c * f[2];
+            return {f[0] + r * fy, fx, fy};
+        }
+    };
+
+    // Symmetric 3x3 spatial inertia, upper triangle
+    struct Inertia {
+        Scalar a00, a01, a02, a11, a12, a22;
+
+        Vector times(const Vector& v) const {
+            return {a00 * v[0] + a01 * v[1] + a02 * v[2],
+                    a01 * v[0] + a11 * v[1] + a12 * v[2],
+                    a02 * v[0] + a12 * v[1] + a22 * v[2]};
+        }
+
+        Vector column0() const { return {a00, a01, a02}; }
+
+        Inertia plus(const Inertia& o) const {
+            return {a00 + o.a00, a01 + o.a01, a02 + o.a02, a11 + o.a11, a12 + o.a12, a22 + o.a22};
+        }
+
+        // This - k * U U^T
+        Inertia minusOuter(const Vector& U, Scalar k) const {
+            return {a00 - k * U[0] * U[0], a01 - k * U[0] * U[1], a02 - k * U[0] * U[2],
+                    a11 - k * U[1] * U[1], a12 - k * U[1] * U[2], a22 - k * U[2] * U[2]};
+        }
+
+        // X^T * this * X, carrying a link's inertia into its parent's frame
+        Inertia through(const Transform& X) const {
+            // Columns of this * X, then rows of X^T applied to them
+            Vector col0 = times({1, X.s * X.r, X.c * X.r});
+            Vector col1 = times({0, X.c, -X.s});
+            Vector col2 = times({0, X.s, X.c});
+            return {X.force(col0)[0], X.force(col1)[0], X.force(col2)[0],
+                    X.force(col1)[1], X.force(col2)[1], X.force(col2)[2]};
+        }
+    };
+
+    Transform transform(int i, Scalar q) const {
+        return {std::cos(q), std::sin(q), i > 0 ? lengths[i - 1] : Scalar(0)};
+    }
+
+    // Link i's inertia about its joint, centre of mass on the x axis
+    Inertia inertia(int i) const {
+        Scalar m = masses[i], cx = centres[i];
+        return {inertias[i] + m * cx * cx, 0, m * cx, m, 0, m};
+    }
+
+    // crf(v) * f
+    static Vector crossForce(const Vector& v, const Vector& f) {
+        return {v[1] * f[2] - v[2] * f[1], -v[0] * f[2], v[0] * f[1]};
+    }
+
+    static Vector add(const Vector& a, const Vector& b) { return {a[0] + b[0], a[1] + b[1], a[2] + b[2]}; }
+    static Vector scale(const Vector& a, Scalar k) { return {a[0] * k, a[1] * k, a[2] * k}; }
+    static Scalar dot(const Vector& a, const Vector& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef EPISODE_H
+#define EPISODE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include "trajectory.h"
+#include "pid_bank.h"
+#include "dynamics.h"
+
+// One run of the arm demos' control loop with no window: a trapezoidal
+// move from start to goal, PID plus feedforward tracking it, and the
+// demos' plant (vel += u * dt, then a share `keep` of it survives the
+// tick), for a fixed simulated time. Gives how the joints settled, so
+// many goals can be run headless and the results compared.
+//
+// Given a Dynamics model the plant is the rigid-body arm instead, under
+// computed torque as in the mains: the PID output is added to the move's
+// acceleration, the model's inverse dynamics turns that into joint
+// torques, and the arm is stepped `substeps` times under them per tick.
+//
+// Settling time is when every joint entered the tolerance band around
+// the goal for the last time; if any joint is outside it at the end the
+// run never settled. Overshoot is how far a joint went past the goal in
+// the direction it was moving.
+
+template <int N, typename Scalar = double>
+class Episode {
+public:
+    typedef std::array<Scalar, N> JointValues;
+
+    struct Settings {
+        JointValues kp, ki, kd;
+        JointValues max_velocity, max_acceleration;
+        Scalar dt = Scalar(0.01);
+        Scalar duration = 5;                // simulated seconds
+        Scalar tolerance = Scalar(0.001);   // rad
+        Scalar keep = Scalar(0.95);         // velocity kept per tick
+        bool feedforward = true;            // off leaves tracking to PID alone
+        JointValues output_limit;           // on the PID's output
+        const Dynamics<N, Scalar>* dynamics = nullptr;   // rigid-body plant, if set
+        int substeps = 100;                               // per tick, on the rigid-body plant
+
+        // The demos' gains and move limits
+        Settings() {
+            kp.fill(Scalar(5.0));
+            ki.fill(Scalar(0.1));
+            kd.fill(Scalar(0.5));
+            max_velocity.fill(Scalar(1.5));
+            max_acceleration.fill(Scalar(3.0));
+            output_limit.fill(std::numeric_limits<Scalar>::infinity());
+        }
+    };
+
+    struct Outcome {
+        JointValues final_angles;
+        Scalar move_time;
+        Scalar settling_time;   // negative when it never settled
+        Scalar overshoot;       // rad, worst joint
+        Scalar final_error;     // rad from the goal at the end, worst joint
+    };
+
+    static Outcome run(const Settings& settings, const JointValues& start, const JointValues& goal) {
+        PIDBank<N, Scalar> pids;
+        pids.kp = settings.kp;
+        pids.ki = settings.ki;
+        pids.kd = settings.kd;
+        pids.output_limit = settings.output_limit;
+
+        Trajectory<N, Scalar> move;
+        Outcome out;
+        out.move_time = move.plan(start, goal, settings.max_velocity, settings.max_acceleration);
+        out.settling_time = 0;
+        out.overshoot = 0;
+
+        const Scalar dt = settings.dt;
+        const int ticks = (int)std::lround(settings.duration / dt);
+        JointValues theta = start, vel, direction;
+        vel.fill(0);
+        for (int j = 0; j < N; j++) direction[j] = goal[j] >= start[j] ? Scalar(1) : Scalar(-1);
+
+        // Samples roll forward so each tick costs one trajectory sample
+        typename Trajectory<N, Scalar>::Setpoint prev = move.sample(-dt), now = move.sample(0), next;
+        for (int tick = 0; tick < ticks; tick++) {
+            Scalar t = tick * dt;
+            next = move.sample(t + dt);
+
+            JointValues control;
+            pids.compute(theta, now.position, dt, control);
+            if (settings.dynamics) {
+                JointValues wanted;
+                for (int j = 0; j < N; j++) {
+                    Scalar accel = (next.position[j] - 2 * now.position[j] + prev.position[j]) / (dt * dt);
+                    wanted[j] = control[j] + (settings.feedforward ? accel : 0);
+                }
+                JointValues tau = settings.dynamics->inverse(theta, vel, wanted);
+                typename Dynamics<N, Scalar>::State state{theta, vel};
+                for (int s = 0; s < settings.substeps; s++) settings.dynamics->step(state, tau, dt / settings.substeps);
+                theta = state.position;
+                vel = state.velocity;
+            } else {
+                for (int j = 0; j < N; j++) {
+                    Scalar vel_in = (now.position[j] - prev.position[j]) / dt;
+                    Scalar vel_out = (next.position[j] - now.position[j]) / dt;
+                    Scalar feedforward = settings.feedforward ? (vel_out / settings.keep - vel_in) / dt : 0;
+                    vel[j] = (vel[j] + (control[j] + feedforward) * dt) * settings.keep;
+                    theta[j] += vel[j] * dt;
+                }
+            }
+
+            Scalar worst = 0;
+            for (int j = 0; j < N; j++) {
+                Scalar past = direction[j] * (theta[j] - goal[j]);
+                out.overshoot = std::max(out.overshoot, past);
+                worst = std::max(worst, std::fabs(past));
+            }
+            // Out of the band: not settled before the end of this tick
+            if (worst >= settings.tolerance) out.settling_time = t + dt;
+
+            prev = now;
+            now = next;
+        }
+
+        out.final_angles = theta;
+        out.final_error = 0;
+        for (int j = 0; j < N; j++) out.final_error = std::max(out.final_error, std::fabs(theta[j] - goal[j]));
+        if (out.final_error >= settings.tolerance) out.settling_time = -1;
+        return out;
+    }
+};
+
+#endif
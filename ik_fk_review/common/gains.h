@@ -0,0 +1,106 @@
+#ifndef GAINS_H
+#define GAINS_H
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// PID gains per joint kept in a text file, so tuned values reach the demos
+// without a rebuild. tools/tune writes it and the mains read it.
+//
+// One joint per line, # starts a comment:
+//
+//   gains <arm> <joint> <kp> <ki> <kd> [limit]
+//
+// arm is single, double or triple and joints count from 0 at the base.
+// limit is the clamp on the PID output the gains were tuned with
+// (PIDBank::output_limit); without it the output isn't clamped.
+
+// Reads the lines for arm into kp, ki, kd and limit; joints with no line
+// keep what they had. Returns false, leaving everything as it was, if the
+// file can't be opened or a line can't be read.
+template <int N, typename Scalar>
+bool loadGains(const std::string& path, const std::string& arm,
+               std::array<Scalar, N>& kp, std::array<Scalar, N>& ki, std::array<Scalar, N>& kd,
+               std::array<Scalar, N>& limit) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::array<Scalar, N> p = kp, i = ki, d = kd, u = limit;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream in(line);
+        std::string kind, name;
+        if (!(in >> kind)) continue;
+        int joint;
+        Scalar gp, gi, gd, gu = std::numeric_limits<Scalar>::infinity();
+        if (kind != "gains" || !(in >> name >> joint >> gp >> gi >> gd) ||
+            (!(in >> std::ws).eof() && !(in >> gu))) {
+            std::cerr << path << ":" << line_number << ": can't read \"" << line << "\"\n";
+            return false;
+        }
+        if (name != arm || joint < 0 || joint >= N) continue;
+        p[joint] = gp;
+        i[joint] = gi;
+        d[joint] = gd;
+        u[joint] = gu;
+    }
+    kp = p;
+    ki = i;
+    kd = d;
+    limit = u;
+    return true;
+}
+
+// The gains file the mains load: gains.cfg next to the arm directories,
+// found from the executable's path so it reads the same file whichever
+// directory the demo is started from
+inline std::string gainsFileFor(const char* argv0) {
+    std::string exe = argv0;
+    size_t slash = exe.rfind('/');
+    return (slash == std::string::npos ? std::string(".") : exe.substr(0, slash)) + "/../gains.cfg";
+}
+
+// Replaces arm's lines in the file (creating it if need be), keeping
+// every other line as it was. Infinite limits aren't written.
+template <int N, typename Scalar>
+bool saveGains(const std::string& path, const std::string& arm, const std::string& comment,
+               const std::array<Scalar, N>& kp, const std::array<Scalar, N>& ki, const std::array<Scalar, N>& kd,
+               const std::array<Scalar, N>& limit) {
+    std::vector<std::string> kept;
+    std::ifstream old(path);
+    std::string line;
+    while (std::getline(old, line)) {
+        std::istringstream in(line);
+        std::string kind, name;
+        if (in >> kind >> name && kind == "gains" && name == arm) continue;
+        if (line.rfind("# " + arm + ":", 0) == 0) continue;   // its old comment
+        kept.push_back(line);
+    }
+    old.close();
+
+    std::ofstream file(path);
+    if (!file) return false;
+    if (kept.empty()) file << "# PID gains per joint, see common/gains.h\n";
+    for (const std::string& l : kept) file << l << "\n";
+    if (!comment.empty()) file << "# " << arm << ": " << comment << "\n";
+    file.precision(6);
+    for (int j = 0; j < N; j++) {
+        file << "gains " << arm << " " << j << " " << kp[j] << " " << ki[j] << " " << kd[j];
+        if (std::isfinite(limit[j])) file << " " << limit[j];
+        file << "\n";
+    }
+    return (bool)file;
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef IK_SOLVER_H
+#define IK_SOLVER_H
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "kinematics.h"
+#include "least_squares.h"
+
+// Numerical inverse kinematics for any number of joints, by damped least
+// squares on the analytic Jacobian:
+//
+//     step = J^T (J J^T + damping^2 I)^-1 error
+//
+// The damping keeps steps finite near singularities and for targets out
+// of reach, where the arm ends up as close as it can get. It is adapted
+// as in Levenberg-Marquardt: halved after a step that works first time,
+// doubled when a step has to be cut back. Each solve starts from the
+// joint state it is given, so at control rate a moving target is usually
+// met in one or two iterations.
+//
+// Joint limits: a joint whose step would cross its limit is stopped at
+// the limit and the rest of the step is re-solved without it.
+//
+// Redundancy: when there are more joints than the task needs (e.g. three
+// joints and a position-only target) a converged solve then takes one
+// step towards the rest posture, projected into the Jacobian's null
+// space, and corrects the end effector again. Each solve only moves part
+// of the way there; called every control step the arm settles into it.
+
+template <int N, typename Scalar = double>
+class IKSolver {
+public:
+    typedef typename Kinematics<N, Scalar>::JointAngles JointAngles;
+
+    struct Result {
+        JointAngles angles;
+        int iterations;
+        Scalar error;       // task-space distance left (position, plus angle if given)
+        bool converged;     // error under tolerance
+    };
+
+    Kinematics<N, Scalar> arm;
+
+    JointAngles lower, upper;   // joint limits, unlimited by default
+    JointAngles rest;           // preferred posture for redundant joints
+
+    Scalar damping = Scalar(0.05);     // starting damping, m
+    Scalar tolerance = Scalar(1e-6);
+    int max_iterations = 50;
+    Scalar max_step = Scalar(0.5);     // largest joint change per iteration, rad
+    Scalar null_gain = Scalar(0.2);    // fraction of the way to rest per iteration
+
+    IKSolver(const Kinematics<N, Scalar>& kinematics) : arm(kinematics) {
+        lower.fill(-std::numeric_limits<Scalar>::infinity());
+        upper.fill(std::numeric_limits<Scalar>::infinity());
+        rest.fill(0);
+    }
+
+    // End effector to target, any orientation
+    Result solve(Point<Scalar> target, const JointAngles& start) const {
+        std::array<Scalar, 3> goal = {{target.x, target.y, 0}};
+        return solveTask<2>(goal, start);
+    }
+
+    // End effector to target with the last link at absolute angle phi
+    Result solve(Point<Scalar> target, Scalar phi, const JointAngles& start) const {
+        std::array<Scalar, 3> goal = {{target.x, target.y, phi}};
+        return solveTask<3>(goal, start);
+    }
+
+private:
+    // M is the task size: 2 for position, 3 with the end angle
+    template <int M>
+    Result solveTask(const std::array<Scalar, 3>& goal, const JointAngles& start) const {
+        Result result;
+        result.angles = start;
+        for (int j = 0; j < N; j++) {
+            result.angles[j] = std::min(upper[j], std::max(lower[j], result.angles[j]));
+        }
+        result.iterations = 0;
+        refine<M>(goal, result);
+
+        if (N > M && null_gain > 0 && result.converged) {
+            Result pulled = result;
+            pullToRest<M>(goal, pulled.angles);
+            refine<M>(goal, pulled);
+            if (pulled.converged) {
+                result = pulled;
+            } else {
+                result.iterations = pulled.iterations;
+            }
+        }
+        return result;
+    }
+
+    // Levenberg-Marquardt iterations from result.angles
+    template <int M>
+    void refine(const std::array<Scalar, 3>& goal, Result& result) const {
+        auto task = [&](const JointAngles& angles, std::array<Scalar, M>& error,
+                        std::array<std::array<Scalar, N>, M>* J) {
+            return taskError<M>(goal, angles, error, J);
+        };
+        result.error = dampedRefine<M, N, Scalar>(*this, task, result.angles, result.iterations);
+        result.converged = result.error <= tolerance;
+    }
+
+    // Move towards rest without moving the end effector, to first order:
+    // z - J^T (J J^T)^-1 J z. Only a token damping here, as the task
+    // step's damping would let some of the pull leak into the end effector.
+    template <int M>
+    void pullToRest(const std::array<Scalar, 3>& goal, JointAngles& angles) const {
+        std::array<Scalar, M> error;
+        std::array<std::array<Scalar, N>, M> J;
+        taskError<M>(goal, angles, error, &J);
+
+        std::array<std::array<Scalar, M>, M> JJt;
+        for (int r = 0; r < M; r++) {
+            for (int c = 0; c < M; c++) {
+                Scalar sum = 0;
+                for (int j = 0; j < N; j++) sum += J[r][j] * J[c][j];
+                JJt[r][c] = sum;
+            }
+            JJt[r][r] += Scalar(1e-9);
+        }
+        cholesky<M>(JJt);
+
+        JointAngles z;
+        std::array<Scalar, M> v;
+        for (int j = 0; j < N; j++) z[j] = null_gain * (rest[j] - angles[j]);
+        for (int i = 0; i < M; i++) {
+            v[i] = 0;
+            for (int j = 0; j < N; j++) v[i] += J[i][j] * z[j];
+        }
+        cholSolve<M>(JJt, v);
+        for (int j = 0; j < N; j++) {
+            Scalar projected = z[j];
+            for (int i = 0; i < M; i++) projected -= J[i][j] * v[i];
+            angles[j] = std::min(upper[j], std::max(lower[j], angles[j] + projected));
+        }
+    }
+
+    // Error (goal - current) and optionally the Jacobian at angles.
+    // Returns the error's length.
+    template <int M>
+    Scalar taskError(const std::array<Scalar, 3>& goal, const JointAngles& angles,
+                     std::array<Scalar, M>& error, std::array<std::array<Scalar, N>, M>* J) const {
+        typename Kinematics<N, Scalar>::Result joints = arm.forward(angles);
+        Point<Scalar> end = joints[N - 1];
+
+        error[0] = goal[0] - end.x;
+        error[1] = goal[1] - end.y;
+        if constexpr (M == 3) {
+            Scalar phi = 0;
+            for (int j = 0; j < N; j++) phi += angles[j];
+            error[2] = std::remainder(goal[2] - phi, Scalar(2 * M_PI));
+        }
+
+        if (J) {
+            typename Kinematics<N, Scalar>::Jacobian full = arm.jacobian(joints);
+            for (int r = 0; r < M; r++) (*J)[r] = full[r];
+        }
+
+        Scalar sum = 0;
+        for (int i = 0; i < M; i++) sum += error[i] * error[i];
+        return std::sqrt(sum);
+    }
+};
+
+#endif
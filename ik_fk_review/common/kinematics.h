@@ -0,0 +1,254 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+// Planar arm with N revolute joints, shared by the Single, Double and
+// Triple joint demos.
+//
+// Each angle is relative to the link before it (the first one to the x
+// axis). Forward kinematics is unrolled at compile time and carries the
+// running link direction as a cos/sin pair, turning it by each joint in
+// turn rather than taking cos/sin of the angle sums. Everything is in
+// fixed-size arrays, so nothing touches the heap.
+//
+// inverse() gives the elbow-down answer; inverseAll() gives every branch
+// and nearest() picks the one closest to the arm's current state.
+
+template <typename Scalar>
+struct Point {
+    Scalar x, y;
+};
+
+typedef Point<double> Position;
+
+template <int N, typename Scalar = double>
+class Kinematics {
+    static_assert(N >= 1, "Kinematics needs at least one joint");
+
+public:
+    typedef std::array<Scalar, N> JointAngles;
+    typedef std::array<Point<Scalar>, N> Result;   // end of each link, base outwards
+    typedef std::array<std::array<Scalar, N>, 3> Jacobian;   // rows x, y, end-link angle
+
+    // Every analytic solution for one target: none out of reach, else one
+    // per elbow branch (just one when they coincide, or for one joint)
+    struct Solutions {
+        std::array<JointAngles, 2> angles;
+        int count = 0;
+
+        int size() const { return count; }
+        bool empty() const { return count == 0; }
+        const JointAngles& operator[](int i) const { return angles[i]; }
+        const JointAngles* begin() const { return angles.data(); }
+        const JointAngles* end() const { return angles.data() + count; }
+    };
+
+    std::array<Scalar, N> lengths;
+
+    Kinematics(const std::array<Scalar, N>& link_lengths) : lengths(link_lengths) {}
+
+    // Kinematics<3> robot(2.0, 1.0, 0.5);
+    template <typename... Lengths>
+    Kinematics(Scalar first, Lengths... rest) : lengths{{first, Scalar(rest)...}} {
+        static_assert(sizeof...(Lengths) == N - 1, "one length per joint");
+    }
+
+    // Forward: angles -> position of every joint
+    Result forward(const JointAngles& theta) const {
+        Result joints;
+        forwardLinks(theta, joints, std::make_integer_sequence<int, N>());
+        return joints;
+    }
+
+    Point<Scalar> endEffector(const JointAngles& theta) const {
+        return forward(theta)[N - 1];
+    }
+
+    Scalar reach() const {
+        Scalar total = 0;
+        for (Scalar length : lengths) total += length;
+        return total;
+    }
+
+    // End-effector velocity and end-link turn rate per unit joint rate:
+    // joint j swings the end effector about its own base
+    Jacobian jacobian(const JointAngles& theta) const {
+        return jacobian(forward(theta));
+    }
+
+    // The same from joint positions forward() already gave
+    Jacobian jacobian(const Result& joints) const {
+        Jacobian J;
+        for (int j = 0; j < N; j++) {
+            Scalar bx = j ? joints[j - 1].x : 0;
+            Scalar by = j ? joints[j - 1].y : 0;
+            J[0][j] = by - joints[N - 1].y;
+            J[1][j] = joints[N - 1].x - bx;
+            J[2][j] = 1;
+        }
+        return J;
+    }
+
+    // Inverse: position -> angles, for one and two joints
+    JointAngles inverse(Point<Scalar> target) const {
+        static_assert(N <= 2, "three joints also need the end effector angle");
+        JointAngles angles;
+        if constexpr (N == 1) {
+            angles[0] = std::atan2(target.y, target.x);
+        } else {
+            twoLink(target.x, target.y, angles[0], angles[1]);
+        }
+        return angles;
+    }
+
+    // Inverse for three joints, with phi the absolute angle of the last link
+    JointAngles inverse(Point<Scalar> target, Scalar phi) const {
+        static_assert(N == 3, "end effector angle only applies to three joints");
+        JointAngles angles;
+
+        // Back off from the target along phi to where the wrist must be
+        Scalar x_wrist = target.x - lengths[2] * std::cos(phi);
+        Scalar y_wrist = target.y - lengths[2] * std::sin(phi);
+
+        // Out of reach leaves the whole arm straight
+        if (twoLink(x_wrist, y_wrist, angles[0], angles[1])) {
+            angles[2] = phi - angles[0] - angles[1];
+        } else {
+            angles[2] = 0;
+        }
+        return angles;
+    }
+
+    // All branches for one and two joints
+    Solutions inverseAll(Point<Scalar> target) const {
+        static_assert(N <= 2, "three joints also need the end effector angle");
+        Solutions out;
+        if constexpr (N == 1) {
+            out.angles[0][0] = std::atan2(target.y, target.x);
+            out.count = 1;
+        } else {
+            Scalar theta1[2], theta2[2];
+            out.count = twoLinkBranches(target.x, target.y, theta1, theta2);
+            for (int i = 0; i < out.count; i++) out.angles[i] = JointAngles{{theta1[i], theta2[i]}};
+        }
+        return out;
+    }
+
+    // All branches for three joints with the last link at phi
+    Solutions inverseAll(Point<Scalar> target, Scalar phi) const {
+        static_assert(N == 3, "end effector angle only applies to three joints");
+        Solutions out;
+        Scalar x_wrist = target.x - lengths[2] * std::cos(phi);
+        Scalar y_wrist = target.y - lengths[2] * std::sin(phi);
+        Scalar theta1[2], theta2[2];
+        out.count = twoLinkBranches(x_wrist, y_wrist, theta1, theta2);
+        for (int i = 0; i < out.count; i++) {
+            out.angles[i] = JointAngles{{theta1[i], theta2[i], phi - theta1[i] - theta2[i]}};
+        }
+        return out;
+    }
+
+    // The solution needing the least motion from current, measured as
+    // sum of weight * change^2. Each joint is taken a whole number of
+    // turns towards current first, so the answer may lie outside
+    // [-pi, pi] but is never more than half a turn away per joint.
+    // Returns current if there are no solutions.
+    static JointAngles nearest(const Solutions& solutions, const JointAngles& current,
+                               const JointAngles& weights) {
+        JointAngles best = current;
+        Scalar best_cost = 0;
+        for (int i = 0; i < solutions.count; i++) {
+            JointAngles candidate;
+            Scalar cost = 0;
+            for (int j = 0; j < N; j++) {
+                Scalar change = std::remainder(solutions[i][j] - current[j], Scalar(2 * M_PI));
+                candidate[j] = current[j] + change;
+                cost += weights[j] * change * change;
+            }
+            if (i == 0 || cost < best_cost) {
+                best = candidate;
+                best_cost = cost;
+            }
+        }
+        return best;
+    }
+
+    static JointAngles nearest(const Solutions& solutions, const JointAngles& current) {
+        JointAngles weights;
+        weights.fill(1);
+        return nearest(solutions, current, weights);
+    }
+
+private:
+    template <int... I>
+    void forwardLinks(const JointAngles& theta, Result& joints, std::integer_sequence<int, I...>) const {
+        Scalar c = 1, s = 0;   // direction of the current link
+        Scalar x = 0, y = 0;
+        (addLink(I, theta[I], c, s, x, y, joints), ...);
+    }
+
+    void addLink(int i, Scalar angle, Scalar& c, Scalar& s, Scalar& x, Scalar& y, Result& joints) const {
+        Scalar ci = std::cos(angle), si = std::sin(angle);
+        Scalar turned = c * ci - s * si;
+        s = s * ci + c * si;
+        c = turned;
+        x += lengths[i] * c;
+        y += lengths[i] * s;
+        joints[i] = Point<Scalar>{x, y};
+    }
+
+    // First two links to (x, y), elbow down. Out of reach points the arm
+    // straight at the target and returns false.
+    bool twoLink(Scalar x, Scalar y, Scalar& theta1, Scalar& theta2) const {
+        Scalar L1 = lengths[0], L2 = lengths[1];
+
+        // Euclidean distance to target
+        Scalar dist = std::sqrt(x*x + y*y);
+
+        // Check if target is within max len
+        if (dist > L1 + L2 || dist < std::fabs(L1 - L2)) {
+            theta1 = std::atan2(y, x);
+            theta2 = 0;
+            return false;
+        }
+
+        // Law of cosines to find theta2
+        // Rounding can put it just past +-1 at full stretch or fold
+        Scalar cos_theta2 = (dist*dist - L1*L1 - L2*L2) / (2*L1*L2);
+        theta2 = std::acos(std::min(Scalar(1), std::max(Scalar(-1), cos_theta2)));
+
+        // Find theta1
+        Scalar beta = std::atan2(y, x);
+        Scalar alpha = std::atan2(L2*std::sin(theta2), L1 + L2*std::cos(theta2));
+        theta1 = beta - alpha;
+        return true;
+    }
+
+    // Both elbow branches for the first two links, elbow down first.
+    // Returns how many there are: 0 out of reach, 1 when fully stretched
+    // or folded, else 2.
+    int twoLinkBranches(Scalar x, Scalar y, Scalar theta1[2], Scalar theta2[2]) const {
+        Scalar L1 = lengths[0], L2 = lengths[1];
+        Scalar dist = std::sqrt(x*x + y*y);
+        if (dist > L1 + L2 || dist < std::fabs(L1 - L2)) return 0;
+
+        Scalar cos_theta2 = (dist*dist - L1*L1 - L2*L2) / (2*L1*L2);
+        Scalar elbow = std::acos(std::min(Scalar(1), std::max(Scalar(-1), cos_theta2)));
+        Scalar beta = std::atan2(y, x);
+        Scalar along = L1 + L2*cos_theta2;
+        Scalar across = L2*std::sin(elbow);
+
+        theta2[0] = elbow;
+        theta1[0] = beta - std::atan2(across, along);
+        if (elbow == 0 || elbow == Scalar(M_PI)) return 1;
+        theta2[1] = -elbow;
+        theta1[1] = beta + std::atan2(across, along);
+        return 2;
+    }
+};
+
+#endif
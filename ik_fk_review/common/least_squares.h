@@ -0,0 +1,154 @@
+#ifndef LEAST_SQUARES_H
+#define LEAST_SQUARES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// The damped least-squares iteration the IK solvers share, for an M-row
+// task Jacobian over N joints. Fixed-size arrays throughout; M is small
+// (2 or 3 for the planar arms, 3 or 6 in space), so the M x M system is
+// solved directly by Cholesky.
+//
+//     step = J^T (J J^T + lambda^2 I)^-1 error
+
+// In place, lower triangle
+template <int M, typename Scalar>
+void cholesky(std::array<std::array<Scalar, M>, M>& A) {
+    for (int c = 0; c < M; c++) {
+        for (int k = 0; k < c; k++) A[c][c] -= A[c][k] * A[c][k];
+        A[c][c] = std::sqrt(A[c][c]);
+        for (int r = c + 1; r < M; r++) {
+            for (int k = 0; k < c; k++) A[r][c] -= A[r][k] * A[c][k];
+            A[r][c] /= A[c][c];
+        }
+    }
+}
+
+template <int M, typename Scalar>
+void cholSolve(const std::array<std::array<Scalar, M>, M>& L, std::array<Scalar, M>& b) {
+    for (int r = 0; r < M; r++) {
+        for (int k = 0; k < r; k++) b[r] -= L[r][k] * b[k];
+        b[r] /= L[r][r];
+    }
+    for (int r = M - 1; r >= 0; r--) {
+        for (int k = r + 1; k < M; k++) b[r] -= L[k][r] * b[k];
+        b[r] /= L[r][r];
+    }
+}
+
+template <int M, int N, typename Scalar>
+std::array<Scalar, N> dampedStep(const std::array<std::array<Scalar, N>, M>& J, const std::array<Scalar, M>& error,
+                                 Scalar lambda) {
+    // A = J J^T + lambda^2 I
+    std::array<std::array<Scalar, M>, M> A;
+    for (int r = 0; r < M; r++) {
+        for (int c = 0; c < M; c++) {
+            Scalar sum = 0;
+            for (int j = 0; j < N; j++) sum += J[r][j] * J[c][j];
+            A[r][c] = sum;
+        }
+        A[r][r] += lambda * lambda;
+    }
+    cholesky<M>(A);
+
+    std::array<Scalar, M> u = error;
+    cholSolve<M>(A, u);
+    std::array<Scalar, N> step;
+    for (int j = 0; j < N; j++) {
+        step[j] = 0;
+        for (int i = 0; i < M; i++) step[j] += J[i][j] * u[i];
+    }
+    return step;
+}
+
+// Damped least-squares step, re-solved with any joint that would pass
+// its limit held at the limit
+template <int M, int N, typename Scalar>
+std::array<Scalar, N> limitedStep(std::array<std::array<Scalar, N>, M> J, std::array<Scalar, M> error,
+                                  const std::array<Scalar, N>& angles, const std::array<Scalar, N>& lower,
+                                  const std::array<Scalar, N>& upper, Scalar lambda) {
+    std::array<Scalar, N> step, held_step;
+    std::array<bool, N> locked;
+    locked.fill(false);
+    held_step.fill(0);
+
+    for (int pass = 0; pass <= N; pass++) {
+        step = dampedStep<M, N>(J, error, lambda);
+
+        bool changed = false;
+        for (int j = 0; j < N; j++) {
+            if (locked[j]) continue;
+            Scalar target = angles[j] + step[j];
+            if (target >= lower[j] && target <= upper[j]) continue;
+
+            // Hold it at the limit and take its motion out of the task
+            locked[j] = true;
+            changed = true;
+            Scalar held = std::min(upper[j], std::max(lower[j], target)) - angles[j];
+            for (int i = 0; i < M; i++) {
+                error[i] -= J[i][j] * held;
+                J[i][j] = 0;
+            }
+            held_step[j] = held;
+        }
+        if (!changed) break;
+    }
+
+    for (int j = 0; j < N; j++) {
+        if (locked[j]) step[j] = held_step[j];
+    }
+    return step;
+}
+
+// Levenberg-Marquardt iterations from angles, for a task given as
+// task(angles, error, J): fills error (goal - current) and, if J isn't
+// null, the task Jacobian, and returns the error's length. The solver
+// supplies damping, tolerance, max_iterations, max_step and the joint
+// limits lower and upper. The damping is halved after a step that works
+// first time and doubled when a step has to be cut back. Adds the
+// iterations taken to iterations; returns the error left.
+template <int M, int N, typename Scalar, typename Solver, typename Task>
+Scalar dampedRefine(const Solver& solver, const Task& task, std::array<Scalar, N>& angles, int& iterations) {
+    std::array<Scalar, M> error;
+    std::array<std::array<Scalar, N>, M> J;
+    Scalar norm = task(angles, error, &J);
+    Scalar lambda = solver.damping;
+
+    while (norm > solver.tolerance && iterations < solver.max_iterations) {
+        iterations++;
+
+        std::array<Scalar, N> step = limitedStep<M, N>(J, error, angles, solver.lower, solver.upper, lambda);
+        Scalar largest = 0;
+        for (int j = 0; j < N; j++) largest = std::max(largest, std::fabs(step[j]));
+        if (largest > solver.max_step) {
+            for (int j = 0; j < N; j++) step[j] *= solver.max_step / largest;
+        }
+        if (largest < Scalar(1e-12)) break;   // stuck against limits or out of reach
+
+        // Halve the step until it helps
+        std::array<Scalar, N> trial;
+        std::array<Scalar, M> trial_error;
+        Scalar trial_norm = norm;
+        int halvings = 0;
+        for (; halvings < 8; halvings++) {
+            for (int j = 0; j < N; j++) trial[j] = angles[j] + step[j];
+            trial_norm = task(trial, trial_error, nullptr);
+            if (trial_norm < norm) break;
+            for (int j = 0; j < N; j++) step[j] *= Scalar(0.5);
+        }
+        if (trial_norm >= norm) break;   // no step helps: closest reachable
+        lambda = (halvings == 0) ? std::max(lambda * Scalar(0.5), solver.damping * Scalar(1e-3))
+                                 : std::min(lambda * 2, solver.damping * 100);
+
+        // Out of reach the error stops shrinking long before it is small
+        Scalar gain = norm - trial_norm;
+        angles = trial;
+        norm = task(angles, error, &J);
+        if (gain < solver.tolerance * Scalar(0.01)) break;
+    }
+
+    return norm;
+}
+
+#endif
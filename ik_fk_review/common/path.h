@@ -0,0 +1,189 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "kinematics.h"
+
+// End-effector paths made of straight lines, circular arcs and smooth
+// curves through waypoints, for the arm to follow at a steady speed.
+//
+// A path starts at a pose and each call appends a piece from wherever
+// the path currently ends. Every piece carries an end-link angle phi
+// (used by the three joint arm), which turns evenly along the piece.
+// sample() takes a distance along the path, so stepping it by
+// speed * dt gives constant end-effector speed whatever the pieces are.
+
+template <typename Scalar>
+struct Pose {
+    Point<Scalar> position;
+    Scalar phi;
+};
+
+template <typename Scalar = double>
+class Path {
+public:
+    explicit Path(Pose<Scalar> start) : first(start) {}
+
+    // Straight to end, phi turning to end.phi
+    Path& lineTo(Pose<Scalar> end) {
+        Piece piece;
+        piece.kind = LINE;
+        piece.from = last();
+        piece.to = end;
+        piece.length = std::hypot(end.position.x - piece.from.position.x,
+                                  end.position.y - piece.from.position.y);
+        add(piece);
+        return *this;
+    }
+
+    // Round centre by sweep radians (positive is anticlockwise), phi
+    // turning by the same amount so the end link keeps its angle to the
+    // radius
+    Path& arc(Point<Scalar> centre, Scalar sweep) {
+        Piece piece;
+        piece.kind = ARC;
+        piece.from = last();
+        piece.centre = centre;
+        Scalar dx = piece.from.position.x - centre.x, dy = piece.from.position.y - centre.y;
+        piece.radius = std::hypot(dx, dy);
+        piece.start_angle = std::atan2(dy, dx);
+        piece.sweep = sweep;
+        piece.length = piece.radius * std::fabs(sweep);
+        piece.to.position = {centre.x + piece.radius * std::cos(piece.start_angle + sweep),
+                             centre.y + piece.radius * std::sin(piece.start_angle + sweep)};
+        piece.to.phi = piece.from.phi + sweep;
+        add(piece);
+        return *this;
+    }
+
+    // Catmull-Rom curve through each waypoint in turn, leaving and
+    // arriving along the line to the neighbouring points
+    Path& curveThrough(const std::vector<Pose<Scalar>>& waypoints) {
+        for (size_t i = 0; i < waypoints.size(); i++) {
+            Piece piece;
+            piece.kind = CURVE;
+            piece.from = last();
+            piece.to = waypoints[i];
+            Point<Scalar> before = (i >= 2) ? waypoints[i - 2].position : previousStart();
+            Point<Scalar> after = (i + 1 < waypoints.size()) ? waypoints[i + 1].position : piece.to.position;
+            // Tangents for a uniform Catmull-Rom: half the chord either side
+            piece.tangent_from = {(piece.to.position.x - before.x) / 2, (piece.to.position.y - before.y) / 2};
+            piece.tangent_to = {(after.x - piece.from.position.x) / 2, (after.y - piece.from.position.y) / 2};
+            measureCurve(piece);
+            add(piece);
+        }
+        return *this;
+    }
+
+    Scalar length() const {
+        return pieces.empty() ? Scalar(0) : pieces.back().end_distance;
+    }
+
+    Pose<Scalar> start() const { return first; }
+    Pose<Scalar> end() const { return last(); }
+
+    // Pose at distance along the path, clamped to its ends
+    Pose<Scalar> sample(Scalar distance) const {
+        if (pieces.empty() || distance <= 0) return first;
+        if (distance >= length()) return last();
+
+        // Pieces are in order of distance
+        size_t i = cursor < pieces.size() && pieces[cursor].end_distance - pieces[cursor].length <= distance
+                 ? cursor : 0;
+        while (pieces[i].end_distance < distance) i++;
+        cursor = i;
+
+        const Piece& piece = pieces[i];
+        Scalar into = distance - (piece.end_distance - piece.length);
+        Scalar u = piece.length > 0 ? into / piece.length : Scalar(1);
+        Pose<Scalar> pose;
+        pose.phi = piece.from.phi + u * (piece.to.phi - piece.from.phi);
+
+        switch (piece.kind) {
+        case LINE:
+            pose.position = {piece.from.position.x + u * (piece.to.position.x - piece.from.position.x),
+                             piece.from.position.y + u * (piece.to.position.y - piece.from.position.y)};
+            break;
+        case ARC: {
+            Scalar angle = piece.start_angle + u * piece.sweep;
+            pose.position = {piece.centre.x + piece.radius * std::cos(angle),
+                             piece.centre.y + piece.radius * std::sin(angle)};
+            break;
+        }
+        case CURVE:
+            pose.position = hermite(piece, curveParameter(piece, into));
+            break;
+        }
+        return pose;
+    }
+
+private:
+    enum Kind { LINE, ARC, CURVE };
+
+    // Arc length table resolution for curves
+    static const int CURVE_STEPS = 32;
+
+    struct Piece {
+        Kind kind;
+        Pose<Scalar> from, to;
+        Scalar length = 0;
+        Scalar end_distance = 0;   // distance along the path at the piece's end
+
+        Point<Scalar> centre;      // arcs
+        Scalar radius = 0, start_angle = 0, sweep = 0;
+
+        Point<Scalar> tangent_from, tangent_to;   // curves
+        Scalar arc_length[CURVE_STEPS + 1];        // curves: length up to step k
+    };
+
+    Pose<Scalar> first;
+    std::vector<Piece> pieces;
+    mutable size_t cursor = 0;   // last piece sampled, as samples usually move forward
+
+    Pose<Scalar> last() const {
+        return pieces.empty() ? first : pieces.back().to;
+    }
+
+    // Where the last piece began, for curve tangents
+    Point<Scalar> previousStart() const {
+        return pieces.empty() ? first.position : pieces.back().from.position;
+    }
+
+    void add(Piece& piece) {
+        piece.end_distance = length() + piece.length;
+        pieces.push_back(piece);
+    }
+
+    static Point<Scalar> hermite(const Piece& piece, Scalar u) {
+        Scalar u2 = u * u, u3 = u2 * u;
+        Scalar h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u;
+        Scalar h01 = -2 * u3 + 3 * u2, h11 = u3 - u2;
+        return {h00 * piece.from.position.x + h10 * piece.tangent_from.x + h01 * piece.to.position.x + h11 * piece.tangent_to.x,
+                h00 * piece.from.position.y + h10 * piece.tangent_from.y + h01 * piece.to.position.y + h11 * piece.tangent_to.y};
+    }
+
+    static void measureCurve(Piece& piece) {
+        Point<Scalar> previous = piece.from.position;
+        piece.arc_length[0] = 0;
+        for (int k = 1; k <= CURVE_STEPS; k++) {
+            Point<Scalar> p = hermite(piece, Scalar(k) / CURVE_STEPS);
+            piece.arc_length[k] = piece.arc_length[k - 1] + std::hypot(p.x - previous.x, p.y - previous.y);
+            previous = p;
+        }
+        piece.length = piece.arc_length[CURVE_STEPS];
+    }
+
+    // Curve parameter at a distance into the piece, from the length table
+    static Scalar curveParameter(const Piece& piece, Scalar into) {
+        const Scalar* table = piece.arc_length;
+        int k = (int)(std::upper_bound(table, table + CURVE_STEPS + 1, into) - table) - 1;
+        k = std::min(CURVE_STEPS - 1, std::max(0, k));
+        Scalar span = table[k + 1] - table[k];
+        Scalar frac = span > 0 ? (into - table[k]) / span : Scalar(0);
+        return (k + frac) / CURVE_STEPS;
+    }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef PATH_FOLLOWER_H
+#define PATH_FOLLOWER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "kinematics.h"
+#include "ik_solver.h"
+#include "path.h"
+
+// Moves the end effector along a Path at constant speed, one control tick
+// per step(). Each tick samples the path speed * dt further on and solves
+// IK warm-started from the previous tick's answer, so a solve is usually
+// one or two iterations.
+//
+// Fallback near singularities: a stretched or folded arm needs huge joint
+// speeds for small end-effector motion, and IK may jump to another
+// branch. When the arm is close to singular (low manipulability) the
+// solve uses heavier damping, and any tick whose joint change exceeds
+// max_joint_speed * dt, or whose solve doesn't converge, is scaled down
+// to that limit. The arm then falls briefly behind the path instead of
+// flipping; step().fallback says when that happened.
+
+template <int N, typename Scalar = double>
+class PathFollower {
+public:
+    typedef typename Kinematics<N, Scalar>::JointAngles JointAngles;
+
+    struct Step {
+        JointAngles angles;        // joint setpoint for this tick
+        Pose<Scalar> target;       // where the path is this tick
+        Scalar error;              // end effector to target
+        int iterations;
+        bool near_singular;
+        bool fallback;             // joint change limited, arm off the path
+        double seconds;            // time spent in step()
+    };
+
+    IKSolver<N, Scalar> solver;
+    Scalar speed;                  // along the path, per second
+    Scalar dt;
+    bool use_phi;                  // follow the path's phi as well as position
+
+    Scalar max_joint_speed = Scalar(10);        // rad/s
+    Scalar singular_margin = Scalar(0.02);      // manipulability / reach^2 below this is near singular
+    Scalar singular_damping = Scalar(10);       // damping multiplier there
+
+    // The path must outlive the follower. start is the arm's current state.
+    PathFollower(const IKSolver<N, Scalar>& ik, const Path<Scalar>& to_follow, Scalar path_speed,
+                 Scalar tick, bool follow_phi, const JointAngles& start)
+        : solver(ik), speed(path_speed), dt(tick), use_phi(follow_phi), path(to_follow), current(start) {}
+
+    bool done() const { return distance >= path.length(); }
+    Scalar travelled() const { return distance; }
+    const JointAngles& angles() const { return current; }
+
+    Step step() {
+        auto begin = std::chrono::steady_clock::now();
+        Step out;
+        distance = std::min(path.length(), distance + speed * dt);
+        out.target = path.sample(distance);
+
+        Scalar reach = solver.arm.reach();
+        out.near_singular = manipulability(current) < singular_margin * reach * reach;
+
+        IKSolver<N, Scalar> ik = solver;
+        if (out.near_singular) ik.damping *= singular_damping;
+        typename IKSolver<N, Scalar>::Result r = use_phi
+            ? ik.solve(out.target.position, out.target.phi, current)
+            : ik.solve(out.target.position, current);
+        out.iterations = r.iterations;
+
+        Scalar largest = 0;
+        for (int j = 0; j < N; j++) largest = std::max(largest, std::fabs(r.angles[j] - current[j]));
+        Scalar limit = max_joint_speed * dt;
+        out.fallback = !r.converged || largest > limit;
+        Scalar scale = (largest > limit) ? limit / largest : Scalar(1);
+        for (int j = 0; j < N; j++) current[j] += scale * (r.angles[j] - current[j]);
+
+        Point<Scalar> end = solver.arm.endEffector(current);
+        out.error = std::hypot(end.x - out.target.position.x, end.y - out.target.position.y);
+        out.angles = current;
+        out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return out;
+    }
+
+private:
+    const Path<Scalar>& path;
+    JointAngles current;
+    Scalar distance = 0;
+
+    // sqrt(det(J J^T)) for the task being followed, zero when singular
+    Scalar manipulability(const JointAngles& theta) const {
+        typename Kinematics<N, Scalar>::Jacobian J = solver.arm.jacobian(theta);
+        // Rows: x, y, and phi (all ones) when followed
+        Scalar xx = 0, yy = 0, xy = 0, xp = 0, yp = 0;
+        for (int j = 0; j < N; j++) {
+            Scalar a = J[0][j], b = J[1][j];
+            xx += a * a;
+            yy += b * b;
+            xy += a * b;
+            xp += a;
+            yp += b;
+        }
+        if (N == 1 && !use_phi) return std::sqrt(xx + yy);   // one joint: |J|
+        Scalar det = xx * yy - xy * xy;
+        if (use_phi) {
+            Scalar pp = N;
+            det = xx * (yy * pp - yp * yp) - xy * (xy * pp - yp * xp) + xp * (xy * yp - yy * xp);
+        }
+        return std::sqrt(std::max(Scalar(0), det));
+    }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef PID_BANK_H
+#define PID_BANK_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// N PID controllers stepped together, for when every joint of every arm
+// in a cell runs its own loop.
+//
+// Gains and state are kept per field rather than per controller
+// (kp[0..N), integral[0..N), ...), and compute() is one pass over them
+// with no branches, so the compiler runs it several channels per SIMD
+// instruction (-O3, plus -march=native for AVX).
+//
+// With the defaults (no limits, no filter) each channel behaves like
+// PIDController, to rounding. Per channel there is also:
+//   output_limit       output is clamped to +-limit, and the integral is
+//                      not advanced while that clamp is pushing the same
+//                      way as the error (conditional-integration
+//                      anti-windup)
+//   integral_limit     the integral itself is clamped to +-limit
+//   derivative_smoothing  share of the previous derivative kept each tick,
+//                      a first-order low-pass: 0 is unfiltered, and a
+//                      time constant tau at tick dt is tau / (tau + dt).
+//                      Given per tick so compute() has no divisions.
+
+template <int N, typename Scalar = double>
+class PIDBank {
+public:
+    typedef std::array<Scalar, N> Values;
+    typedef std::array<uint8_t, N> Mask;
+
+    alignas(64) Values kp, ki, kd;
+    alignas(64) Values output_limit;
+    alignas(64) Values integral_limit;
+    alignas(64) Values derivative_smoothing;
+
+    PIDBank() {
+        setGains(0, 0, 0);
+        output_limit.fill(std::numeric_limits<Scalar>::infinity());
+        integral_limit.fill(std::numeric_limits<Scalar>::infinity());
+        derivative_smoothing.fill(0);
+        reset();
+    }
+
+    PIDBank(Scalar p, Scalar i, Scalar d) : PIDBank() {
+        setGains(p, i, d);
+    }
+
+    // Same gains on every channel
+    void setGains(Scalar p, Scalar i, Scalar d) {
+        kp.fill(p);
+        ki.fill(i);
+        kd.fill(d);
+    }
+
+    // output[c] from current[c] towards target[c]
+    void compute(const Values& current, const Values& target, Scalar dt, Values& output) {
+        const Scalar inv_dt = 1 / dt;
+        for (int c = 0; c < N; c++) {
+            Scalar error = target[c] - current[c];
+
+            Scalar advanced = integral[c] + error * dt;
+            advanced = std::min(integral_limit[c], std::max(-integral_limit[c], advanced));
+
+            Scalar raw = (error - prev_error[c]) * inv_dt;
+            Scalar derivative = raw + derivative_smoothing[c] * (filtered[c] - raw);
+            prev_error[c] = error;
+            filtered[c] = derivative;
+
+            Scalar wanted = kp[c] * error + ki[c] * advanced + kd[c] * derivative;
+            Scalar limited = std::min(output_limit[c], std::max(-output_limit[c], wanted));
+
+            // Saturated and the error would wind it further: keep the old integral
+            bool winding = (wanted != limited) & ((error > 0) == (wanted > 0));
+            integral[c] = winding ? integral[c] : advanced;
+            output[c] = limited;
+        }
+    }
+
+    // Clear the channels whose mask byte is set
+    void reset(const Mask& mask) {
+        for (int c = 0; c < N; c++) {
+            Scalar keep = mask[c] ? Scalar(0) : Scalar(1);
+            integral[c] *= keep;
+            prev_error[c] *= keep;
+            filtered[c] *= keep;
+        }
+    }
+
+    void reset() {
+        integral.fill(0);
+        prev_error.fill(0);
+        filtered.fill(0);
+    }
+
+private:
+    alignas(64) Values integral;
+    alignas(64) Values prev_error;
+    alignas(64) Values filtered;   // derivative after the low-pass
+};
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "kinematics.h"
+#include "batch_kinematics.h"
+
+// Joint-space motion planning around obstacles in the arm's plane, by
+// RRT-Connect: a tree grows from the start and one from the goal, each
+// alternately reaching a step towards a random pose and the other then
+// running straight at the new node for as far as it stays clear. The
+// trees meeting gives a path, which is then shortcut: random pairs of
+// points along it are joined directly whenever that is clear, and
+// waypoints that became unnecessary are dropped.
+//
+// The arm's links are capsules link_radius thick. A pose collides when a
+// link comes within that of an obstacle, or of another link that isn't
+// its neighbour.
+//
+// Edges are checked in batches: the poses along an edge are spaced so no
+// point of the arm moves more than resolution between two of them (the
+// clearance is padded by half of that, so nothing slips between checks),
+// and go through BatchKinematics and the distance tests a block at a time
+// in structure-of-arrays form, stopping at the first block that collides.
+// A connect runs its whole line in one such sweep and keeps the clear
+// part, instead of extending a step at a time.
+
+template <typename Scalar = double>
+struct Obstacles {
+    struct Circle {
+        Point<Scalar> centre;
+        Scalar radius;
+    };
+
+    // Axis aligned, low and high corners
+    struct Box {
+        Point<Scalar> low, high;
+    };
+
+    std::vector<Circle> circles;
+    std::vector<Box> boxes;
+};
+
+template <int N, typename Scalar = double>
+class Planner {
+public:
+    typedef typename Kinematics<N, Scalar>::JointAngles JointAngles;
+    static const int BLOCK = 64;
+
+    struct Result {
+        bool found;
+        std::vector<JointAngles> waypoints;   // start to goal, straight between each
+        int nodes;                            // in both trees
+        long poses_checked;
+        Scalar raw_length, length;            // joint space, before and after shortcutting
+        double seconds;                       // spent in plan()
+    };
+
+    Kinematics<N, Scalar> arm;
+    Obstacles<Scalar> obstacles;
+
+    JointAngles lower, upper;            // sampled range, -pi to pi by default
+    Scalar link_radius = Scalar(0.05);   // m
+    Scalar resolution = Scalar(0.02);    // most any point moves between checked poses, m
+    Scalar step = Scalar(0.3);           // longest extend, rad
+    int max_samples = 5000;
+    int shortcuts = 100;
+
+    // The obstacles are copied; change them through the member
+    Planner(const Kinematics<N, Scalar>& kinematics, const Obstacles<Scalar>& scene, unsigned seed = 1)
+        : arm(kinematics), obstacles(scene), fk(kinematics), rng(seed) {
+        lower.fill(Scalar(-M_PI));
+        upper.fill(Scalar(M_PI));
+        std::fill(zero, zero + BLOCK, Scalar(0));
+        for (int j = N - 1; j >= 0; j--) outboard[j] = arm.lengths[j] + (j + 1 < N ? outboard[j + 1] : 0);
+    }
+
+    bool collides(const JointAngles& q) {
+        return firstCollision(q, q, 0) == 0;
+    }
+
+    // Intervals between checked poses from a to b: joint j turning by d
+    // moves no point further than d times the arm length outboard of it
+    int poses(const JointAngles& a, const JointAngles& b) const {
+        Scalar sweep = 0;
+        for (int j = 0; j < N; j++) sweep += std::fabs(b[j] - a[j]) * outboard[j];
+        return std::max(1, (int)std::ceil(sweep / resolution));
+    }
+
+    // True if every pose on the straight line from a to b is clear
+    bool clear(const JointAngles& a, const JointAngles& b) {
+        return firstCollision(a, b, poses(a, b)) < 0;
+    }
+
+    Result plan(const JointAngles& start, const JointAngles& goal) {
+        auto begin = std::chrono::steady_clock::now();
+        Result out;
+        out.found = false;
+        out.nodes = 0;
+        out.raw_length = out.length = 0;
+        checked = 0;
+
+        if (firstCollision(start, start, 0) < 0 && firstCollision(goal, goal, 0) < 0) {
+            Tree trees[2];
+            trees[0].add(start, -1);
+            trees[1].add(goal, -1);
+            Tree* a = &trees[0];
+            Tree* b = &trees[1];
+            for (int k = 0; k < max_samples && !out.found; k++) {
+                JointAngles target;
+                for (int j = 0; j < N; j++) {
+                    target[j] = std::uniform_real_distribution<Scalar>(lower[j], upper[j])(rng);
+                }
+                int met;
+                if (extend(*a, target) && connect(*b, a->at(a->size() - 1), met)) {
+                    out.found = true;
+                    // a's newest node and b's node met are the same pose
+                    bool a_from_start = a == &trees[0];
+                    const Tree& from_start = a_from_start ? *a : *b;
+                    const Tree& from_goal = a_from_start ? *b : *a;
+                    int start_end = a_from_start ? a->size() - 1 : met;
+                    int goal_end = a_from_start ? met : a->size() - 1;
+                    for (int i = start_end; i >= 0; i = from_start.parent[i]) {
+                        out.waypoints.push_back(from_start.at(i));
+                    }
+                    std::reverse(out.waypoints.begin(), out.waypoints.end());
+                    for (int i = from_goal.parent[goal_end]; i >= 0; i = from_goal.parent[i]) {
+                        out.waypoints.push_back(from_goal.at(i));
+                    }
+                }
+                std::swap(a, b);
+            }
+            out.nodes = trees[0].size() + trees[1].size();
+        }
+
+        if (out.found) {
+            out.raw_length = length(out.waypoints);
+            shortcut(out.waypoints);
+            out.length = length(out.waypoints);
+        }
+        out.poses_checked = checked;
+        out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return out;
+    }
+
+private:
+    // Nodes as structure of arrays, so the nearest-node scan vectorises
+    struct Tree {
+        std::array<std::vector<Scalar>, N> q;
+        std::vector<int> parent;
+
+        int size() const { return (int)parent.size(); }
+
+        void add(const JointAngles& angles, int from) {
+            for (int j = 0; j < N; j++) q[j].push_back(angles[j]);
+            parent.push_back(from);
+        }
+
+        JointAngles at(int i) const {
+            JointAngles angles;
+            for (int j = 0; j < N; j++) angles[j] = q[j][i];
+            return angles;
+        }
+
+        int nearest(const JointAngles& target) const {
+            int best = 0;
+            Scalar best_distance = std::numeric_limits<Scalar>::infinity();
+            for (int i = 0; i < size(); i++) {
+                Scalar d = 0;
+                for (int j = 0; j < N; j++) d += (q[j][i] - target[j]) * (q[j][i] - target[j]);
+                if (d < best_distance) {
+                    best_distance = d;
+                    best = i;
+                }
+            }
+            return best;
+        }
+    };
+
+    BatchKinematics<N, Scalar> fk;
+    std::mt19937 rng;
+    std::array<Scalar, N> outboard;   // arm length from each joint out
+    long checked = 0;
+
+    alignas(64) Scalar theta[N][BLOCK];
+    alignas(64) Scalar x[N][BLOCK];
+    alignas(64) Scalar y[N][BLOCK];
+    alignas(64) Scalar hit[BLOCK];
+    alignas(64) Scalar zero[BLOCK];   // the base, inboard end of the first link
+
+    static Scalar distance(const JointAngles& a, const JointAngles& b) {
+        Scalar d = 0;
+        for (int j = 0; j < N; j++) d += (b[j] - a[j]) * (b[j] - a[j]);
+        return std::sqrt(d);
+    }
+
+    static Scalar length(const std::vector<JointAngles>& path) {
+        Scalar total = 0;
+        for (size_t i = 1; i < path.size(); i++) total += distance(path[i - 1], path[i]);
+        return total;
+    }
+
+    static JointAngles lerp(const JointAngles& a, const JointAngles& b, Scalar t) {
+        JointAngles q;
+        for (int j = 0; j < N; j++) q[j] = a[j] + t * (b[j] - a[j]);
+        return q;
+    }
+
+    // One step from the nearest node towards target; false if blocked
+    bool extend(Tree& tree, const JointAngles& target) {
+        int near = tree.nearest(target);
+        JointAngles from = tree.at(near);
+        Scalar d = distance(from, target);
+        JointAngles to = d > step ? lerp(from, target, step / d) : target;
+        if (firstCollision(from, to, poses(from, to)) >= 0) return false;
+        tree.add(to, near);
+        return true;
+    }
+
+    // Straight from the nearest node towards target, adding a node every
+    // step along the clear part; true if it got all the way, with last
+    // the node at target
+    bool connect(Tree& tree, const JointAngles& target, int& last) {
+        int near = tree.nearest(target);
+        JointAngles from = tree.at(near);
+        int n = poses(from, target);
+        int blocked = firstCollision(from, target, n);
+        Scalar reach = blocked < 0 ? 1 : Scalar(blocked - 1) / n;
+        int steps = (int)std::ceil(reach * distance(from, target) / step);
+        for (int k = 1; k <= steps; k++) {
+            tree.add(lerp(from, target, reach * k / steps), k == 1 ? near : tree.size() - 1);
+        }
+        last = steps ? tree.size() - 1 : near;
+        return blocked < 0;
+    }
+
+    // Random pairs of points along the path joined where clear, then each
+    // waypoint dropped if its neighbours see each other
+    void shortcut(std::vector<JointAngles>& path) {
+        for (int k = 0; k < shortcuts && path.size() > 2; k++) {
+            std::vector<Scalar> along(path.size(), 0);
+            for (size_t i = 1; i < path.size(); i++) along[i] = along[i - 1] + distance(path[i - 1], path[i]);
+            std::uniform_real_distribution<Scalar> pick(0, along.back());
+            Scalar u = pick(rng), v = pick(rng);
+            if (u > v) std::swap(u, v);
+            size_t i = std::upper_bound(along.begin(), along.end(), u) - along.begin() - 1;
+            size_t m = std::upper_bound(along.begin(), along.end(), v) - along.begin() - 1;
+            if (i == m || m + 1 >= path.size()) continue;
+            JointAngles p = lerp(path[i], path[i + 1], (u - along[i]) / (along[i + 1] - along[i]));
+            JointAngles q = lerp(path[m], path[m + 1], (v - along[m]) / (along[m + 1] - along[m]));
+            if (!clear(p, q)) continue;
+            path.erase(path.begin() + i + 1, path.begin() + m + 1);
+            path.insert(path.begin() + i + 1, {p, q});
+        }
+        for (size_t i = 1; i + 1 < path.size();) {
+            if (clear(path[i - 1], path[i + 1])) path.erase(path.begin() + i);
+            else i++;
+        }
+    }
+
+    // Index of the first of the n + 1 evenly spaced poses from a to b that
+    // collides, or -1 if none does
+    int firstCollision(const JointAngles& a, const JointAngles& b, int n) {
+        typename BatchKinematics<N, Scalar>::Angles angles;
+        typename BatchKinematics<N, Scalar>::Coordinates xs, ys;
+        for (int j = 0; j < N; j++) {
+            angles[j] = theta[j];
+            xs[j] = x[j];
+            ys[j] = y[j];
+        }
+        for (int start = 0; start <= n; start += BLOCK) {
+            int count = std::min(BLOCK, n + 1 - start);
+            for (int j = 0; j < N; j++) {
+                Scalar d = n ? (b[j] - a[j]) / n : 0;
+                for (int i = 0; i < count; i++) theta[j][i] = a[j] + d * (start + i);
+            }
+            fk.joints(angles, count, xs, ys);
+            checked += count;
+            test(count);
+            for (int i = 0; i < count; i++) {
+                if (hit[i] != 0) return start + i;
+            }
+        }
+        return -1;
+    }
+
+    // hit[i] nonzero for each of the first count poses in x, y that collides
+    void test(int count) {
+        const Scalar pad = link_radius + resolution / 2;
+        for (int i = 0; i < count; i++) hit[i] = 0;
+        for (int j = 0; j < N; j++) {
+            const Scalar* ax = j ? x[j - 1] : zero;
+            const Scalar* ay = j ? y[j - 1] : zero;
+            const Scalar* bx = x[j];
+            const Scalar* by = y[j];
+            Scalar inverse_square = 1 / (arm.lengths[j] * arm.lengths[j]);
+
+            for (const typename Obstacles<Scalar>::Circle& c : obstacles.circles) {
+                Scalar reach = (c.radius + pad) * (c.radius + pad);
+                for (int i = 0; i < count; i++) {
+                    Scalar x0 = ax[i], y0 = ay[i];
+                    Scalar d = toSegment(c.centre.x, c.centre.y, x0, y0, bx[i] - x0, by[i] - y0, inverse_square);
+                    hit[i] += d < reach;
+                }
+            }
+
+            // A segment clear of a box is nearest it at one of its own ends
+            // or one of the box's corners
+            for (const typename Obstacles<Scalar>::Box& box : obstacles.boxes) {
+                Scalar pad2 = pad * pad;
+                for (int i = 0; i < count; i++) {
+                    Scalar x0 = ax[i], y0 = ay[i];
+                    Scalar dx = bx[i] - x0, dy = by[i] - y0;
+                    Scalar d = std::min(toBox(box, x0, y0), toBox(box, bx[i], by[i]));
+                    d = std::min(d, toSegment(box.low.x, box.low.y, x0, y0, dx, dy, inverse_square));
+                    d = std::min(d, toSegment(box.low.x, box.high.y, x0, y0, dx, dy, inverse_square));
+                    d = std::min(d, toSegment(box.high.x, box.low.y, x0, y0, dx, dy, inverse_square));
+                    d = std::min(d, toSegment(box.high.x, box.high.y, x0, y0, dx, dy, inverse_square));
+                    hit[i] += (d < pad2) | crosses(box, x0, y0, dx, dy);
+                }
+            }
+
+            // Against the links from two inwards
+            for (int k = 0; k + 2 <= j; k++) {
+                const Scalar* cx = k ? x[k - 1] : zero;
+                const Scalar* cy = k ? y[k - 1] : zero;
+                Scalar other_inverse = 1 / (arm.lengths[k] * arm.lengths[k]);
+                Scalar reach = 4 * pad * pad;
+                for (int i = 0; i < count; i++) {
+                    Scalar x0 = ax[i], y0 = ay[i];
+                    Scalar dx = bx[i] - x0, dy = by[i] - y0;
+                    Scalar u0 = cx[i], v0 = cy[i];
+                    Scalar du = x[k][i] - u0, dv = y[k][i] - v0;
+                    Scalar d = std::min(toSegment(u0, v0, x0, y0, dx, dy, inverse_square),
+                                        toSegment(u0 + du, v0 + dv, x0, y0, dx, dy, inverse_square));
+                    d = std::min(d, toSegment(x0, y0, u0, v0, du, dv, other_inverse));
+                    d = std::min(d, toSegment(x0 + dx, y0 + dy, u0, v0, du, dv, other_inverse));
+                    // Segments that cross have each one's ends either side of the other
+                    Scalar s1 = dx * (v0 - y0) - dy * (u0 - x0);
+                    Scalar s2 = dx * (v0 + dv - y0) - dy * (u0 + du - x0);
+                    Scalar s3 = du * (y0 - v0) - dv * (x0 - u0);
+                    Scalar s4 = du * (y0 + dy - v0) - dv * (x0 + dx - u0);
+                    hit[i] += (d < reach) | ((s1 * s2 < 0) & (s3 * s4 < 0));
+                }
+            }
+        }
+    }
+
+    // Squared distance from (px, py) to the segment from (x0, y0) along
+    // (dx, dy), given 1 / |(dx, dy)|^2
+    static Scalar toSegment(Scalar px, Scalar py, Scalar x0, Scalar y0, Scalar dx, Scalar dy, Scalar inverse_square) {
+        Scalar t = ((px - x0) * dx + (py - y0) * dy) * inverse_square;
+        t = std::min(Scalar(1), std::max(Scalar(0), t));
+        Scalar ex = x0 + t * dx - px, ey = y0 + t * dy - py;
+        return ex * ex + ey * ey;
+    }
+
+    // Squared distance from (px, py) to the box, 0 inside
+    static Scalar toBox(const typename Obstacles<Scalar>::Box& box, Scalar px, Scalar py) {
+        Scalar ex = std::max(Scalar(0), std::max(box.low.x - px, px - box.high.x));
+        Scalar ey = std::max(Scalar(0), std::max(box.low.y - py, py - box.high.y));
+        return ex * ex + ey * ey;
+    }
+
+    // Whether the segment passes through the box, by clipping its
+    // parameter range to each pair of sides. A tiny nudge keeps an axis
+    // aligned segment from dividing by zero.
+    static bool crosses(const typename Obstacles<Scalar>::Box& box, Scalar x0, Scalar y0, Scalar dx, Scalar dy) {
+        const Scalar tiny = Scalar(1e-12);
+        dx = std::fabs(dx) < tiny ? tiny : dx;
+        dy = std::fabs(dy) < tiny ? tiny : dy;
+        Scalar tx1 = (box.low.x - x0) / dx, tx2 = (box.high.x - x0) / dx;
+        Scalar ty1 = (box.low.y - y0) / dy, ty2 = (box.high.y - y0) / dy;
+        Scalar enter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), Scalar(0));
+        Scalar leave = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), Scalar(1));
+        return enter <= leave;
+    }
+};
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef SEED_TABLE_H
+#define SEED_TABLE_H
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "kinematics.h"
+#include "ik_solver.h"
+
+// Precomputed starting points for numerical IK.
+//
+// The square around the arm's reach is cut into grid x grid cells, and
+// optionally phi_bins bins of end-link angle. build() solves IK at the
+// centre of every cell, each from an already solved neighbour so that
+// nearby cells hold nearby configurations, and writes the answers to a
+// file. Cells nothing reaches keep the closest pose found.
+//
+// At runtime the file is memory-mapped read-only, so opening it costs
+// nothing up front and pages are only read as cells are looked up. A
+// seed query reads the 4 (or 8 with phi) cells around the target and
+// blends them; cells whose configuration disagrees with the nearest one
+// (a different IK branch) are left out of the blend.
+//
+// Layout: Header, then grid * grid * max(1, phi_bins) entries of N
+// floats (phi bin slowest, then y, then x), then one reachable flag byte
+// per cell.
+
+template <int N, typename Scalar = double>
+class SeedTable {
+    static_assert(N <= 8, "the file header holds eight link lengths");
+
+public:
+    typedef typename Kinematics<N, Scalar>::JointAngles JointAngles;
+
+    struct Header {
+        char magic[8];
+        int32_t joints;
+        int32_t grid;
+        int32_t phi_bins;       // 0: position only
+        int32_t reserved;
+        double reach;
+        double lengths[8];
+    };
+
+    SeedTable() {}
+    ~SeedTable() { close(); }
+    SeedTable(const SeedTable&) = delete;
+    SeedTable& operator=(const SeedTable&) = delete;
+
+    // Maps a table built for this arm. False if missing or for other links.
+    bool open(const std::string& path, const Kinematics<N, Scalar>& arm) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+            ::close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+        mapped = data;
+        mapped_size = info.st_size;
+
+        header = *(const Header*)mapped;
+        bool ok = std::memcmp(header.magic, "IKSEED1", 8) == 0 && header.joints == N && header.grid >= 2;
+        for (int j = 0; ok && j < N; j++) {
+            ok = std::fabs(header.lengths[j] - (double)arm.lengths[j]) < 1e-9;
+        }
+        if (ok) ok = mapped_size == fileSize(header.grid, header.phi_bins);
+        if (!ok) {
+            close();
+            return false;
+        }
+        angles = (const float*)((const char*)mapped + sizeof(Header));
+        reachable = (const uint8_t*)(angles + (size_t)cellCount() * N);
+        return true;
+    }
+
+    void close() {
+        if (mapped) munmap(mapped, mapped_size);
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    int grid() const { return header.grid; }
+    int phiBins() const { return header.phi_bins; }
+
+    // Seed for a position-only solve (tables built without phi bins)
+    JointAngles seed(Point<Scalar> target) const {
+        return lookup(target, 0, false);
+    }
+
+    // Seed for a solve with end-link angle phi
+    JointAngles seed(Point<Scalar> target, Scalar phi) const {
+        return lookup(target, phi, header.phi_bins > 0);
+    }
+
+    // Offline: solve every cell and write the table. Returns the number of
+    // reachable cells, or -1 if the file can't be written.
+    static long build(const std::string& path, const IKSolver<N, Scalar>& solver,
+                      int grid, int phi_bins, int restarts = 3, unsigned random_seed = 1) {
+        int bins = std::max(1, phi_bins);
+        long cells = (long)grid * grid * bins;
+        Scalar reach = solver.arm.reach();
+        Scalar cell = 2 * reach / grid;
+        Scalar bin = Scalar(2 * M_PI) / bins;
+
+        std::vector<float> table((size_t)cells * N, 0.0f);
+        std::vector<uint8_t> reached(cells, 0);
+        std::vector<uint8_t> tries(cells, 0);
+        std::mt19937 rng(random_seed);
+        std::uniform_real_distribution<Scalar> any_angle(Scalar(-M_PI), Scalar(M_PI));
+
+        auto solveCell = [&](long c, const JointAngles& start) {
+            int x = c % grid, y = (c / grid) % grid, b = c / ((long)grid * grid);
+            Point<Scalar> target = {-reach + (x + Scalar(0.5)) * cell, -reach + (y + Scalar(0.5)) * cell};
+            typename IKSolver<N, Scalar>::Result r = (phi_bins > 0)
+                ? solver.solve(target, Scalar(-M_PI) + (b + Scalar(0.5)) * bin, start)
+                : solver.solve(target, start);
+            tries[c]++;
+            if (r.converged || !reached[c]) {
+                for (int j = 0; j < N; j++) table[c * N + j] = (float)r.angles[j];
+            }
+            if (r.converged) reached[c] = 1;
+            return r.converged;
+        };
+        auto stored = [&](long c) {
+            JointAngles q;
+            for (int j = 0; j < N; j++) q[j] = table[c * N + j];
+            return q;
+        };
+
+        // Flood fill out from each cell that a random start can solve
+        std::deque<long> queue;
+        for (long start = 0; start < cells; start++) {
+            if (reached[start] || tries[start] > restarts) continue;
+            int x = start % grid, y = (start / grid) % grid;
+            Scalar cx = -reach + (x + Scalar(0.5)) * cell, cy = -reach + (y + Scalar(0.5)) * cell;
+            if (std::sqrt(cx * cx + cy * cy) > reach + cell) {
+                // Clearly out of reach: point the arm at it and move on
+                tries[start] = (uint8_t)(restarts + 1);
+                for (int j = 0; j < N; j++) table[start * N + j] = j ? 0.0f : (float)std::atan2(cy, cx);
+                continue;
+            }
+            while (!reached[start] && tries[start] <= restarts) {
+                JointAngles q;
+                for (int j = 0; j < N; j++) {
+                    q[j] = std::min(solver.upper[j], std::max(solver.lower[j], any_angle(rng)));
+                }
+                solveCell(start, q);
+            }
+            if (!reached[start]) continue;
+
+            queue.push_back(start);
+            while (!queue.empty()) {
+                long c = queue.front();
+                queue.pop_front();
+                int x = c % grid, y = (c / grid) % grid, b = c / ((long)grid * grid);
+                long layer = (long)grid * grid;
+                // Phi bins wrap around
+                long neighbours[6] = {
+                    x > 0 ? c - 1 : -1,
+                    x + 1 < grid ? c + 1 : -1,
+                    y > 0 ? c - grid : -1,
+                    y + 1 < grid ? c + grid : -1,
+                    phi_bins > 0 ? c + ((b + bins - 1) % bins - b) * layer : -1,
+                    phi_bins > 0 ? c + ((b + 1) % bins - b) * layer : -1,
+                };
+                for (long n : neighbours) {
+                    if (n < 0 || n == c || reached[n] || tries[n] > restarts) continue;
+                    if (solveCell(n, stored(c))) queue.push_back(n);
+                }
+            }
+        }
+
+        Header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "IKSEED1", 8);
+        h.joints = N;
+        h.grid = grid;
+        h.phi_bins = phi_bins;
+        h.reach = reach;
+        for (int j = 0; j < N; j++) h.lengths[j] = solver.arm.lengths[j];
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return -1;
+        file.write((const char*)&h, sizeof(h));
+        file.write((const char*)table.data(), table.size() * sizeof(float));
+        file.write((const char*)reached.data(), reached.size());
+        if (!file) return -1;
+        return (long)std::count(reached.begin(), reached.end(), 1);
+    }
+
+private:
+    Header header;
+    void* mapped = nullptr;
+    size_t mapped_size = 0;
+    const float* angles = nullptr;
+    const uint8_t* reachable = nullptr;
+
+    long cellCount() const {
+        return (long)header.grid * header.grid * std::max(1, header.phi_bins);
+    }
+
+    static size_t fileSize(int grid, int phi_bins) {
+        size_t cells = (size_t)grid * grid * std::max(1, phi_bins);
+        return sizeof(Header) + cells * N * sizeof(float) + cells;
+    }
+
+    JointAngles lookup(Point<Scalar> target, Scalar phi, bool use_phi) const {
+        int grid = header.grid;
+        Scalar cell = Scalar(2 * header.reach / grid);
+
+        // Cell centres sit at half-cell offsets
+        Scalar u = (target.x + Scalar(header.reach)) / cell - Scalar(0.5);
+        Scalar v = (target.y + Scalar(header.reach)) / cell - Scalar(0.5);
+        u = std::min(Scalar(grid - 1), std::max(Scalar(0), u));
+        v = std::min(Scalar(grid - 1), std::max(Scalar(0), v));
+        int x0 = std::min(grid - 2, (int)u), y0 = std::min(grid - 2, (int)v);
+        Scalar fx = u - x0, fy = v - y0;
+
+        int bins = std::max(1, header.phi_bins);
+        int b0 = 0, b1 = 0;
+        Scalar fb = 0;
+        if (use_phi) {
+            Scalar w = std::remainder(phi, Scalar(2 * M_PI)) + Scalar(M_PI);
+            w = w / (Scalar(2 * M_PI) / bins) - Scalar(0.5);
+            if (w < 0) w += bins;
+            b0 = std::min(bins - 1, (int)w);
+            b1 = (b0 + 1) % bins;
+            fb = w - b0;
+        }
+
+        long corners[8];
+        Scalar weights[8];
+        int count = 0;
+        for (int k = 0; k < (use_phi ? 8 : 4); k++) {
+            int x = x0 + (k & 1), y = y0 + ((k >> 1) & 1), b = (k & 4) ? b1 : b0;
+            corners[count] = ((long)b * grid + y) * grid + x;
+            weights[count] = ((k & 1) ? fx : 1 - fx) * ((k & 2) ? fy : 1 - fy)
+                           * (use_phi ? ((k & 4) ? fb : 1 - fb) : 1);
+            count++;
+        }
+
+        // Blend around the heaviest reachable corner
+        int best = 0;
+        for (int k = 1; k < count; k++) {
+            bool better = reachable[corners[k]] > reachable[corners[best]]
+                       || (reachable[corners[k]] == reachable[corners[best]] && weights[k] > weights[best]);
+            if (better) best = k;
+        }
+        const float* anchor = angles + corners[best] * N;
+
+        JointAngles q;
+        q.fill(0);
+        Scalar total = 0;
+        for (int k = 0; k < count; k++) {
+            const float* a = angles + corners[k] * N;
+            if (reachable[corners[k]] != reachable[corners[best]]) continue;
+            bool close = true;
+            for (int j = 0; j < N && close; j++) close = std::fabs(a[j] - anchor[j]) < Scalar(0.5);
+            if (!close) continue;
+            for (int j = 0; j < N; j++) q[j] += weights[k] * a[j];
+            total += weights[k];
+        }
+        if (total <= 0) {
+            for (int j = 0; j < N; j++) q[j] = anchor[j];
+            return q;
+        }
+        for (int j = 0; j < N; j++) q[j] /= total;
+        return q;
+    }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef SPATIAL_IK_SOLVER_H
+#define SPATIAL_IK_SOLVER_H
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "spatial_kinematics.h"
+#include "least_squares.h"
+
+// Numerical inverse kinematics for a SpatialKinematics arm, the same
+// damped least squares as IKSolver (see least_squares.h) on the geometric
+// Jacobian. The task is the end-effector position, or the whole pose: the
+// position error in metres stacked on the orientation error, the rotation
+// vector of the turn still needed, in radians.
+//
+// Joint limits as in IKSolver. There is no null-space pull here: a 6-DOF
+// arm has no spare joints for a full pose.
+
+template <int N, typename Scalar = double>
+class SpatialIKSolver {
+public:
+    typedef typename SpatialKinematics<N, Scalar>::JointAngles JointAngles;
+
+    struct Result {
+        JointAngles angles;
+        int iterations;
+        Scalar error;       // position error, plus orientation error if given
+        bool converged;     // error under tolerance
+    };
+
+    SpatialKinematics<N, Scalar> arm;
+
+    JointAngles lower, upper;   // joint limits, unlimited by default
+
+    Scalar damping = Scalar(0.05);
+    Scalar tolerance = Scalar(1e-6);
+    int max_iterations = 100;
+    Scalar max_step = Scalar(0.5);     // largest joint change per iteration, rad
+
+    SpatialIKSolver(const SpatialKinematics<N, Scalar>& kinematics) : arm(kinematics) {
+        lower.fill(-std::numeric_limits<Scalar>::infinity());
+        upper.fill(std::numeric_limits<Scalar>::infinity());
+    }
+
+    // End effector to target, any orientation
+    Result solve(const Vec3<Scalar>& target, const JointAngles& start) const {
+        Transform3<Scalar> goal = Transform3<Scalar>::identity();
+        goal.p = target;
+        return solveTask<3>(goal, start);
+    }
+
+    // End effector to the target frame
+    Result solve(const Transform3<Scalar>& target, const JointAngles& start) const {
+        return solveTask<6>(target, start);
+    }
+
+private:
+    // M is the task size: 3 for position, 6 with orientation
+    template <int M>
+    Result solveTask(const Transform3<Scalar>& goal, const JointAngles& start) const {
+        Result result;
+        result.angles = start;
+        for (int j = 0; j < N; j++) {
+            result.angles[j] = std::min(upper[j], std::max(lower[j], result.angles[j]));
+        }
+        result.iterations = 0;
+
+        Quaternion<Scalar> goal_rotation = goal.rotation();
+        auto task = [&](const JointAngles& angles, std::array<Scalar, M>& error,
+                        std::array<std::array<Scalar, N>, M>* J) {
+            return taskError<M>(goal, goal_rotation, angles, error, J);
+        };
+        result.error = dampedRefine<M, N, Scalar>(*this, task, result.angles, result.iterations);
+        result.converged = result.error <= tolerance;
+        return result;
+    }
+
+    // Error (goal - current) and optionally the Jacobian at angles.
+    // Returns the error's length.
+    template <int M>
+    Scalar taskError(const Transform3<Scalar>& goal, const Quaternion<Scalar>& goal_rotation,
+                     const JointAngles& angles, std::array<Scalar, M>& error,
+                     std::array<std::array<Scalar, N>, M>* J) const {
+        Transform3<Scalar> end = arm.endEffector(angles);
+        Vec3<Scalar> e = goal.p - end.p;
+        error[0] = e.x;
+        error[1] = e.y;
+        error[2] = e.z;
+        if constexpr (M == 6) {
+            Vec3<Scalar> turn = (goal_rotation * end.rotation().conjugate()).log();
+            error[3] = turn.x;
+            error[4] = turn.y;
+            error[5] = turn.z;
+        }
+
+        if (J) {
+            typename SpatialKinematics<N, Scalar>::Jacobian full = arm.jacobian(angles);
+            for (int i = 0; i < M; i++) (*J)[i] = full[i];
+        }
+
+        Scalar sum = 0;
+        for (int i = 0; i < M; i++) sum += error[i] * error[i];
+        return std::sqrt(sum);
+    }
+};
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef SPATIAL_KINEMATICS_H
+#define SPATIAL_KINEMATICS_H
+
+#include <array>
+#include <cmath>
+
+// Serial arm in space with N revolute joints, described by standard
+// Denavit-Hartenberg parameters: link i's frame is the one before it
+// turned by the joint angle about z, moved d along z and a along the new
+// x, then tilted by alpha about that x.
+//
+// Frames are rigid transforms, the top three rows of the 4x4 homogeneous
+// matrix (the last row is always 0 0 0 1). Forward kinematics composes one
+// link at a time using the DH structure rather than a full 4x4 product,
+// and the Jacobian comes from the same frames: joint i turns about the z
+// axis of frame i - 1. Orientations convert to unit quaternions for
+// comparing and interpolating. Everything is in fixed-size arrays sized
+// by N, so nothing touches the heap.
+
+template <typename Scalar>
+struct Vec3 {
+    Scalar x, y, z;
+
+    Vec3 operator+(const Vec3& o) const { return {x + o.x, y + o.y, z + o.z}; }
+    Vec3 operator-(const Vec3& o) const { return {x - o.x, y - o.y, z - o.z}; }
+    Vec3 operator*(Scalar k) const { return {x * k, y * k, z * k}; }
+    Scalar dot(const Vec3& o) const { return x * o.x + y * o.y + z * o.z; }
+    Vec3 cross(const Vec3& o) const { return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x}; }
+    Scalar norm() const { return std::sqrt(dot(*this)); }
+};
+
+// Unit quaternion for a rotation, w the scalar part
+template <typename Scalar>
+struct Quaternion {
+    Scalar w, x, y, z;
+
+    static Quaternion identity() { return {1, 0, 0, 0}; }
+
+    // Turning by angle about a unit axis
+    static Quaternion axisAngle(const Vec3<Scalar>& axis, Scalar angle) {
+        Scalar s = std::sin(angle / 2);
+        return {std::cos(angle / 2), axis.x * s, axis.y * s, axis.z * s};
+    }
+
+    Quaternion operator*(const Quaternion& o) const {
+        return {w * o.w - x * o.x - y * o.y - z * o.z,
+                w * o.x + x * o.w + y * o.z - z * o.y,
+                w * o.y - x * o.z + y * o.w + z * o.x,
+                w * o.z + x * o.y - y * o.x + z * o.w};
+    }
+
+    Quaternion conjugate() const { return {w, -x, -y, -z}; }
+
+    // Rotation vector (axis times angle, angle in [0, pi]) of this turn
+    Vec3<Scalar> log() const {
+        Scalar sign = w < 0 ? Scalar(-1) : Scalar(1);
+        Vec3<Scalar> v = {x * sign, y * sign, z * sign};
+        Scalar s = v.norm();
+        // Near zero, angle / s tends to 2
+        Scalar k = s < Scalar(1e-12) ? Scalar(2) : 2 * std::atan2(s, w * sign) / s;
+        return v * k;
+    }
+};
+
+// Rigid transform: rotation r and translation p, the 4x4 matrix [r p; 0 1]
+template <typename Scalar>
+struct Transform3 {
+    std::array<std::array<Scalar, 3>, 3> r;
+    Vec3<Scalar> p;
+
+    static Transform3 identity() { return {{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}, {0, 0, 0}}; }
+
+    static Transform3 from(const Quaternion<Scalar>& q, const Vec3<Scalar>& position) {
+        Scalar w = q.w, x = q.x, y = q.y, z = q.z;
+        return {{{{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)},
+                  {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)},
+                  {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)}}},
+                position};
+    }
+
+    Vec3<Scalar> column(int c) const { return {r[0][c], r[1][c], r[2][c]}; }
+
+    Vec3<Scalar> apply(const Vec3<Scalar>& v) const {
+        return {r[0][0] * v.x + r[0][1] * v.y + r[0][2] * v.z + p.x,
+                r[1][0] * v.x + r[1][1] * v.y + r[1][2] * v.z + p.y,
+                r[2][0] * v.x + r[2][1] * v.y + r[2][2] * v.z + p.z};
+    }
+
+    Transform3 operator*(const Transform3& o) const {
+        Transform3 out;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) out.r[i][j] = r[i][0] * o.r[0][j] + r[i][1] * o.r[1][j] + r[i][2] * o.r[2][j];
+        }
+        out.p = apply(o.p);
+        return out;
+    }
+
+    // Shepperd's method: divide by the largest of the four candidates
+    Quaternion<Scalar> rotation() const {
+        Scalar trace = r[0][0] + r[1][1] + r[2][2];
+        Quaternion<Scalar> q;
+        if (trace > r[0][0] && trace > r[1][1] && trace > r[2][2]) {
+            Scalar s = 2 * std::sqrt(1 + trace);
+            q = {s / 4, (r[2][1] - r[1][2]) / s, (r[0][2] - r[2][0]) / s, (r[1][0] - r[0][1]) / s};
+        } else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+            Scalar s = 2 * std::sqrt(1 + r[0][0] - r[1][1] - r[2][2]);
+            q = {(r[2][1] - r[1][2]) / s, s / 4, (r[0][1] + r[1][0]) / s, (r[0][2] + r[2][0]) / s};
+        } else if (r[1][1] > r[2][2]) {
+            Scalar s = 2 * std::sqrt(1 + r[1][1] - r[0][0] - r[2][2]);
+            q = {(r[0][2] - r[2][0]) / s, (r[0][1] + r[1][0]) / s, s / 4, (r[1][2] + r[2][1]) / s};
+        } else {
+            Scalar s = 2 * std::sqrt(1 + r[2][2] - r[0][0] - r[1][1]);
+            q = {(r[1][0] - r[0][1]) / s, (r[0][2] + r[2][0]) / s, (r[1][2] + r[2][1]) / s, s / 4};
+        }
+        return q;
+    }
+};
+
+template <typename Scalar>
+struct DHLink {
+    Scalar a, alpha, d;
+    Scalar offset;   // added to the joint angle, so zero angles can be a chosen pose
+};
+
+template <int N, typename Scalar = double>
+class SpatialKinematics {
+    static_assert(N >= 1, "SpatialKinematics needs at least one joint");
+
+public:
+    typedef std::array<Scalar, N> JointAngles;
+    typedef std::array<Transform3<Scalar>, N> Result;       // frame at the end of each link
+    typedef std::array<std::array<Scalar, N>, 6> Jacobian;  // rows vx, vy, vz, wx, wy, wz
+
+    std::array<DHLink<Scalar>, N> links;
+
+    explicit SpatialKinematics(const std::array<DHLink<Scalar>, N>& dh) : links(dh) {
+        for (int i = 0; i < N; i++) {
+            ca[i] = std::cos(links[i].alpha);
+            sa[i] = std::sin(links[i].alpha);
+        }
+    }
+
+    // Forward: angles -> every link's frame
+    Result forward(const JointAngles& theta) const {
+        Result frames;
+        Transform3<Scalar> t = Transform3<Scalar>::identity();
+        for (int i = 0; i < N; i++) {
+            t = addLink(t, i, theta[i]);
+            frames[i] = t;
+        }
+        return frames;
+    }
+
+    Transform3<Scalar> endEffector(const JointAngles& theta) const {
+        Transform3<Scalar> t = Transform3<Scalar>::identity();
+        for (int i = 0; i < N; i++) t = addLink(t, i, theta[i]);
+        return t;
+    }
+
+    // End-effector linear and angular velocity per unit joint rate, in
+    // the base frame
+    Jacobian jacobian(const JointAngles& theta) const {
+        Result frames = forward(theta);
+        Vec3<Scalar> end = frames[N - 1].p;
+        Jacobian J;
+        for (int i = 0; i < N; i++) {
+            Vec3<Scalar> z = i ? frames[i - 1].column(2) : Vec3<Scalar>{0, 0, 1};
+            Vec3<Scalar> o = i ? frames[i - 1].p : Vec3<Scalar>{0, 0, 0};
+            Vec3<Scalar> v = z.cross(end - o);
+            J[0][i] = v.x;
+            J[1][i] = v.y;
+            J[2][i] = v.z;
+            J[3][i] = z.x;
+            J[4][i] = z.y;
+            J[5][i] = z.z;
+        }
+        return J;
+    }
+
+    // Furthest the end effector can be from the base, at most
+    Scalar reach() const {
+        Scalar total = 0;
+        for (const DHLink<Scalar>& link : links) total += std::fabs(link.a) + std::fabs(link.d);
+        return total;
+    }
+
+private:
+    std::array<Scalar, N> ca, sa;   // cos and sin of each alpha
+
+    // t times link i's transform:
+    //   [ c  -s*ca   s*sa  a*c ]
+    //   [ s   c*ca  -c*sa  a*s ]
+    //   [ 0   sa     ca    d   ]
+    // so the new axes are mixes of t's columns
+    Transform3<Scalar> addLink(const Transform3<Scalar>& t, int i, Scalar angle) const {
+        Scalar c = std::cos(angle + links[i].offset), s = std::sin(angle + links[i].offset);
+        Transform3<Scalar> out;
+        for (int row = 0; row < 3; row++) {
+            Scalar x = c * t.r[row][0] + s * t.r[row][1];
+            Scalar y = -s * t.r[row][0] + c * t.r[row][1];
+            out.r[row][0] = x;
+            out.r[row][1] = ca[i] * y + sa[i] * t.r[row][2];
+            out.r[row][2] = -sa[i] * y + ca[i] * t.r[row][2];
+        }
+        out.p = t.p + out.column(0) * links[i].a + t.column(2) * links[i].d;
+        return out;
+    }
+};
+
+// Universal Robots UR5, 6 joints, metres
+template <typename Scalar = double>
+std::array<DHLink<Scalar>, 6> ur5() {
+    const Scalar half_pi = Scalar(M_PI / 2);
+    return {{{0, half_pi, Scalar(0.089159), 0},
+             {Scalar(-0.425), 0, 0, 0},
+             {Scalar(-0.39225), 0, 0, 0},
+             {0, half_pi, Scalar(0.10915), 0},
+             {0, -half_pi, Scalar(0.09465), 0},
+             {0, 0, Scalar(0.0823), 0}}};
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+// Joint-space moves with velocity and acceleration limits, for feeding
+// the PID controllers a setpoint that moves smoothly to the IK answer
+// instead of jumping there.
+//
+// Each joint gets a trapezoidal velocity profile: accelerate at its limit,
+// cruise, decelerate at its limit (a triangle when the move is too short
+// to reach cruise speed). The slowest joint sets the duration and every
+// other joint is slowed down to finish with it, by lowering its cruise
+// speed, so the arm moves along a straight line in joint space and
+// arrives all at once. Moves start and end at rest.
+//
+// sample() is O(1): the phase is picked by comparing t with the two
+// switch times, and position comes from the closed form for that phase.
+
+template <int N, typename Scalar = double>
+class Trajectory {
+public:
+    typedef std::array<Scalar, N> JointValues;
+
+    struct Setpoint {
+        JointValues position, velocity, acceleration;
+    };
+
+    Trajectory() {
+        start.fill(0);
+        goal.fill(0);
+        direction.fill(1);
+        cruise.fill(0);
+        accel.fill(0);
+        ramp.fill(0);
+    }
+
+    // Plan start -> goal from rest to rest within the given limits (each > 0).
+    // Returns the duration.
+    Scalar plan(const JointValues& from, const JointValues& to,
+                const JointValues& max_velocity, const JointValues& max_acceleration) {
+        start = from;
+        goal = to;
+
+        // Fastest time for each joint on its own
+        total = 0;
+        JointValues distance;
+        for (int j = 0; j < N; j++) {
+            distance[j] = std::fabs(goal[j] - start[j]);
+            direction[j] = goal[j] >= start[j] ? Scalar(1) : Scalar(-1);
+            Scalar v = max_velocity[j], a = max_acceleration[j];
+            Scalar fastest = (distance[j] * a > v * v)
+                ? distance[j] / v + v / a                  // reaches cruise speed
+                : 2 * std::sqrt(distance[j] / a);         // triangle
+            total = std::max(total, fastest);
+        }
+
+        // Stretch the rest to the same duration at full acceleration: the
+        // cruise speed v solves total = distance / v + v / a
+        for (int j = 0; j < N; j++) {
+            Scalar a = max_acceleration[j];
+            if (distance[j] == 0 || total == 0) {
+                cruise[j] = 0;
+                accel[j] = a;
+                ramp[j] = 0;
+                continue;
+            }
+            Scalar disc = std::max(Scalar(0), a * a * total * total - 4 * a * distance[j]);
+            cruise[j] = (a * total - std::sqrt(disc)) / 2;
+            accel[j] = a;
+            ramp[j] = cruise[j] / a;
+        }
+        return total;
+    }
+
+    Scalar duration() const { return total; }
+
+    // Position, velocity and acceleration at time t since the move began.
+    // Before 0 holds the start, after the end holds the goal.
+    Setpoint sample(Scalar t) const {
+        Setpoint out;
+        for (int j = 0; j < N; j++) {
+            Scalar s, v, a;
+            Scalar t_ramp = ramp[j];
+            if (t <= 0) {
+                s = 0; v = 0; a = 0;
+            } else if (t >= total) {
+                s = std::fabs(goal[j] - start[j]); v = 0; a = 0;
+            } else if (t < t_ramp) {
+                a = accel[j];
+                v = a * t;
+                s = Scalar(0.5) * a * t * t;
+            } else if (t <= total - t_ramp) {
+                a = 0;
+                v = cruise[j];
+                s = cruise[j] * (t - Scalar(0.5) * t_ramp);
+            } else {
+                Scalar left = total - t;
+                a = -accel[j];
+                v = accel[j] * left;
+                s = std::fabs(goal[j] - start[j]) - Scalar(0.5) * accel[j] * left * left;
+            }
+            out.position[j] = start[j] + direction[j] * s;
+            out.velocity[j] = direction[j] * v;
+            out.acceleration[j] = direction[j] * a;
+        }
+        return out;
+    }
+
+private:
+    JointValues start, goal;
+    JointValues direction;   // +1 or -1
+    JointValues cruise;      // cruise speed, after synchronising
+    JointValues accel;       // acceleration while ramping
+    JointValues ramp;        // time spent ramping up (and again down)
+    Scalar total = 0;
+};
+
+#endif
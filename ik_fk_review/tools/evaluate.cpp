@@ -0,0 +1,295 @@
+// Runs the arm demos' IK + PID loop headless for many random targets and
+// summarises how the joints settled, so a controller change can be judged
+// on the whole distribution rather than one hard-coded target.
+//
+// Each target is solved the way its demo does it (nearest analytic branch,
+// refined by IKSolver for three joints), then run as an Episode from the
+// demo's start pose, on the rigid-body arm the mains simulate (Dynamics,
+// uniform rods of 1 kg/m under gravity) stepped --substeps times a tick;
+// the mains use 100, but 10 gives much the same answers ten times faster.
+// Targets fill a disc a little larger than the reach, so some are out of
+// reach; those still run, to the closest pose, but are counted apart. The
+// single joint's targets lie on its circle.
+//
+//   --no-feedforward  PID alone tracks the move, so the gains show
+//   --simple-plant    the old plant instead: vel += u * dt, vel *= 0.95
+//   --csv file        one row per target
+//   --json file       the summary, with percentiles
+//
+// Usage: ./evaluate [--arm single|double|triple] [--targets N] [--threads T]
+//                   [--seed S] [--gains kp ki kd | --gains-file file]
+//                   [--time seconds] [--substeps S] [--simple-plant]
+//                   [--no-feedforward] [--csv file] [--json file]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/ik_solver.h"
+#include "../common/episode.h"
+#include "../common/gains.h"
+#include "tool_common.h"
+
+struct Options {
+    std::string arm = "triple";
+    int targets = 10000;
+    int threads = 0;
+    uint64_t seed = 1;
+    double kp = 5.0, ki = 0.1, kd = 0.5;
+    double time = 5.0;
+    bool feedforward = true;
+    int substeps = 10;
+    bool simple_plant = false;
+    std::string gains_file;
+    std::string csv, json;
+};
+
+struct Target {
+    Position position;
+    double phi;
+};
+
+struct Row {
+    Target target;
+    bool reachable;
+    double move_time, settling_time, overshoot, final_error, position_error;
+};
+
+// Goal angles from the demos' start pose, picked as each demo does.
+// Returns false when the target is out of reach.
+bool goalFor(const Kinematics<1>& arm, const Target& target, std::array<double, 1>& goal) {
+    goal = arm.inverse(target.position);
+    return std::fabs(std::hypot(target.position.x, target.position.y) - arm.lengths[0]) < 1e-9;
+}
+
+bool goalFor(const Kinematics<2>& arm, const Target& target, std::array<double, 2>& goal) {
+    Kinematics<2>::Solutions solutions = arm.inverseAll(target.position);
+    goal = solutions.empty()
+        ? arm.inverse(target.position)
+        : Kinematics<2>::nearest(solutions, {0.0, 0.0}, {arm.reach(), arm.lengths[1]});
+    return !solutions.empty();
+}
+
+bool goalFor(const Kinematics<3>& arm, const Target& target, std::array<double, 3>& goal) {
+    Kinematics<3>::Solutions branches = arm.inverseAll(target.position, target.phi);
+    Kinematics<3>::JointAngles start = branches.empty()
+        ? arm.inverse(target.position, target.phi)
+        : Kinematics<3>::nearest(branches, {0.0, 0.0, 0.0},
+                                 {arm.reach(), arm.lengths[1] + arm.lengths[2], arm.lengths[2]});
+    IKSolver<3> solver(arm);
+    IKSolver<3>::Result solution = solver.solve(target.position, target.phi, start);
+    goal = solution.angles;
+    return solution.converged;
+}
+
+template <int N>
+void runRange(const Kinematics<N>& arm, const typename Episode<N>::Settings& settings,
+              const std::vector<Target>& targets, size_t begin, size_t end, std::vector<Row>& rows) {
+    std::array<double, N> start{};
+    for (size_t i = begin; i < end; i++) {
+        Row& row = rows[i];
+        row.target = targets[i];
+        std::array<double, N> goal;
+        row.reachable = goalFor(arm, row.target, goal);
+
+        typename Episode<N>::Outcome outcome = Episode<N>::run(settings, start, goal);
+        Position reached = arm.endEffector(outcome.final_angles);
+        row.move_time = outcome.move_time;
+        row.settling_time = outcome.settling_time;
+        row.overshoot = outcome.overshoot;
+        row.final_error = outcome.final_error;
+        row.position_error = std::hypot(reached.x - row.target.position.x, reached.y - row.target.position.y);
+    }
+}
+
+// Order statistics of one metric
+struct Spread {
+    size_t count = 0;
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+
+    explicit Spread(std::vector<double> values) {
+        count = values.size();
+        if (values.empty()) return;
+        std::sort(values.begin(), values.end());
+        for (double v : values) mean += v;
+        mean /= count;
+        auto at = [&](double p) { return values[(size_t)(p * (count - 1))]; };
+        p50 = at(0.5);
+        p90 = at(0.9);
+        p99 = at(0.99);
+        max = values.back();
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, const Spread& s) {
+    return out << s.count << " runs, mean " << s.mean << ", p50 " << s.p50 << ", p90 " << s.p90
+               << ", p99 " << s.p99 << ", max " << s.max;
+}
+
+void writeJson(std::ostream& out, const char* name, const Spread& s, bool last = false) {
+    out << "    \"" << name << "\": {\"count\": " << s.count << ", \"mean\": " << s.mean
+        << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90 << ", \"p99\": " << s.p99
+        << ", \"max\": " << s.max << "}" << (last ? "\n" : ",\n");
+}
+
+template <int N>
+int evaluate(const Options& opt, const Kinematics<N>& arm) {
+    typename Episode<N>::Settings settings;
+    settings.kp.fill(opt.kp);
+    settings.ki.fill(opt.ki);
+    settings.kd.fill(opt.kd);
+    if (!opt.gains_file.empty() &&
+        !loadGains<N, double>(opt.gains_file, opt.arm, settings.kp, settings.ki, settings.kd,
+                               settings.output_limit)) {
+        std::cerr << "Could not read " << opt.gains_file << "\n";
+        return 1;
+    }
+    settings.duration = opt.time;
+    settings.feedforward = opt.feedforward;
+    Dynamics<N> dynamics(arm);
+    if (!opt.simple_plant) {
+        settings.dynamics = &dynamics;
+        settings.substeps = opt.substeps;
+    }
+
+    // Drawn up front so the results don't depend on the thread count
+    Random rng{opt.seed};
+    double reach = arm.reach();
+    std::vector<Target> targets(opt.targets);
+    for (Target& target : targets) {
+        double angle = rng.uniform(-M_PI, M_PI);
+        // Uniform over the disc's area
+        double radius = N == 1 ? reach : 1.1 * reach * std::sqrt(rng.uniform(0, 1));
+        target.position = {radius * std::cos(angle), radius * std::sin(angle)};
+        target.phi = rng.uniform(-M_PI, M_PI);
+    }
+
+    int threads = threadCount(opt.threads);
+    std::vector<Row> rows(targets.size());
+    auto begin_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    size_t per_thread = (targets.size() + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t begin = std::min(targets.size(), t * per_thread);
+        size_t end = std::min(targets.size(), begin + per_thread);
+        workers.emplace_back([&, begin, end]() {
+            runRange<N>(arm, settings, targets, begin, end, rows);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+
+    // Distributions over the reachable targets
+    std::vector<double> settling, overshoot, final_error, position_error;
+    size_t unreachable = 0, unsettled = 0;
+    for (const Row& row : rows) {
+        if (!row.reachable) {
+            unreachable++;
+            continue;
+        }
+        if (row.settling_time < 0) unsettled++;
+        else settling.push_back(row.settling_time);
+        overshoot.push_back(row.overshoot);
+        final_error.push_back(row.final_error);
+        position_error.push_back(row.position_error);
+    }
+    Spread settle_spread(settling), overshoot_spread(overshoot);
+    Spread error_spread(final_error), position_spread(position_error);
+
+    std::cout << opt.arm << " arm, gains ";
+    if (opt.gains_file.empty()) std::cout << opt.kp << " " << opt.ki << " " << opt.kd;
+    else std::cout << "from " << opt.gains_file;
+    std::cout << (opt.simple_plant ? ", simple plant" : ", rigid body")
+              << (opt.feedforward ? "" : ", no feedforward") << ", "
+              << targets.size() << " targets on " << threads << " thread(s) in " << seconds << " s\n"
+              << "Unreachable: " << unreachable << ", reachable but not settled after "
+              << opt.time << " s: " << unsettled << "\n"
+              << "Settling time s:      " << settle_spread << "\n"
+              << "Overshoot rad:        " << overshoot_spread << "\n"
+              << "Final joint error rad: " << error_spread << "\n"
+              << "Final position error m: " << position_spread << "\n";
+
+    if (!opt.csv.empty()) {
+        std::ofstream csv(opt.csv);
+        csv << "x,y,phi,reachable,move_time,settling_time,overshoot,final_error,position_error\n";
+        for (const Row& row : rows) {
+            csv << row.target.position.x << "," << row.target.position.y << "," << row.target.phi << ","
+                << row.reachable << "," << row.move_time << "," << row.settling_time << ","
+                << row.overshoot << "," << row.final_error << "," << row.position_error << "\n";
+        }
+        std::cout << "Wrote " << opt.csv << "\n";
+    }
+    if (!opt.json.empty()) {
+        std::ofstream json(opt.json);
+        json << "{\n  \"arm\": \"" << opt.arm << "\",\n"
+             << "  \"gains\": [";
+        for (int j = 0; j < N; j++) {
+            json << (j ? ", " : "") << "[" << settings.kp[j] << ", " << settings.ki[j] << ", " << settings.kd[j] << "]";
+        }
+        json << "],\n"
+             << "  \"plant\": \"" << (opt.simple_plant ? "simple" : "rigid body") << "\",\n"
+             << "  \"substeps\": " << opt.substeps << ",\n"
+             << "  \"feedforward\": " << (opt.feedforward ? "true" : "false") << ",\n"
+             << "  \"targets\": " << targets.size() << ",\n"
+             << "  \"unreachable\": " << unreachable << ",\n"
+             << "  \"unsettled\": " << unsettled << ",\n"
+             << "  \"metrics\": {\n";
+        writeJson(json, "settling_time", settle_spread);
+        writeJson(json, "overshoot", overshoot_spread);
+        writeJson(json, "final_error", error_spread);
+        writeJson(json, "position_error", position_spread, true);
+        json << "  }\n}\n";
+        std::cout << "Wrote " << opt.json << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--arm" && has_value) opt.arm = argv[++i];
+        else if (arg == "--targets" && has_value) opt.targets = std::atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--gains" && i + 3 < argc) {
+            opt.kp = std::atof(argv[++i]);
+            opt.ki = std::atof(argv[++i]);
+            opt.kd = std::atof(argv[++i]);
+        }
+        else if (arg == "--gains-file" && has_value) opt.gains_file = argv[++i];
+        else if (arg == "--time" && has_value) opt.time = std::atof(argv[++i]);
+        else if (arg == "--substeps" && has_value) opt.substeps = std::atoi(argv[++i]);
+        else if (arg == "--simple-plant") opt.simple_plant = true;
+        else if (arg == "--no-feedforward") opt.feedforward = false;
+        else if (arg == "--csv" && has_value) opt.csv = argv[++i];
+        else if (arg == "--json" && has_value) opt.json = argv[++i];
+        else {
+            opt.targets = 0;
+            break;
+        }
+    }
+    if (opt.targets < 1 || opt.time <= 0 || opt.substeps < 1) {
+        std::cerr << "Usage: evaluate [--arm single|double|triple] [--targets N] [--threads T]\n"
+                  << "                [--seed S] [--gains kp ki kd | --gains-file file]\n"
+                  << "                [--time seconds] [--substeps S] [--simple-plant]\n"
+                  << "                [--no-feedforward] [--csv file] [--json file]\n";
+        return 1;
+    }
+
+    // Each demo's arm
+    if (opt.arm == "single") return evaluate<1>(opt, Kinematics<1>(1.0));
+    if (opt.arm == "double") return evaluate<2>(opt, Kinematics<2>(2.0, 1.0));
+    if (opt.arm == "triple") return evaluate<3>(opt, Kinematics<3>(2.0, 1.0, 0.5));
+    std::cerr << "Unknown arm " << opt.arm << "\n";
+    return 1;
+}
@@ -0,0 +1,124 @@
+// Throughput of closed-form IK: Kinematics::inverse one target at a time
+// against BatchInverse, in double and float, for the Double_Joint and
+// Triple_Joint arms. Targets are uniform over the square around the reach,
+// so some are out of reach, as in a planner's candidate sets. Also checks
+// the batch answers against the scalar ones.
+//
+// Usage: ./ik_bench [--targets N] [--repeats R] [--threads T]
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <string>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/batch_inverse.h"
+#include "tool_common.h"
+
+struct Options {
+    size_t targets = 1 << 20;
+    int repeats = 20;
+    int threads = 1;
+};
+
+template <typename Work>
+double timePerTarget(const Options& opt, const Work& work) {
+    work();   // warm the caches
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < opt.repeats; r++) work();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds / opt.repeats / opt.targets;
+}
+
+template <int N, typename Scalar>
+void bench(const Options& opt, const Kinematics<N, double>& reference, const char* name) {
+    size_t n = opt.targets;
+    std::mt19937 rng(11);
+    double reach = reference.reach();
+    std::uniform_real_distribution<double> coord(-reach, reach), angle(-M_PI, M_PI);
+
+    std::vector<Scalar> x(n), y(n), phi(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (Scalar)coord(rng);
+        y[i] = (Scalar)coord(rng);
+        phi[i] = (Scalar)angle(rng);
+    }
+
+    std::array<Scalar, N> lengths;
+    for (int j = 0; j < N; j++) lengths[j] = (Scalar)reference.lengths[j];
+    Kinematics<N, Scalar> arm(lengths);
+    BatchInverse<N, Scalar> batch(arm, opt.threads);
+
+    std::vector<Scalar> out(N * n), scalar_out(N * n);
+    std::vector<uint8_t> reachable(n);
+    typename BatchInverse<N, Scalar>::Angles theta;
+    for (int j = 0; j < N; j++) theta[j] = &out[j * n];
+
+    double scalar_time = timePerTarget(opt, [&]() {
+        for (size_t i = 0; i < n; i++) {
+            typename Kinematics<N, Scalar>::JointAngles a;
+            if constexpr (N == 2) a = arm.inverse(Point<Scalar>{x[i], y[i]});
+            else a = arm.inverse(Point<Scalar>{x[i], y[i]}, phi[i]);
+            for (int j = 0; j < N; j++) scalar_out[j * n + i] = a[j];
+        }
+    });
+    double batch_time = timePerTarget(opt, [&]() {
+        if constexpr (N == 2) batch.solve(x.data(), y.data(), n, theta, reachable.data());
+        else batch.solve(x.data(), y.data(), phi.data(), n, theta, reachable.data());
+    });
+
+    // Compare with the scalar solver in double. Targets within rounding of
+    // the reach boundary can come out on either side; count those apart.
+    double worst = 0;
+    size_t in_reach = 0, mismatched = 0;
+    for (size_t i = 0; i < n; i++) {
+        in_reach += reachable[i];
+        typename Kinematics<N, double>::JointAngles exact;
+        if constexpr (N == 2) exact = reference.inverse(Position{x[i], y[i]});
+        else exact = reference.inverse(Position{x[i], y[i]}, phi[i]);
+        double diff = 0;
+        for (int j = 0; j < N; j++) {
+            diff = std::max(diff, std::fabs(std::remainder(out[j * n + i] - exact[j], 2 * M_PI)));
+        }
+        if (diff > 1e-2) mismatched++;
+        else worst = std::max(worst, diff);
+    }
+
+    std::cout << name << (sizeof(Scalar) == 8 ? " double: " : " float:  ")
+              << "scalar " << 1.0 / scalar_time / 1e6 << " M/s, batch " << 1.0 / batch_time / 1e6
+              << " M/s (x" << scalar_time / batch_time << "), " << 100.0 * in_reach / n
+              << "% in reach, max error " << worst << " rad";
+    if (mismatched) std::cout << ", " << mismatched << " differ at the reach boundary";
+    std::cout << "\n";
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--targets" && has_value) opt.targets = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--repeats" && has_value) opt.repeats = std::atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) opt.threads = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Usage: ik_bench [--targets N] [--repeats R] [--threads T]\n";
+            return 1;
+        }
+    }
+    if (opt.targets < 1 || opt.repeats < 1) return 1;
+    opt.threads = threadCount(opt.threads);
+
+    std::cout << opt.targets << " targets, " << opt.threads << " thread(s)\n";
+    Kinematics<2> two(2.0, 1.0);
+    Kinematics<3> three(2.0, 1.0, 0.5);
+    bench<2, double>(opt, two, "2 links");
+    bench<2, float>(opt, two, "2 links");
+    bench<3, double>(opt, three, "3 links");
+    bench<3, float>(opt, three, "3 links");
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Cost of forward kinematics and the Jacobian per call: the planar
+// Kinematics for three and six joints next to SpatialKinematics for a
+// 6-DOF UR5. Checks the spatial Jacobian against finite differences and
+// the quaternion conversions against each other, then times
+// SpatialIKSolver on random reachable poses and runs one of them through
+// the trajectory and PID tooling as an Episode.
+//
+// Usage: ./kinematics_bench [--calls N] [--solves N]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/spatial_kinematics.h"
+#include "../common/spatial_ik_solver.h"
+#include "../common/episode.h"
+
+// Results land here so the timed calls aren't optimised out
+volatile double sink;
+
+const int POOL = 1024;
+
+template <int N>
+std::vector<std::array<double, N>> randomAngles(std::mt19937& rng) {
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    std::vector<std::array<double, N>> out(POOL);
+    for (std::array<double, N>& q : out) {
+        for (double& a : q) a = angle(rng);
+    }
+    return out;
+}
+
+// Nanoseconds per call of call(angles) over the pool
+template <typename Angles, typename Call>
+double timeCalls(long calls, const std::vector<Angles>& pool, const Call& call) {
+    auto start = std::chrono::steady_clock::now();
+    for (long k = 0; k < calls; k++) call(pool[k & (POOL - 1)]);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+template <int N>
+void planar(long calls, std::mt19937& rng) {
+    std::array<double, N> lengths;
+    for (int j = 0; j < N; j++) lengths[j] = 1.0 - 0.1 * j;
+    Kinematics<N> arm(lengths);
+    std::vector<std::array<double, N>> pool = randomAngles<N>(rng);
+
+    double forward = timeCalls(calls, pool, [&](const std::array<double, N>& q) { sink = arm.forward(q)[N - 1].x; });
+    double jacobian = timeCalls(calls, pool, [&](const std::array<double, N>& q) { sink = arm.jacobian(q)[0][0]; });
+    std::cout << "Planar, " << N << " joints: forward " << forward << " ns, jacobian " << jacobian << " ns\n";
+}
+
+int main(int argc, char** argv) {
+    long calls = 2000000;
+    int solves = 10000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--calls" && has_value) calls = std::atol(argv[++i]);
+        else if (arg == "--solves" && has_value) solves = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Usage: kinematics_bench [--calls N] [--solves N]\n";
+            return 1;
+        }
+    }
+    if (calls < 1 || solves < 1) return 1;
+
+    std::mt19937 rng(5);
+    planar<3>(calls, rng);
+    planar<6>(calls, rng);
+
+    SpatialKinematics<6> ur5arm(ur5());
+    std::vector<std::array<double, 6>> pool = randomAngles<6>(rng);
+    double frames = timeCalls(calls, pool, [&](const std::array<double, 6>& q) { sink = ur5arm.forward(q)[5].p.x; });
+    double end = timeCalls(calls, pool, [&](const std::array<double, 6>& q) { sink = ur5arm.endEffector(q).p.x; });
+    double jacobian = timeCalls(calls, pool, [&](const std::array<double, 6>& q) { sink = ur5arm.jacobian(q)[0][0]; });
+    std::cout << "Spatial UR5, 6 joints: forward (every frame) " << frames << " ns, end effector only " << end
+              << " ns, jacobian " << jacobian << " ns\n";
+
+    // Jacobian against central differences of position and orientation
+    double jacobian_error = 0, quaternion_error = 0;
+    const double h = 1e-6;
+    for (int k = 0; k < 100; k++) {
+        const std::array<double, 6>& q = pool[k];
+        SpatialKinematics<6>::Jacobian J = ur5arm.jacobian(q);
+        Transform3<double> at = ur5arm.endEffector(q);
+        for (int j = 0; j < 6; j++) {
+            std::array<double, 6> plus = q, minus = q;
+            plus[j] += h;
+            minus[j] -= h;
+            Transform3<double> a = ur5arm.endEffector(plus), b = ur5arm.endEffector(minus);
+            Vec3<double> v = (a.p - b.p) * (1 / (2 * h));
+            Vec3<double> w = (a.rotation() * b.rotation().conjugate()).log() * (1 / (2 * h));
+            double diff[6] = {v.x, v.y, v.z, w.x, w.y, w.z};
+            for (int r = 0; r < 6; r++) jacobian_error = std::max(jacobian_error, std::fabs(diff[r] - J[r][j]));
+        }
+        Transform3<double> back = Transform3<double>::from(at.rotation(), at.p);
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) quaternion_error = std::max(quaternion_error, std::fabs(back.r[r][c] - at.r[r][c]));
+        }
+    }
+    std::cout << "Jacobian vs finite differences: " << jacobian_error << "; rotation -> quaternion -> rotation: "
+              << quaternion_error << "\n";
+
+    // IK to poses the arm can reach, from 0.3 rad off and from home
+    SpatialIKSolver<6> solver(ur5arm);
+    std::normal_distribution<double> nudge(0, 0.3);
+    std::array<double, 6> home = {0, -M_PI / 2, M_PI / 2, -M_PI / 2, -M_PI / 2, 0};
+    for (int from_home = 0; from_home < 2; from_home++) {
+        int converged = 0;
+        long iterations = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < solves; k++) {
+            const std::array<double, 6>& q = pool[k & (POOL - 1)];
+            std::array<double, 6> seed = home;
+            if (!from_home) {
+                for (int j = 0; j < 6; j++) seed[j] = q[j] + nudge(rng);
+            }
+            SpatialIKSolver<6>::Result r = solver.solve(ur5arm.endEffector(q), seed);
+            converged += r.converged;
+            iterations += r.iterations;
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / solves;
+        std::cout << "Pose IK from " << (from_home ? "home" : "0.3 rad off") << ": " << converged << " of " << solves
+                  << " converged, " << (double)iterations / solves << " iterations, " << us << " us per solve\n";
+    }
+
+    // One of them through the trajectory and PID tooling
+    Transform3<double> target = ur5arm.endEffector(pool[0]);
+    SpatialIKSolver<6>::Result r = solver.solve(target, home);
+    Episode<6>::Settings settings;
+    settings.kp.fill(300.0);
+    settings.ki.fill(0.03);
+    settings.kd.fill(20.0);
+    Episode<6>::Outcome out = Episode<6>::run(settings, home, r.angles);
+    Vec3<double> miss = ur5arm.endEffector(out.final_angles).p - target.p;
+    std::cout << "Home to that pose (IK error " << r.error << "): move " << out.move_time << " s, settled "
+              << out.settling_time << " s, end effector " << miss.norm() * 1000 << " mm off\n";
+    return 0;
+}
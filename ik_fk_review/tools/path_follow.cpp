@@ -0,0 +1,120 @@
+// Follows a Cartesian path with the Triple_Joint arm at control rate and
+// records how long each tick's IK takes.
+//
+// The path is a line, an arc, a curve through waypoints and a reach out
+// to near full stretch, where the singularity fallback has to step in.
+// Prints latency percentiles, tracking error and fallback counts, and
+// with --csv writes every tick.
+//
+// Usage: ./path_follow [--rate Hz] [--speed m/s] [--laps L] [--csv file]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/ik_solver.h"
+#include "../common/path.h"
+#include "../common/path_follower.h"
+
+struct Options {
+    double rate = 1000;
+    double speed = 0.5;
+    int laps = 20;
+    std::string csv;
+};
+
+Path<double> demoPath() {
+    const double deg = M_PI / 180;
+    Path<double> path(Pose<double>{{2.0, 0.5}, 30 * deg});
+    path.lineTo({{1.0, 1.5}, 90 * deg})
+        .arc({0.0, 1.5}, 120 * deg)
+        .curveThrough({{{-2.2, 0.0}, 180 * deg},
+                       {{-1.2, -1.9}, 238 * deg},
+                       {{1.0, -2.0}, 297 * deg}})
+        // Out along the x axis to within 1 mm of full reach
+        .lineTo({{3.499, 0.0}, 360 * deg})
+        .lineTo({{2.0, 0.5}, 390 * deg});
+    return path;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rate" && has_value) opt.rate = std::atof(argv[++i]);
+        else if (arg == "--speed" && has_value) opt.speed = std::atof(argv[++i]);
+        else if (arg == "--laps" && has_value) opt.laps = std::atoi(argv[++i]);
+        else if (arg == "--csv" && has_value) opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: path_follow [--rate Hz] [--speed m/s] [--laps L] [--csv file]\n";
+            return 1;
+        }
+    }
+    if (opt.rate <= 0 || opt.speed <= 0 || opt.laps < 1) return 1;
+
+    Kinematics<3> arm(2.0, 1.0, 0.5);
+    IKSolver<3> solver(arm);
+    Path<double> path = demoPath();
+    double dt = 1.0 / opt.rate;
+
+    // Start on the path, on the branch nearest a straight arm
+    Pose<double> start = path.start();
+    Kinematics<3>::JointAngles angles = Kinematics<3>::nearest(
+        arm.inverseAll(start.position, start.phi), {0.0, 0.0, 0.0});
+
+    std::ofstream csv;
+    if (!opt.csv.empty()) {
+        csv.open(opt.csv);
+        csv << "lap,tick,x,y,phi,theta1,theta2,theta3,error,iterations,near_singular,fallback,latency_us\n";
+    }
+
+    std::vector<double> latency;
+    double worst_error = 0, worst_tracking = 0;
+    long ticks = 0, iterations = 0, near = 0, fallbacks = 0;
+    for (int lap = 0; lap < opt.laps; lap++) {
+        PathFollower<3> follower(solver, path, opt.speed, dt, true, angles);
+        for (long tick = 0; !follower.done(); tick++) {
+            PathFollower<3>::Step step = follower.step();
+            latency.push_back(step.seconds * 1e6);
+            worst_error = std::max(worst_error, step.error);
+            if (!step.fallback) worst_tracking = std::max(worst_tracking, step.error);
+            iterations += step.iterations;
+            near += step.near_singular;
+            fallbacks += step.fallback;
+            ticks++;
+            if (csv.is_open()) {
+                csv << lap << "," << tick << "," << step.target.position.x << "," << step.target.position.y
+                    << "," << step.target.phi << "," << step.angles[0] << "," << step.angles[1] << ","
+                    << step.angles[2] << "," << step.error << "," << step.iterations << ","
+                    << step.near_singular << "," << step.fallback << "," << step.seconds * 1e6 << "\n";
+            }
+        }
+        angles = follower.angles();
+    }
+
+    std::vector<double> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) { return sorted[(size_t)(p * (sorted.size() - 1))]; };
+    double mean = 0;
+    for (double l : latency) mean += l;
+    mean /= latency.size();
+
+    double budget = 1e6 / opt.rate;
+    std::cout << "Path " << path.length() << " m at " << opt.speed << " m/s, " << opt.rate << " Hz, "
+              << opt.laps << " laps: " << ticks << " ticks\n"
+              << "Latency us: mean " << mean << ", p50 " << percentile(0.5) << ", p99 " << percentile(0.99)
+              << ", p99.9 " << percentile(0.999) << ", max " << sorted.back()
+              << " (budget " << budget << ")\n"
+              << "IK iterations per tick: " << (double)iterations / ticks << "\n"
+              << "Tracking error: " << worst_tracking << " m on the path, " << worst_error
+              << " m worst including fallback ticks\n"
+              << "Near singular: " << near << " ticks, fallback: " << fallbacks << " ticks\n"
+              << "Ticks over budget: " << (latency.size() - (std::upper_bound(sorted.begin(), sorted.end(), budget) - sorted.begin()))
+              << "\n";
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Cost per control tick of many PID loops: one PIDController object per
+// loop against a PIDBank stepping them all at once. Also checks that an
+// unlimited, unfiltered bank gives the same outputs as the objects.
+//
+// Usage: ./pid_bench [--ticks T]
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include "../common/pid_bank.h"
+#include "../Triple_Joint/controller.h"
+
+const int LOOPS = 4096;
+
+int main(int argc, char** argv) {
+    int ticks = 2000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ticks" && i + 1 < argc) ticks = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Usage: pid_bench [--ticks T]\n";
+            return 1;
+        }
+    }
+    if (ticks < 1) return 1;
+
+    const double dt = 0.001;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+
+    // Each loop drives a unit mass towards its own target
+    auto bank = std::make_unique<PIDBank<LOOPS>>(5.0, 0.1, 0.5);
+    std::vector<PIDController> objects(LOOPS, PIDController(5.0, 0.1, 0.5));
+    auto targets = std::make_unique<PIDBank<LOOPS>::Values>();
+    auto position = std::make_unique<PIDBank<LOOPS>::Values>();
+    auto velocity = std::make_unique<PIDBank<LOOPS>::Values>();
+    auto output = std::make_unique<PIDBank<LOOPS>::Values>();
+    for (int c = 0; c < LOOPS; c++) (*targets)[c] = angle(rng);
+
+    // seconds is the median tick, as this is a shared machine
+    auto simulate = [&](bool use_bank, double& seconds) {
+        position->fill(0);
+        velocity->fill(0);
+        bank->reset();
+        for (PIDController& pid : objects) pid.reset();
+        std::vector<double> times(ticks);
+        for (int t = 0; t < ticks; t++) {
+            auto begin = std::chrono::steady_clock::now();
+            if (use_bank) {
+                bank->compute(*position, *targets, dt, *output);
+            } else {
+                for (int c = 0; c < LOOPS; c++) (*output)[c] = objects[c].compute((*position)[c], (*targets)[c], dt);
+            }
+            times[t] = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            for (int c = 0; c < LOOPS; c++) {
+                (*velocity)[c] = ((*velocity)[c] + (*output)[c] * dt) * 0.95;
+                (*position)[c] += (*velocity)[c] * dt;
+            }
+        }
+        std::nth_element(times.begin(), times.begin() + ticks / 2, times.end());
+        seconds = times[ticks / 2];
+        return *position;
+    };
+
+    double object_seconds, bank_seconds;
+    PIDBank<LOOPS>::Values by_objects = simulate(false, object_seconds);
+    PIDBank<LOOPS>::Values by_bank = simulate(true, bank_seconds);
+    double worst = 0;
+    for (int c = 0; c < LOOPS; c++) worst = std::max(worst, std::fabs(by_objects[c] - by_bank[c]));
+
+    double updates = LOOPS;
+    std::cout << LOOPS << " loops, " << ticks << " ticks\n"
+              << "PIDController objects: " << object_seconds / updates * 1e9 << " ns per loop per tick\n"
+              << "PIDBank:               " << bank_seconds / updates * 1e9 << " ns per loop per tick ("
+              << object_seconds / bank_seconds << "x)\n"
+              << "Whole bank per tick:   " << bank_seconds * 1e6 << " us\n"
+              << "Largest difference in final positions: " << worst << "\n";
+
+    // Limits and filter on, to time the full path
+    bank->output_limit.fill(2.0);
+    bank->integral_limit.fill(0.5);
+    bank->derivative_smoothing.fill(0.9);
+    double limited_seconds;
+    simulate(true, limited_seconds);
+    std::cout << "With limits and filter: " << limited_seconds / updates * 1e9 << " ns per loop per tick\n";
+    return 0;
+}
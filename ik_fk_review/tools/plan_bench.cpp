@@ -0,0 +1,171 @@
+// Plans across many random cluttered scenes with Planner and reports how
+// long planning takes, how often it succeeds and what shortcutting does
+// to the path. Every path found is checked again at a quarter of the
+// planner's resolution, so a collision slipping between checked poses
+// would show.
+//
+// Each scene scatters circles and boxes around the arm and picks a clear
+// start and goal pose at random. The obstacles stay beyond the first
+// link: one it could hit would split the base joint's range in two and
+// leave most start and goal pairs with no path at all.
+//
+// Usage: ./plan_bench [--arm double|triple] [--scenes S] [--obstacles K]
+//                     [--seed S] [--csv file]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include "../common/kinematics.h"
+#include "../common/planner.h"
+#include "tool_common.h"
+
+struct Options {
+    std::string arm = "triple";
+    int scenes = 1000;
+    int obstacles = 8;
+    uint64_t seed = 1;
+    std::string csv;
+};
+
+// Obstacles whose nearest point is between inner and outer from the base
+Obstacles<double> scene(Random& rng, int count, double inner, double outer) {
+    Obstacles<double> out;
+    for (int k = 0; k < count; k++) {
+        double angle = rng.uniform(-M_PI, M_PI);
+        Point<double> direction{std::cos(angle), std::sin(angle)};
+        if (k % 2 == 0) {
+            double radius = rng.uniform(0.1, 0.3);
+            double distance = rng.uniform(inner, outer) + radius;
+            out.circles.push_back({{distance * direction.x, distance * direction.y}, radius});
+        } else {
+            double w = rng.uniform(0.1, 0.25), h = rng.uniform(0.1, 0.25);
+            double distance = rng.uniform(inner, outer) + std::hypot(w, h);
+            Point<double> centre{distance * direction.x, distance * direction.y};
+            out.boxes.push_back({{centre.x - w, centre.y - h}, {centre.x + w, centre.y + h}});
+        }
+    }
+    return out;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+template <int N>
+int bench(const Options& opt, const Kinematics<N>& arm) {
+    Random rng{opt.seed};
+    std::ofstream csv;
+    if (!opt.csv.empty()) {
+        csv.open(opt.csv);
+        csv << "scene,found,ms,nodes,poses_checked,raw_length,length,waypoints\n";
+    }
+
+    std::vector<double> ms;
+    double nodes = 0, poses = 0, raw = 0, shortened = 0, seconds = 0;
+    int found = 0, failed = 0, collisions = 0;
+    for (int s = 0; s < opt.scenes; s++) {
+        Planner<N> planner(arm, scene(rng, opt.obstacles, arm.lengths[0] + 0.2, arm.reach()), (unsigned)s + 1);
+
+        // Clear start and goal, far enough apart to need a plan
+        std::array<double, N> start, goal;
+        int tries = 0;
+        do {
+            for (int j = 0; j < N; j++) {
+                start[j] = rng.uniform(-M_PI, M_PI);
+                goal[j] = rng.uniform(-M_PI, M_PI);
+            }
+        } while (++tries < 1000 && (planner.collides(start) || planner.collides(goal) || planner.clear(start, goal)));
+        if (tries == 1000) continue;
+
+        typename Planner<N>::Result r = planner.plan(start, goal);
+        ms.push_back(r.seconds * 1000);
+        seconds += r.seconds;
+        poses += r.poses_checked;
+        nodes += r.nodes;
+        if (r.found) {
+            found++;
+            raw += r.raw_length;
+            shortened += r.length;
+            Planner<N> fine = planner;
+            fine.resolution /= 4;
+            for (size_t i = 1; i < r.waypoints.size(); i++) collisions += !fine.clear(r.waypoints[i - 1], r.waypoints[i]);
+        } else {
+            failed++;
+        }
+        if (csv) {
+            csv << s << "," << r.found << "," << r.seconds * 1000 << "," << r.nodes << "," << r.poses_checked
+                << "," << r.raw_length << "," << r.length << "," << r.waypoints.size() << "\n";
+        }
+    }
+
+    int planned = found + failed;
+    std::cout << opt.arm << " arm, " << planned << " scenes of " << opt.obstacles << " obstacles\n"
+              << "Found " << found << ", not found in " << Planner<N>(arm, {}).max_samples << " samples: " << failed
+              << "; segments colliding on the finer check: " << collisions << "\n"
+              << "Planning ms: mean " << seconds * 1000 / std::max(1, planned) << ", p50 " << percentile(ms, 0.5)
+              << ", p90 " << percentile(ms, 0.9) << ", p99 " << percentile(ms, 0.99) << ", max "
+              << percentile(ms, 1.0) << "\n"
+              << "Per plan: " << nodes / std::max(1, planned) << " nodes, " << poses / std::max(1, planned)
+              << " poses checked (" << poses / seconds / 1e6 << " M poses/s overall)\n"
+              << "Joint-space length: " << raw / std::max(1, found) << " rad as found, "
+              << shortened / std::max(1, found) << " rad shortcut\n";
+
+    // Edge checking alone: long edges in an empty scene, the outer joints
+    // kept from folding back onto the arm so nearly all are clear
+    Planner<N> empty(arm, {});
+    const int edges = 2000;
+    long edge_poses = 0;
+    int clear_edges = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int k = 0; k < edges; k++) {
+        std::array<double, N> from, to;
+        for (int j = 0; j < N; j++) {
+            double limit = j ? 2.0 : M_PI;
+            from[j] = rng.uniform(-limit, limit);
+            to[j] = rng.uniform(-limit, limit);
+        }
+        edge_poses += empty.poses(from, to) + 1;
+        clear_edges += empty.clear(from, to);
+    }
+    double edge_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "Edges in an empty scene (" << clear_edges << " of " << edges << " clear): "
+              << edge_poses / edges << " poses each, " << edge_poses / edge_seconds / 1e6 << " M poses/s\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--arm" && has_value) opt.arm = argv[++i];
+        else if (arg == "--scenes" && has_value) opt.scenes = std::atoi(argv[++i]);
+        else if (arg == "--obstacles" && has_value) opt.obstacles = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--csv" && has_value) opt.csv = argv[++i];
+        else {
+            opt.scenes = 0;
+            break;
+        }
+    }
+    if (opt.scenes < 1 || opt.obstacles < 0) {
+        std::cerr << "Usage: plan_bench [--arm double|triple] [--scenes S] [--obstacles K]\n"
+                  << "                  [--seed S] [--csv file]\n";
+        return 1;
+    }
+
+    // Each demo's arm
+    if (opt.arm == "double") return bench<2>(opt, Kinematics<2>(2.0, 1.0));
+    if (opt.arm == "triple") return bench<3>(opt, Kinematics<3>(2.0, 1.0, 0.5));
+    std::cerr << "Unknown arm " << opt.arm << "\n";
+    return 1;
+}
@@ -0,0 +1,153 @@
+// Builds an IK seed table (see common/seed_table.h) for one arm, then maps
+// it back in and compares solves on random reachable targets started from
+// a straight arm, from the table, and warm from a nearby configuration.
+//
+// Usage: ./seed_table L1 [L2 ... L7] [--grid cells] [--phi-bins B]
+//                     [--restarts R] [--queries Q] [--out file]
+//
+// --phi-bins > 0 builds the table for targets with an end-link angle, as
+// the Triple_Joint demo gives; 0 (default) for position-only targets.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "../common/kinematics.h"
+#include "../common/ik_solver.h"
+#include "../common/seed_table.h"
+
+struct Options {
+    std::vector<double> lengths;
+    int grid = 128;
+    int phi_bins = 0;
+    int restarts = 3;
+    int queries = 100000;
+    std::string out = "seeds.bin";
+};
+
+struct Stats {
+    long iterations = 0;
+    long converged = 0;
+    double seconds = 0;
+};
+
+template <int N>
+int build(const Options& opt) {
+    Kinematics<N> arm(std::array<double, N>{});
+    std::copy(opt.lengths.begin(), opt.lengths.end(), arm.lengths.begin());
+    IKSolver<N> solver(arm);
+    bool use_phi = opt.phi_bins > 0;
+
+    auto start = std::chrono::steady_clock::now();
+    long reached = SeedTable<N>::build(opt.out, solver, opt.grid, opt.phi_bins, opt.restarts);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (reached < 0) {
+        std::cerr << "Could not write " << opt.out << "\n";
+        return 1;
+    }
+    long cells = (long)opt.grid * opt.grid * std::max(1, opt.phi_bins);
+    std::cout << N << " links, " << opt.grid << "x" << opt.grid << " cells"
+              << (use_phi ? " x " + std::to_string(opt.phi_bins) + " phi bins" : "") << "\n"
+              << "Built in " << seconds << " s, " << reached << " of " << cells << " cells reachable\n";
+
+    SeedTable<N> table;
+    if (!table.open(opt.out, arm)) {
+        std::cerr << "Could not map " << opt.out << "\n";
+        return 1;
+    }
+
+    // Targets from random configurations, so all of them can be reached
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> any_angle(-M_PI, M_PI);
+    std::vector<Point<double>> targets(opt.queries);
+    std::vector<double> phis(opt.queries);
+    std::vector<typename Kinematics<N>::JointAngles> origins(opt.queries);
+    for (int q = 0; q < opt.queries; q++) {
+        typename Kinematics<N>::JointAngles theta;
+        double phi = 0;
+        for (int j = 0; j < N; j++) {
+            theta[j] = any_angle(rng);
+            phi += theta[j];
+        }
+        origins[q] = theta;
+        targets[q] = arm.endEffector(theta);
+        phis[q] = phi;
+    }
+
+    // Warm start: the configuration a target came from, knocked by up to
+    // 0.05 rad per joint, as from the previous control step
+    std::uniform_real_distribution<double> knock(-0.05, 0.05);
+    std::vector<typename Kinematics<N>::JointAngles> warm(opt.queries);
+    for (int q = 0; q < opt.queries; q++) {
+        for (int j = 0; j < N; j++) warm[q][j] = origins[q][j] + knock(rng);
+    }
+
+    enum Start { STRAIGHT, SEEDED, WARM };
+    auto run = [&](Start from) {
+        Stats stats;
+        typename Kinematics<N>::JointAngles straight;
+        straight.fill(0);
+        auto begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < opt.queries; q++) {
+            typename Kinematics<N>::JointAngles guess = straight;
+            if (from == SEEDED) guess = use_phi ? table.seed(targets[q], phis[q]) : table.seed(targets[q]);
+            if (from == WARM) guess = warm[q];
+            typename IKSolver<N>::Result r = use_phi ? solver.solve(targets[q], phis[q], guess)
+                                                     : solver.solve(targets[q], guess);
+            stats.iterations += r.iterations;
+            stats.converged += r.converged;
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return stats;
+    };
+    auto report = [&](const char* name, const Stats& s) {
+        std::cout << name << (double)s.iterations / opt.queries << " iterations, "
+                  << s.seconds / opt.queries * 1e6 << " us per solve, "
+                  << 100.0 * s.converged / opt.queries << "% converged\n";
+    };
+
+    std::cout << opt.queries << " random reachable targets:\n";
+    report("  straight arm start: ", run(STRAIGHT));
+    report("  table seed:         ", run(SEEDED));
+    report("  warm start:         ", run(WARM));
+    std::cout << "Wrote " << opt.out << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--grid" && has_value) opt.grid = std::atoi(argv[++i]);
+        else if (arg == "--phi-bins" && has_value) opt.phi_bins = std::atoi(argv[++i]);
+        else if (arg == "--restarts" && has_value) opt.restarts = std::atoi(argv[++i]);
+        else if (arg == "--queries" && has_value) opt.queries = std::atoi(argv[++i]);
+        else if (arg == "--out" && has_value) opt.out = argv[++i];
+        else if (arg[0] != '-') opt.lengths.push_back(std::atof(arg.c_str()));
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (opt.lengths.empty() || opt.lengths.size() > 7 || opt.grid < 2 || opt.phi_bins < 0
+        || opt.restarts < 0 || opt.restarts > 250 || opt.queries < 1) {
+        std::cerr << "Usage: seed_table L1 [L2 ... L7] [--grid cells] [--phi-bins B] "
+                  << "[--restarts R] [--queries Q] [--out file]\n";
+        return 1;
+    }
+
+    switch (opt.lengths.size()) {
+    case 1: return build<1>(opt);
+    case 2: return build<2>(opt);
+    case 3: return build<3>(opt);
+    case 4: return build<4>(opt);
+    case 5: return build<5>(opt);
+    case 6: return build<6>(opt);
+    default: return build<7>(opt);
+    }
+}
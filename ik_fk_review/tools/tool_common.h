@@ -0,0 +1,35 @@
+#ifndef TOOL_COMMON_H
+#define TOOL_COMMON_H
+
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+// Bits the command-line tools share.
+
+// splitmix64: the same stream on every platform, and cheap enough to
+// give each thread its own, with Box-Muller for normals
+struct Random {
+    uint64_t state;
+
+    double uniform(double low, double high) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        return low + (high - low) * (double)(z >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double normal() {
+        double u = uniform(1e-300, 1.0), v = uniform(0.0, 2 * M_PI);
+        return std::sqrt(-2 * std::log(u)) * std::cos(v);
+    }
+};
+
+// Thread count for a --threads value; 0 or less means one per core
+inline int threadCount(int requested) {
+    return requested > 0 ? requested : (int)std::max(1u, std::thread::hardware_concurrency());
+}
+
+#endif // TOOL_COMMON_H
@@ -0,0 +1,384 @@
+// Tunes the PID gains of each joint of a demo arm and writes them to the
+// gains file the mains load.
+//
+// The mains drive the rigid-body arm by computed torque, which leaves each
+// joint a double integrator (as far as the model is right), so the search
+// runs on that: Episode's simple plant with nothing lost per tick, about
+// fifty times cheaper than stepping Dynamics. The result is checked on the
+// rigid-body arm, on a second batch of moves it wasn't tuned on.
+//
+// 1. Relay test: a joint is driven by a relay with a little hysteresis
+//    until it oscillates steadily. The amplitude and period give the
+//    ultimate gain and period, and the Ziegler-Nichols "no overshoot"
+//    rule turns them into a starting point. An undamped double
+//    integrator never settles into that oscillation, so the test runs
+//    on a lossy version of the plant, keeping --relay-keep of its
+//    velocity per tick. It only has to beat the current gains to be
+//    the starting point, not be right.
+// 2. Search: an evolution strategy over log(kp, ki, kd), from the relay
+//    seed or the gains in use, whichever scores better. Joints are tuned
+//    one at a time, base outwards, for a number of sweeps. Each
+//    generation draws a population around the mean, scores every
+//    candidate on the same batch of headless Episodes (split across
+//    threads) and moves the mean to the best quarter; the step grows
+//    while that improves on the best so far and shrinks when it doesn't.
+//
+// Score is the mean settling time over the batch, a run that never
+// settles counting as two episode lengths and more the further out of the
+// band it ended, with a penalty once any
+// joint overshoots by more than the limit. The simulated plant has no
+// noise or delay, so nothing stops the gains running away on their own:
+// they are kept to those that put a double integrator's closed-loop poles
+// no faster than --bandwidth (kp <= 3w^2, ki <= w^3, kd <= 3w), and the
+// PID output is clamped to --limit, which is saved with the gains so the
+// mains clamp it the same way. Gains whose rigid-body check overshoots
+// by more than --overshoot aren't saved. Feedforward is off by default:
+// the demos' feedforward inverts the plant exactly, which would leave the
+// gains nothing to do.
+//
+// Usage: ./tune [--arm single|double|triple] [--episodes E] [--population P]
+//               [--generations G] [--sweeps S] [--overshoot rad] [--bandwidth rad/s]
+//               [--limit u] [--keep k] [--relay-keep k] [--time seconds]
+//               [--threads T] [--seed S] [--feedforward] [--out file]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "../common/episode.h"
+#include "../common/gains.h"
+#include "tool_common.h"
+
+struct Options {
+    std::string arm = "triple";
+    int episodes = 256;
+    int population = 24;
+    int generations = 30;       // per joint per sweep
+    int sweeps = 2;
+    double overshoot = 0.005;   // rad
+    double time = 5.0;
+    double bandwidth = 20.0;    // rad/s; at 10 ramp lag overshoots past 0.005
+    double limit = 20.0;        // on the PID output, rad/s^2
+    double keep = 1.0;          // velocity the tuning plant keeps per tick
+    double relay_keep = 0.9;    // and the relay test's plant
+    int threads = 0;
+    uint64_t seed = 1;
+    bool feedforward = false;
+    std::string out = "../gains.cfg";
+};
+
+// Ultimate gain and period of one joint from a relay test
+struct Relay {
+    bool steady;   // false when the oscillation kept growing
+    double ultimate_gain, ultimate_period;
+};
+
+// Drives vel += u * dt, vel *= keep, theta += vel * dt with u = +-1,
+// switching when the error leaves +-hysteresis, and measures the
+// oscillation once it has settled
+Relay relayTest(double keep, double dt, double hysteresis = 0.005) {
+    const double h = 1.0;
+    const int ticks = 4000, settle = 2000;
+    double theta = 0.2, vel = 0, u = h, low = 1e9, high = -1e9, early = 0;
+    int last_rise = -1, periods = 0, period_ticks = 0;
+    for (int k = 0; k < ticks; k++) {
+        double error = -theta;
+        double next = error > hysteresis ? h : (error < -hysteresis ? -h : u);
+        if (k > settle && next > 0 && u < 0) {
+            if (last_rise >= 0) {
+                periods++;
+                period_ticks += k - last_rise;
+            }
+            last_rise = k;
+        }
+        u = next;
+        vel = (vel + u * dt) * keep;
+        theta += vel * dt;
+        if (k > settle) {
+            low = std::min(low, theta);
+            high = std::max(high, theta);
+        }
+        if (k == (settle + ticks) / 2) early = (high - low) / 2;
+    }
+    double amplitude = (high - low) / 2;
+    return {amplitude < 1.1 * early, 4 * h / (M_PI * amplitude), periods ? period_ticks * dt / periods : dt};
+}
+
+template <int N>
+struct Gains {
+    std::array<double, N> kp, ki, kd;
+};
+
+template <int N>
+struct Score {
+    double cost = 0;
+    double settling = 0;        // mean over the runs that settled
+    double overshoot = 0;       // worst run
+    int unsettled = 0;
+};
+
+template <int N>
+struct Move {
+    std::array<double, N> start, goal;
+};
+
+template <int N>
+Score<N> score(typename Episode<N>::Settings settings, const Gains<N>& gains,
+               const std::vector<Move<N>>& moves, double overshoot_limit) {
+    settings.kp = gains.kp;
+    settings.ki = gains.ki;
+    settings.kd = gains.kd;
+    Score<N> s;
+    int settled = 0;
+    for (const Move<N>& move : moves) {
+        typename Episode<N>::Outcome out = Episode<N>::run(settings, move.start, move.goal);
+        s.overshoot = std::max(s.overshoot, out.overshoot);
+        if (out.settling_time < 0) {
+            // Graded by how far out it ended, so there's a way downhill
+            s.unsettled++;
+            s.cost += settings.duration * (2 + out.final_error / settings.tolerance);
+        } else {
+            settled++;
+            s.settling += out.settling_time;
+            s.cost += out.settling_time;
+        }
+    }
+    s.cost /= moves.size();
+    if (settled) s.settling /= settled;
+    if (s.overshoot > overshoot_limit) s.cost += 10 * settings.duration * (s.overshoot / overshoot_limit - 1);
+    return s;
+}
+
+template <int N>
+Gains<N> fromLog(const std::array<double, 3 * N>& x) {
+    Gains<N> g;
+    for (int j = 0; j < N; j++) {
+        g.kp[j] = std::exp(x[3 * j]);
+        g.ki[j] = std::exp(x[3 * j + 1]);
+        g.kd[j] = std::exp(x[3 * j + 2]);
+    }
+    return g;
+}
+
+// Keeps log gains inside the bandwidth box
+template <int N>
+void clampGains(std::array<double, 3 * N>& x, double bandwidth) {
+    const double top[3] = {std::log(3 * bandwidth * bandwidth), std::log(bandwidth * bandwidth * bandwidth),
+                           std::log(3 * bandwidth)};
+    for (int k = 0; k < 3 * N; k++) x[k] = std::min(x[k], top[k % 3]);
+}
+
+template <int N>
+std::vector<Move<N>> drawMoves(int count, uint64_t seed) {
+    // From rest at the demos' start pose to anywhere within half a turn
+    Random rng{seed};
+    std::vector<Move<N>> moves(count);
+    for (Move<N>& m : moves) {
+        m.start.fill(0);
+        for (int j = 0; j < N; j++) m.goal[j] = rng.uniform(-M_PI, M_PI);
+    }
+    return moves;
+}
+
+template <int N>
+void report(const char* label, const Gains<N>& g, const Score<N>& tuned, const Score<N>& check) {
+    std::cout << label << ":";
+    for (int j = 0; j < N; j++) std::cout << "  [" << g.kp[j] << " " << g.ki[j] << " " << g.kd[j] << "]";
+    std::cout << "\n    settling " << tuned.settling << " s, unsettled " << tuned.unsettled
+              << ", overshoot " << tuned.overshoot << " rad, cost " << tuned.cost
+              << "\n    rigid body, other moves: settling " << check.settling << " s, unsettled "
+              << check.unsettled << ", overshoot " << check.overshoot << " rad\n";
+}
+
+template <int N>
+int tune(const Options& opt, const Kinematics<N>& arm) {
+    typename Episode<N>::Settings settings;
+    settings.duration = opt.time;
+    settings.keep = opt.keep;
+    settings.feedforward = opt.feedforward;
+    settings.output_limit.fill(opt.limit);
+
+    // The check runs the mains' plant
+    Dynamics<N> dynamics(arm);
+    typename Episode<N>::Settings rigid = settings;
+    rigid.dynamics = &dynamics;
+    rigid.substeps = 10;
+
+    std::vector<Move<N>> moves = drawMoves<N>(opt.episodes, opt.seed);
+    std::vector<Move<N>> held_out = drawMoves<N>(opt.episodes, opt.seed + 1000003);
+    int threads = threadCount(opt.threads);
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Relay seed; every joint has the same plant, but each gets its own test
+    std::array<double, 3 * N> mean;
+    bool seeded = true;
+    for (int j = 0; j < N; j++) {
+        Relay r = relayTest(opt.relay_keep, settings.dt);
+        seeded = seeded && r.steady;
+        mean[3 * j] = std::log(0.2 * r.ultimate_gain);
+        mean[3 * j + 1] = std::log(0.4 * r.ultimate_gain / r.ultimate_period);
+        mean[3 * j + 2] = std::log(0.066 * r.ultimate_gain * r.ultimate_period);
+        if (j == 0 && r.steady) {
+            std::cout << "Relay test: ultimate gain " << r.ultimate_gain << ", period "
+                      << r.ultimate_period << " s\n";
+        }
+    }
+    if (!seeded) std::cout << "Relay test: no steady oscillation, no seed\n";
+    clampGains<N>(mean, opt.bandwidth);
+
+    // The gains in use now: the demos' own, or the file's if it has them
+    Gains<N> current;
+    current.kp.fill(5.0);
+    current.ki.fill(0.1);
+    current.kd.fill(0.5);
+    std::array<double, N> file_limit;   // scored with --limit regardless
+    loadGains<N, double>(opt.out, opt.arm, current.kp, current.ki, current.kd, file_limit);
+    Score<N> current_score = score<N>(settings, current, moves, opt.overshoot);
+    report("Current gains", current, current_score, score<N>(rigid, current, held_out, opt.overshoot));
+    Score<N> seed_score;
+    if (seeded) {
+        Gains<N> seed_gains = fromLog<N>(mean);
+        seed_score = score<N>(settings, seed_gains, moves, opt.overshoot);
+        report("Relay seed", seed_gains, seed_score, score<N>(rigid, seed_gains, held_out, opt.overshoot));
+    }
+
+    // Search from whichever starts better. The relay rules assume a plant
+    // that settles on its own; this one integrates, and tracking a ramp
+    // with their integral gain overshoots, so it's often the current gains.
+    if (!seeded || current_score.cost < seed_score.cost) {
+        for (int j = 0; j < N; j++) {
+            mean[3 * j] = std::log(current.kp[j]);
+            mean[3 * j + 1] = std::log(current.ki[j]);
+            mean[3 * j + 2] = std::log(current.kd[j]);
+        }
+        clampGains<N>(mean, opt.bandwidth);
+    }
+    std::array<double, 3 * N> best = mean;
+    double best_cost = score<N>(settings, fromLog<N>(mean), moves, opt.overshoot).cost;
+    const int parents = std::max(1, opt.population / 4);
+    Random rng{opt.seed * 0x100000001B3ull};
+
+    // One joint's three gains at a time, the others held at their best:
+    // searching all 3N at once stalls on the shared overshoot limit
+    std::vector<std::array<double, 3 * N>> candidates(opt.population);
+    std::vector<double> costs(opt.population);
+    std::vector<int> order(opt.population);
+    for (int sweep = 0; sweep < opt.sweeps; sweep++) {
+        for (int j = 0; j < N; j++) {
+            mean = best;
+            double step = 0.5;   // log space
+            for (int generation = 0; generation < opt.generations; generation++) {
+                // Candidate 0 is the best so far, so the mean can't drift off it
+                candidates[0] = best;
+                for (int c = 1; c < opt.population; c++) {
+                    candidates[c] = best;
+                    for (int k = 3 * j; k < 3 * j + 3; k++) candidates[c][k] = mean[k] + step * rng.normal();
+                    clampGains<N>(candidates[c], opt.bandwidth);
+                }
+
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; t++) {
+                    workers.emplace_back([&, t]() {
+                        for (int c = t; c < opt.population; c += threads) {
+                            costs[c] = score<N>(settings, fromLog<N>(candidates[c]), moves, opt.overshoot).cost;
+                        }
+                    });
+                }
+                for (std::thread& w : workers) w.join();
+
+                for (int c = 0; c < opt.population; c++) order[c] = c;
+                std::sort(order.begin(), order.end(), [&](int a, int b) { return costs[a] < costs[b]; });
+                for (int k = 3 * j; k < 3 * j + 3; k++) {
+                    mean[k] = 0;
+                    for (int p = 0; p < parents; p++) mean[k] += candidates[order[p]][k] / parents;
+                }
+                // Widen while it keeps improving, narrow when it stalls
+                if (costs[order[0]] < best_cost) {
+                    best_cost = costs[order[0]];
+                    best = candidates[order[0]];
+                    step = std::min(1.0, step * 1.2);
+                } else {
+                    step *= 0.8;
+                }
+            }
+            std::cout << "Sweep " << sweep << ", joint " << j << ": best cost " << best_cost << "\n";
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    Gains<N> tuned = fromLog<N>(best);
+    Score<N> tuned_score = score<N>(settings, tuned, moves, opt.overshoot);
+    Score<N> check = score<N>(rigid, tuned, held_out, opt.overshoot);
+    report("Tuned", tuned, tuned_score, check);
+    std::cout << (long)opt.sweeps * N * opt.generations * opt.population * opt.episodes << " episodes on " << threads
+              << " thread(s) in " << seconds << " s\n";
+
+    // Gains that miss the limit on the mains' plant don't replace the file
+    if (check.overshoot > opt.overshoot) {
+        std::cerr << "Overshoot " << check.overshoot << " rad on the rigid-body check is over the "
+                  << opt.overshoot << " rad limit, not writing " << opt.out << "\n";
+        return 1;
+    }
+
+    std::ostringstream comment;
+    comment << "tuned over " << opt.episodes << " moves" << (opt.feedforward ? "" : " without feedforward")
+            << "; rigid body, other moves: settling " << check.settling << " s mean, " << check.unsettled
+            << " unsettled, overshoot " << check.overshoot << " rad worst";
+    if (!saveGains<N, double>(opt.out, opt.arm, comment.str(), tuned.kp, tuned.ki, tuned.kd,
+                              settings.output_limit)) {
+        std::cerr << "Could not write " << opt.out << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << opt.out << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--arm" && has_value) opt.arm = argv[++i];
+        else if (arg == "--episodes" && has_value) opt.episodes = std::atoi(argv[++i]);
+        else if (arg == "--population" && has_value) opt.population = std::atoi(argv[++i]);
+        else if (arg == "--generations" && has_value) opt.generations = std::atoi(argv[++i]);
+        else if (arg == "--sweeps" && has_value) opt.sweeps = std::atoi(argv[++i]);
+        else if (arg == "--overshoot" && has_value) opt.overshoot = std::atof(argv[++i]);
+        else if (arg == "--bandwidth" && has_value) opt.bandwidth = std::atof(argv[++i]);
+        else if (arg == "--limit" && has_value) opt.limit = std::atof(argv[++i]);
+        else if (arg == "--keep" && has_value) opt.keep = std::atof(argv[++i]);
+        else if (arg == "--relay-keep" && has_value) opt.relay_keep = std::atof(argv[++i]);
+        else if (arg == "--time" && has_value) opt.time = std::atof(argv[++i]);
+        else if (arg == "--threads" && has_value) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--feedforward") opt.feedforward = true;
+        else if (arg == "--out" && has_value) opt.out = argv[++i];
+        else {
+            opt.episodes = 0;
+            break;
+        }
+    }
+    if (opt.episodes < 1 || opt.population < 2 || opt.generations < 0 || opt.sweeps < 0 || opt.overshoot <= 0 ||
+        opt.bandwidth <= 0 || opt.limit <= 0 || opt.keep <= 0 || opt.relay_keep <= 0 ||
+        opt.relay_keep >= 1 || opt.time <= 0) {
+        std::cerr << "Usage: tune [--arm single|double|triple] [--episodes E] [--population P]\n"
+                  << "            [--generations G] [--sweeps S] [--overshoot rad] [--bandwidth rad/s]\n"
+                  << "            [--limit u] [--keep k] [--relay-keep k] [--time seconds]\n"
+                  << "            [--threads T] [--seed S] [--feedforward] [--out file]\n";
+        return 1;
+    }
+
+    // The demos' arms
+    if (opt.arm == "single") return tune<1>(opt, Kinematics<1>(1.0));
+    if (opt.arm == "double") return tune<2>(opt, Kinematics<2>(2.0, 1.0));
+    if (opt.arm == "triple") return tune<3>(opt, Kinematics<3>(2.0, 1.0, 0.5));
+    std::cerr << "Unknown arm " << opt.arm << "\n";
+    return 1;
+}
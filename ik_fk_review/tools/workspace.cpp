@@ -0,0 +1,204 @@
+// Workspace sampler for sizing planar arms.
+//
+// Draws random joint configurations, runs them through BatchKinematics
+// and rasterises the end effector into a grid over the arm's reach:
+//   <out>_reach.pgm   how often each cell was reached (log scale, black = never)
+//   <out>_manip.pgm   mean manipulability sqrt(det(J J^T)) in each cell
+//
+// Usage: ./workspace L1 [L2 ... L7] [--samples N] [--grid cells]
+//                    [--range degrees] [--threads T] [--seed S] [--out prefix]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "../common/batch_kinematics.h"
+#include "tool_common.h"
+
+struct Options {
+    std::vector<double> lengths;
+    long long samples = 100000000;
+    int grid = 512;
+    double range = 180.0;   // each joint drawn from +-range degrees
+    int threads = 0;
+    uint64_t seed = 1;
+    std::string out = "workspace";
+};
+
+// Per-thread totals, merged at the end
+struct Maps {
+    std::vector<uint32_t> count;
+    std::vector<double> manipulability;
+
+    void reset(int cells) {
+        count.assign(cells, 0);
+        manipulability.assign(cells, 0.0);
+    }
+};
+
+template <int N>
+void sampleRange(const BatchKinematics<N, double>& batch, const Options& opt,
+                 long long count, uint64_t seed, Maps& maps) {
+    const int chunk = 4096;
+    std::vector<double> theta(N * chunk), jx(N * chunk), jy(N * chunk);
+    typename BatchKinematics<N, double>::Angles angles;
+    typename BatchKinematics<N, double>::Coordinates xs, ys;
+    for (int j = 0; j < N; j++) {
+        angles[j] = &theta[j * chunk];
+        xs[j] = &jx[j * chunk];
+        ys[j] = &jy[j * chunk];
+    }
+
+    double reach = batch.arm.reach();
+    double cell_scale = opt.grid / (2 * reach);
+    double limit = opt.range * M_PI / 180.0;
+    Random rng{seed};
+
+    for (long long done = 0; done < count; done += chunk) {
+        int n = (int)std::min<long long>(chunk, count - done);
+        for (int j = 0; j < N; j++) {
+            for (int i = 0; i < n; i++) theta[j * chunk + i] = rng.uniform(-limit, limit);
+        }
+        batch.joints(angles, n, xs, ys);
+
+        const double* ex = xs[N - 1];
+        const double* ey = ys[N - 1];
+        for (int i = 0; i < n; i++) {
+            // Jacobian column j is the end effector's offset from joint j
+            // turned by 90 degrees: (-(ey - by), ex - bx)
+            double aa = 0, bb = 0, ab = 0;
+            for (int j = 0; j < N; j++) {
+                double bx = j ? xs[j - 1][i] : 0.0;
+                double by = j ? ys[j - 1][i] : 0.0;
+                double a = by - ey[i];
+                double b = ex[i] - bx;
+                aa += a * a;
+                bb += b * b;
+                ab += a * b;
+            }
+            // A single joint only moves along a circle: use |J| instead
+            double w = (N == 1) ? std::sqrt(aa + bb) : std::sqrt(std::max(0.0, aa * bb - ab * ab));
+
+            int cx = std::min(opt.grid - 1, std::max(0, (int)((ex[i] + reach) * cell_scale)));
+            int cy = std::min(opt.grid - 1, std::max(0, (int)((reach - ey[i]) * cell_scale)));
+            int cell = cy * opt.grid + cx;
+            maps.count[cell]++;
+            maps.manipulability[cell] += w;
+        }
+    }
+}
+
+void writePgm(const std::string& path, int grid, const std::vector<unsigned char>& pixels) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P5\n" << grid << " " << grid << "\n255\n";
+    file.write((const char*)pixels.data(), pixels.size());
+}
+
+template <int N>
+int sample(const Options& opt) {
+    Kinematics<N> arm(std::array<double, N>{});
+    std::copy(opt.lengths.begin(), opt.lengths.end(), arm.lengths.begin());
+    // Threads are split here, so each batch call stays on its own thread
+    BatchKinematics<N, double> batch(arm, 1);
+
+    int threads = threadCount(opt.threads);
+    int cells = opt.grid * opt.grid;
+    std::vector<Maps> maps(threads);
+    for (Maps& m : maps) m.reset(cells);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    long long per_thread = (opt.samples + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        long long begin = t * per_thread;
+        long long count = std::max(0LL, std::min(opt.samples, begin + per_thread) - begin);
+        workers.emplace_back([&, t, count]() {
+            sampleRange<N>(batch, opt, count, opt.seed * 0x100000001B3ull + t, maps[t]);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int t = 1; t < threads; t++) {
+        for (int c = 0; c < cells; c++) {
+            maps[0].count[c] += maps[t].count[c];
+            maps[0].manipulability[c] += maps[t].manipulability[c];
+        }
+    }
+    const Maps& total = maps[0];
+
+    uint32_t most = 1;
+    double best = 0.0, mean_sum = 0.0;
+    int reached = 0;
+    for (int c = 0; c < cells; c++) {
+        if (total.count[c] == 0) continue;
+        reached++;
+        most = std::max(most, total.count[c]);
+        double mean = total.manipulability[c] / total.count[c];
+        best = std::max(best, mean);
+        mean_sum += mean;
+    }
+
+    std::vector<unsigned char> reach_px(cells), manip_px(cells);
+    for (int c = 0; c < cells; c++) {
+        if (total.count[c] == 0) continue;
+        reach_px[c] = (unsigned char)(1 + 254 * std::log1p(total.count[c]) / std::log1p(most));
+        double mean = total.manipulability[c] / total.count[c];
+        manip_px[c] = (unsigned char)(1 + 254 * (best > 0 ? mean / best : 0));
+    }
+    writePgm(opt.out + "_reach.pgm", opt.grid, reach_px);
+    writePgm(opt.out + "_manip.pgm", opt.grid, manip_px);
+
+    double reach = arm.reach();
+    double cell_area = (2 * reach / opt.grid) * (2 * reach / opt.grid);
+    std::cout << N << " links, reach " << reach << "\n"
+              << "Samples: " << opt.samples << " on " << threads << " threads in "
+              << seconds << " s (" << opt.samples / seconds / 1e6 << " M configs/s)\n"
+              << "Reachable area: " << reached * cell_area << " (" << reached << " of "
+              << cells << " cells)\n"
+              << "Manipulability: mean " << (reached ? mean_sum / reached : 0.0)
+              << ", best cell " << best << "\n"
+              << "Wrote " << opt.out << "_reach.pgm and " << opt.out << "_manip.pgm\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--samples" && has_value) opt.samples = std::atoll(argv[++i]);
+        else if (arg == "--grid" && has_value) opt.grid = std::atoi(argv[++i]);
+        else if (arg == "--range" && has_value) opt.range = std::atof(argv[++i]);
+        else if (arg == "--threads" && has_value) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--out" && has_value) opt.out = argv[++i];
+        else if (arg[0] != '-') opt.lengths.push_back(std::atof(arg.c_str()));
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (opt.lengths.empty() || opt.lengths.size() > 7 || opt.grid < 2 || opt.samples < 1) {
+        std::cerr << "Usage: workspace L1 [L2 ... L7] [--samples N] [--grid cells] "
+                  << "[--range degrees] [--threads T] [--seed S] [--out prefix]\n";
+        return 1;
+    }
+
+    switch (opt.lengths.size()) {
+    case 1: return sample<1>(opt);
+    case 2: return sample<2>(opt);
+    case 3: return sample<3>(opt);
+    case 4: return sample<4>(opt);
+    case 5: return sample<5>(opt);
+    case 6: return sample<6>(opt);
+    default: return sample<7>(opt);
+    }
+}
@@ -3,14 +3,16 @@
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 #include "SemiTruck.h"
 #include "ParkingSpot.h"
+#include "ParkingPlanner.h"
 
 enum ParkingState {
-    APPROACH,
-    ALIGN,
-    BACK_IN,
-    ADJUST,
+    APPROACH,   // Driving a forward segment of the plan
+    ALIGN,      // Stopped at a cusp, about to change direction
+    BACK_IN,    // Reversing a segment of the plan
+    ADJUST,     // Creeping along the bay axis after the plan ends
     PARKED
 };
 
@@ -19,28 +21,57 @@ class Controller {
         ParkingState currentState;
         bool isEnabled;
 
-        // Target position
-        float alignTargetX, alignTargetY;
-        float alignTargetAngle;
+        // Planned path and tracking progress
+        ParkingPlanner* planner;
+        std::vector<PathPoint> path;
+        int pathIndex;      // closest path point
+        int segmentEnd;     // last point before the next cusp
+        int alignFrames;
+        int replans;
+        int adjustments;
 
         // Control parameters
         float approachSpeed;
         float alignSpeed;
         float backSpeed;
         float minSensorDistance;
+        float lookahead;
+        float reverseLookahead;
+        float hitchGain;
+        float maxTrackingError;
+        float pullOutDistance;
 
         Controller() {
             currentState = APPROACH;
             isEnabled = false;
-            approachSpeed = 100.0f;
-            alignSpeed = 80.0f;
-            backSpeed = 60.0f;
-            minSensorDistance = 30.0f;
+            planner = nullptr;
+            pathIndex = 0;
+            segmentEnd = 0;
+            alignFrames = 0;
+            replans = 0;
+            adjustments = 0;
+
+            approachSpeed = 80.0f;
+            alignSpeed = 20.0f;
+            backSpeed = 50.0f;
+            minSensorDistance = 20.0f;
+            lookahead = 30.0f;
+            reverseLookahead = 100.0f;
+            hitchGain = 0.1f;
+            maxTrackingError = 40.0f;
+            pullOutDistance = 90.0f;
+        }
+
+        void setPlanner(ParkingPlanner* p) {
+            planner = p;
         }
 
         void enable() {
             isEnabled = true;
             currentState = APPROACH;
+            path.clear();
+            replans = 0;
+            adjustments = 0;
         }
 
         void disable() {
@@ -48,196 +79,358 @@ class Controller {
         }
 
         void toggle() {
-            isEnabled = !isEnabled;
-            if (isEnabled) {
-                currentState = APPROACH;
-            }
+            if (isEnabled) disable();
+            else enable();
         }
 
-        // Calc alignment position
-        void calculateAlignmentTarget(const ParkingSpot& spot) {
-            float radians = spot.targetAngle * M_PI / 180.0f;
-
-            // Position ~150px in front of the parking spot
-            float offsetDistance = 150.0f;
-            alignTargetX = spot.x - std::cos(radians) * offsetDistance;
-            alignTargetY = spot.y - std::sin(radians) * offsetDistance;
-            alignTargetAngle = spot.targetAngle;
+        // Throw away the current plan, a new one is made on the next update
+        void replan() {
+            path.clear();
         }
 
         // Main control loop
         void update(SemiTruck& truck, const ParkingSpot& spot, float dt) {
             if (!isEnabled) return;
-            
+
             // Check if already parked
             if (spot.isParked) {
                 currentState = PARKED;
+                truck.cab_speed = 0.0f;
+                return;
+            }
+
+            if (path.empty() && !makePlan(truck, spot)) {
+                truck.cab_speed = 0.0f;
                 return;
             }
 
             switch (currentState) {
                 case APPROACH:
-                    handleApproach(truck, spot, dt);
-                    break;
-                case ALIGN:
-                    handleAlign(truck, spot, dt);
-                    break;
                 case BACK_IN:
-                    handleBackIn(truck, spot, dt);
-                    break;
                 case ADJUST:
-                    handleAdjust(truck, spot, dt);
+                    handleTracking(truck, spot, dt);
+                    break;
+                case ALIGN:
+                    handleAlign(truck);
                     break;
                 case PARKED:
+                    // Knocked out of the bay, start over
+                    currentState = ADJUST;
                     break;
             }
         }
 
+        void drawPath(sf::RenderWindow& window) {
+            if (path.size() < 2) return;
+
+            std::vector<sf::Vertex> line;
+            line.reserve(path.size());
+            for (const PathPoint& p : path) {
+                sf::Color color = (p.direction > 0) ? sf::Color::Cyan : sf::Color::Magenta;
+                line.push_back(sf::Vertex(sf::Vector2f(p.x, p.y), color));
+            }
+            window.draw(line.data(), line.size(), sf::LineStrip);
+        }
+
     private:
-        void handleApproach(SemiTruck& truck, const ParkingSpot spot, float dt) {
-            calculateAlignmentTarget(spot);
+        bool makePlan(SemiTruck& truck, const ParkingSpot& spot) {
+            if (!planner) return false;
+
+            RigPose start;
+            start.x = truck.cab_x;
+            start.y = truck.cab_y;
+            start.cab_angle = truck.cab_angle;
+            start.hitch_angle = wrapAngle(truck.cab_angle - truck.trailer_angle);
+
+            RigPose goal;
+            goal.x = spot.goalCabX();
+            goal.y = spot.goalCabY();
+            goal.cab_angle = spot.targetAngle;
+            goal.hitch_angle = 0.0f;
+
+            path = planner->plan(start, goal);
+            std::cout << "Plan: " << path.size() << " points, "
+                      << planner->expansions << " expansions, "
+                      << planner->planTimeMs << " ms" << std::endl;
+
+            if (path.empty()) {
+                std::cout << "No path to parking spot" << std::endl;
+                isEnabled = false;
+                return false;
+            }
 
-            // calculate distance to alignment position
-            float dx = alignTargetX - truck.cab_x;
-            float dy = alignTargetY - truck.cab_y;
-            float distance = std::sqrt(dx * dx + dy * dy);
+            // Ends exactly on the goal so ADJUST has something to settle on
+            path.back().x = goal.x;
+            path.back().y = goal.y;
+            path.back().cab_angle = goal.cab_angle;
+            path.back().hitch_angle = 0.0f;
 
-            float desiredAngle = std::atan2(dy, dx) * 180.0f / M_PI;
+            pathIndex = 0;
+            startSegment();
+            return true;
+        }
 
-            // Convert angles to correct range
-            while (desiredAngle < 0) desiredAngle += 360.0f;
-            while (desiredAngle >= 360.0f) desiredAngle -= 360.0f;
+        // Drive forward or back along the current segment
+        void handleTracking(SemiTruck& truck, const ParkingSpot& spot, float dt) {
+            advanceIndex(truck);
+            int direction = path[pathIndex].direction;
 
-            float angleDiff = desiredAngle - truck.cab_angle;
-            while (angleDiff > 180.0f) angleDiff -= 360.0f;
-            while (angleDiff < -180.0f) angleDiff += 360.0f;
+            // Lost the path, plan again from here
+            if (distanceSq(truck.cab_x, truck.cab_y, pathIndex) > maxTrackingError * maxTrackingError) {
+                truck.cab_speed = 0.0f;
+                retry();
+                return;
+            }
 
-            // Control logic
-            bool closeToWall = checkSensorProximity(truck);
+            float dx = path[segmentEnd].x - truck.cab_x;
+            float dy = path[segmentEnd].y - truck.cab_y;
+            float remaining = std::sqrt(dx * dx + dy * dy);
 
-            if (distance < 50.0f) {
-                // Close distance so transition to align
-                currentState = ALIGN;
-                std::cout << "State: APPROACH -> ALIGN" << std::endl;
-            } else if (closeToWall) {
-                // To close to wall, slow down and adjust
-                truck.cab_speed = approachSpeed * .3f;
-                if (angleDiff > 5.0f) {
-                    simulateKeyPress(truck, 'D', dt);
-                } else if (angleDiff < -5.0f) {
-                    simulateKeyPress(truck, 'A', dt);
-                }
-            } else {
-                // Normal approach
-                truck.cab_speed = approachSpeed;
-
-                // Steer towards target
-                if (angleDiff > 10.0f) {
-                    simulateKeyPress(truck, 'D', dt);
-                } else if (angleDiff < -10.0f) {
-                    simulateKeyPress(truck, 'A', dt);
-                }
+            // Past the end of the segment (or as close as we are going to get)
+            float along = (dx * std::cos(truck.cab_angle * M_PI / 180.0f) +
+                           dy * std::sin(truck.cab_angle * M_PI / 180.0f)) * direction;
+            bool nearEnd = pathIndex >= segmentEnd - 2;
+            if (nearEnd && (remaining < 3.0f || along < 1.0f)) {
+                finishSegment(truck, spot);
+                return;
+            }
+
+            // Slow down into cusps and the bay
+            float cruise = (currentState == ADJUST) ? alignSpeed
+                         : (direction > 0) ? approachSpeed : backSpeed;
+            float speed = std::min(cruise, 15.0f + remaining * 1.5f);
+
+            float steer = (direction > 0) ? forwardSteer(truck) : reverseSteer(truck);
+
+            // Safety check
+            if (direction < 0 && checkSensorProximity(truck)) {
+                // Stop backing up if close to wall
+                speed = 0.0f;
+            }
+
+            truck.cab_speed = speed * direction;
+            applySteering(truck, steer, dt);
+        }
+
+        void handleAlign(SemiTruck& truck) {
+            // Come to a stop before reversing direction
+            truck.cab_speed = 0.0f;
+            if (++alignFrames > 10) {
+                startSegment();
+            }
+        }
+
+        void startSegment() {
+            segmentEnd = pathIndex;
+            while (segmentEnd + 1 < (int)path.size() &&
+                   path[segmentEnd + 1].direction == path[pathIndex].direction) {
+                segmentEnd++;
+            }
+
+            if (currentState != ADJUST) {
+                currentState = (path[pathIndex].direction > 0) ? APPROACH : BACK_IN;
             }
+            std::cout << "State: " << getStateName() << std::endl;
         }
-        void handleAlign(SemiTruck& truck, const ParkingSpot spot, float dt) {
-            // Get angle error
-            float angleDiff = alignTargetAngle - truck.cab_angle;
-            while (angleDiff > 180.0f) angleDiff -= 360.0f;
-            while (angleDiff < -180.0f) angleDiff += 360.0f;
-
-            // if alignment is close, start back in
-            if (std::abs(angleDiff) < 15.0f) {
-                currentState = BACK_IN;
-                std::cout << "State: ALIGN -> BACK_IN" << std::endl;
+
+        void finishSegment(SemiTruck& truck, const ParkingSpot& spot) {
+            truck.cab_speed = 0.0f;
+
+            if (segmentEnd + 1 < (int)path.size()) {
+                // Cusp
+                pathIndex = segmentEnd + 1;
+                alignFrames = 0;
+                currentState = ALIGN;
+                std::cout << "State: ALIGN" << std::endl;
                 return;
             }
 
-            // Rotate in place (very slow speed for turning)
-            truck.cab_speed = 15.0f;
-            if (angleDiff > 0) {
-                simulateKeyPress(truck, 'D', dt);
-            } else {
-                simulateKeyPress(truck, 'A', dt);
+            if (++adjustments <= 3) {
+                startAdjust(truck, spot);
+                return;
             }
+
+            // Adjusting is not converging
+            retry();
         }
 
-        void handleBackIn(SemiTruck& truck, const ParkingSpot spot, float dt) {
-            // Calculate position error
-            float dx = spot.x - truck.cab_x;
-            float dy = spot.y - truck.cab_y;
-            float distance = std::sqrt(dx * dx + dy * dy);
-
-            float cabAngleDiff = spot.targetAngle - truck.cab_angle;
-            while (cabAngleDiff > 180.0f) cabAngleDiff -= 360.0f;
-            while (cabAngleDiff < -180.0f) cabAngleDiff += 360.0f;
-
-            float trailerAngleDiff = spot.targetAngle - truck.trailer_angle;
-            while (trailerAngleDiff > 180.0f) trailerAngleDiff -= 360.0f;
-            while (trailerAngleDiff < -180.0f) trailerAngleDiff += 360.0f;
-
-            // Jackknife check
-            float cabTrailerDiff = truck.cab_angle - truck.trailer_angle;
-            while (cabTrailerDiff > 180.0f) cabTrailerDiff -= 360.0f;
-            while (cabTrailerDiff < -180.0f) cabTrailerDiff += 360.0f;
-
-            // back in slowly
-            truck.cab_speed = -backSpeed;
-
-            // Steering correction to prevent jackknife and guide into spot
-            if (std:: abs(cabTrailerDiff) > 30.0f) {
-                // Jackknife risk! Counter-steer!
-                if (cabTrailerDiff > 0) {
-                    simulateKeyPress(truck, 'A', dt);
-                } else {
-                    simulateKeyPress(truck, 'D', dt);
-                }
-            } else if (std::abs(cabAngleDiff) > 5.0f) {
-                // Adjust angle toward the target
-                if (cabAngleDiff > 0) {
-                    simulateKeyPress(truck, 'D', dt);
-                } else {
-                    simulateKeyPress(truck, 'A', dt);
-                }
+        // Replan from the current pose, but give up eventually rather than
+        // shuffle forever
+        void retry() {
+            if (++replans > 3) {
+                std::cout << "Could not settle in the spot" << std::endl;
+                isEnabled = false;
+                return;
             }
+            currentState = APPROACH;
+            path.clear();
+        }
 
-            // Check if close enough for fine adjustment
-            if (distance < 30.0f && std::abs(cabAngleDiff) < 15.0f) {
+        // Replace the plan with a straight run along the bay axis. Close to
+        // lined up that is a creep onto the goal, otherwise pull forward out
+        // of the bay (which straightens the trailer) and back in again.
+        void startAdjust(const SemiTruck& truck, const ParkingSpot& spot) {
+            float radians = spot.targetAngle * M_PI / 180.0f;
+            float dirX = std::cos(radians);
+            float dirY = std::sin(radians);
+            float along = (spot.goalCabX() - truck.cab_x) * dirX +
+                          (spot.goalCabY() - truck.cab_y) * dirY;
+            float lateral = (spot.goalCabX() - truck.cab_x) * -dirY +
+                            (spot.goalCabY() - truck.cab_y) * dirX;
+            float cabError = wrapAngle(spot.targetAngle - truck.cab_angle);
+            float trailerError = wrapAngle(spot.targetAngle - truck.trailer_angle);
+
+            bool linedUp = std::abs(lateral) < spot.positionTolerance / 2 &&
+                           std::abs(cabError) < spot.angleTolerance / 2 &&
+                           std::abs(trailerError) < spot.angleTolerance / 2;
+
+            path.clear();
+            pathIndex = 0;
+            if (linedUp) {
                 currentState = ADJUST;
-                std::cout << "State: BACK_IN -> ADJUST" << std::endl;
+                addAxisPoints(spot, -along, 0.0f, (along >= 0) ? 1 : -1);
+            } else {
+                currentState = APPROACH;
+                addAxisPoints(spot, -along, pullOutDistance, 1);
+                addAxisPoints(spot, pullOutDistance, 0.0f, -1);
             }
+            std::cout << "Adjusting: " << (linedUp ? "creep" : "pull out") << std::endl;
+            startSegment();
+        }
 
-            // Safety check
-            if (checkSensorProximity(truck, 25.0f)) {
-                // Stop backing up if close to wall 
-                truck.cab_speed = 0;
+        // Points every ~4px along the bay axis, s measured from the goal
+        void addAxisPoints(const ParkingSpot& spot, float from, float to, int direction) {
+            float radians = spot.targetAngle * M_PI / 180.0f;
+            int steps = std::max(2, (int)(std::abs(to - from) / 4.0f) + 1);
+            for (int i = 0; i <= steps; i++) {
+                float s = from + (to - from) * (float)i / steps;
+                PathPoint p;
+                p.x = spot.goalCabX() + std::cos(radians) * s;
+                p.y = spot.goalCabY() + std::sin(radians) * s;
+                p.cab_angle = spot.targetAngle;
+                p.hitch_angle = 0.0f;
+                p.direction = direction;
+                p.steer = 0.0f;
+                path.push_back(p);
             }
         }
 
-        void handleAdjust(SemiTruck& truck, const ParkingSpot spot, float dt) {
-            // Very fine control for final positioning
-            float dx = spot.x - truck.cab_x;
-            float dy = spot.y - truck.cab_y;
-            float distance = std::sqrt(dx * dx + dy * dy);
-
-            float cabAngleDiff = spot.targetAngle - truck.cab_angle;
-            while (cabAngleDiff > 180.0f) cabAngleDiff -= 360.0f;
-            while (cabAngleDiff < -180.0f) cabAngleDiff += 360.0f;
-
-            if (distance > 10.0f) {
-                truck.cab_speed = -30.0f; // slowly move back
-            } else if (std::abs(cabAngleDiff) > 3.0f) {
-                truck.cab_speed = 10.0f; // slow move forward
-                if (cabAngleDiff > 0) {
-                    simulateKeyPress(truck, 'D', dt);
-                } else {
-                    simulateKeyPress(truck, 'A', dt);
+        // Move pathIndex to the closest point on the current segment
+        void advanceIndex(const SemiTruck& truck) {
+            float best = distanceSq(truck.cab_x, truck.cab_y, pathIndex);
+            for (int i = pathIndex + 1; i <= segmentEnd; i++) {
+                float d = distanceSq(truck.cab_x, truck.cab_y, i);
+                if (d > best + 400.0f) break;
+                if (d < best) {
+                    best = d;
+                    pathIndex = i;
                 }
-            } else {
-                // stop
-                truck.cab_speed;
             }
         }
 
+        // Pure pursuit on the cab
+        float forwardSteer(const SemiTruck& truck) {
+            float leftover;
+            int target = lookaheadIndex(pathIndex, lookahead, leftover);
+
+            // Past the end of the segment keep going along its final heading
+            float cab = path[target].cab_angle * M_PI / 180.0f;
+            float targetX = path[target].x + std::cos(cab) * leftover;
+            float targetY = path[target].y + std::sin(cab) * leftover;
+
+            float dx = targetX - truck.cab_x;
+            float dy = targetY - truck.cab_y;
+            float alpha = std::atan2(dy, dx) - truck.cab_angle * M_PI / 180.0f;
+            float distance = std::max(std::sqrt(dx * dx + dy * dy), 1.0f);
+            float curvature = 2.0f * std::sin(alpha) / distance;
+            return curvature / maxCurvature(truck);
+        }
+
+        // Reversing a trailer: pure pursuit on the trailer (which leads when
+        // backing) picks a hitch angle, then the cab steers to hold it
+        float reverseSteer(const SemiTruck& truck) {
+            float Lt = truck.hitch_distance_from_trailer_front;
+            float hitch = wrapAngle(truck.cab_angle - truck.trailer_angle) * M_PI / 180.0f;
+
+            float leftover;
+            int target = lookaheadIndex(pathIndex, reverseLookahead, leftover);
+            float targetX, targetY;
+            trailerCenter(path[target], truck, targetX, targetY);
+
+            // Past the end of the segment keep backing along the final
+            // trailer heading, so the trailer arrives straight
+            float trailer = (path[target].cab_angle - path[target].hitch_angle) * M_PI / 180.0f;
+            targetX -= std::cos(trailer) * leftover;
+            targetY -= std::sin(trailer) * leftover;
+
+            // Heading of the trailer when moving backwards
+            float backHeading = truck.trailer_angle * M_PI / 180.0f + M_PI;
+            float dx = targetX - truck.trailer_x;
+            float dy = targetY - truck.trailer_y;
+            float alpha = std::atan2(dy, dx) - backHeading;
+            float distance = std::max(std::sqrt(dx * dx + dy * dy), 1.0f);
+            float curvature = 2.0f * std::sin(alpha) / distance;
+
+            // Stay well inside the hitch angle full lock can recover from
+            float maxHitch = 0.8f * std::asin(std::min(1.0f, maxCurvature(truck) * Lt));
+            float desiredHitch = -std::asin(std::max(-1.0f, std::min(1.0f, curvature * Lt)));
+            desiredHitch = std::max(-maxHitch, std::min(maxHitch, desiredHitch));
+
+            // dhitch/ds (backing up) = sin(hitch) / Lt - steer * maxCurvature
+            float rate = std::sin(hitch) / Lt + hitchGain * (hitch - desiredHitch);
+            return rate / maxCurvature(truck);
+        }
+
+        // Walk `distance` along the segment; leftover is how far short of
+        // that the segment ends
+        int lookaheadIndex(int from, float distance, float& leftover) const {
+            int i = from;
+            float travelled = 0.0f;
+            while (i < segmentEnd && travelled < distance) {
+                float dx = path[i + 1].x - path[i].x;
+                float dy = path[i + 1].y - path[i].y;
+                travelled += std::sqrt(dx * dx + dy * dy);
+                i++;
+            }
+            leftover = std::max(0.0f, distance - travelled);
+            return i;
+        }
+
+        void trailerCenter(const PathPoint& p, const SemiTruck& truck, float& x, float& y) const {
+            float cab = p.cab_angle * M_PI / 180.0f;
+            float trailer = (p.cab_angle - p.hitch_angle) * M_PI / 180.0f;
+            float hitchX = p.x - std::cos(cab) * truck.hitch_distance_from_cab_rear;
+            float hitchY = p.y - std::sin(cab) * truck.hitch_distance_from_cab_rear;
+            x = hitchX - std::cos(trailer) * truck.hitch_distance_from_trailer_front;
+            y = hitchY - std::sin(trailer) * truck.hitch_distance_from_trailer_front;
+        }
+
+        float distanceSq(float x, float y, int i) const {
+            float dx = path[i].x - x;
+            float dy = path[i].y - y;
+            return dx * dx + dy * dy;
+        }
+
+        static float maxCurvature(const SemiTruck& truck) {
+            return (truck.turnRate * M_PI / 180.0f) / truck.maxSpeed;
+        }
+
+        static float wrapAngle(float angle) {
+            while (angle > 180.0f) angle -= 360.0f;
+            while (angle < -180.0f) angle += 360.0f;
+            return angle;
+        }
+
+        // Proportional version of pressing A/D: steer in [-1, 1] is the
+        // fraction of full lock. update() applies friction before moving, so
+        // scale by it to keep the planned curvature.
+        void applySteering(SemiTruck& truck, float steer, float dt) {
+            steer = std::max(-1.0f, std::min(1.0f, steer)) * truck.friction;
+            truck.cab_angle += truck.turnRate * dt * (truck.cab_speed / truck.maxSpeed) * steer;
+            while (truck.cab_angle < 0.0f) truck.cab_angle += 360.0f;
+            while (truck.cab_angle >= 360.0f) truck.cab_angle -= 360.0f;
+        }
+
         // Checks if any sensor is too close to an obstacle
         bool checkSensorProximity(const SemiTruck& truck, float threshold = -1.0f) {
             if (threshold < 0) threshold = minSensorDistance;
@@ -250,35 +443,6 @@ class Controller {
             return false;
         }
 
-        void simulateKeyPress(SemiTruck& truck, char key, float dt) {
-            switch (key) {
-                case 'W':
-                    truck.cab_speed += truck.acceleration * dt;
-                    break;
-                case 'S':
-                    truck.cab_speed -= truck.acceleration * dt;
-                    break;
-                case 'A':
-                    if (std::abs(truck.cab_speed) > 10.0f) {
-                        truck.cab_angle -= truck.turnRate * dt * (truck.cab_speed / truck.maxSpeed);
-                        while (truck.cab_angle < 0.0f) truck.cab_angle += 360.0f;
-                        while (truck.cab_angle >= 360.0f) truck.cab_angle -= 360.0f;
-                    }
-                    break;
-                case 'D':
-                    if (std::abs(truck.cab_speed) > 10.0f) {
-                        truck.cab_angle += truck.turnRate * dt * (truck.cab_speed / truck.maxSpeed);
-                        while (truck.cab_angle < 0.0f) truck.cab_angle += 360.0f;
-                        while (truck.cab_angle >= 360.0f) truck.cab_angle -= 360.0f;
-                    }
-                    break;
-            }
-
-            // clamp speed
-            if (truck.cab_speed > truck.maxSpeed) truck.cab_speed = truck.maxSpeed;
-            if (truck.cab_speed < -truck.maxSpeed * 0.5f) truck.cab_speed = -truck.maxSpeed * 0.5f;
-        }
-    
     public:
         // Get current state from controller
         std::string getStateName() const {
@@ -294,4 +458,4 @@ class Controller {
 };
 
 
-#endif
\ No newline at end of file
+#endif
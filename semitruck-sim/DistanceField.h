@@ -0,0 +1,198 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/*
+Static obstacles of the depot and a signed-distance field sampled from them.
+
+The field is built once when the layout changes. After that a distance
+query is a couple of array reads no matter how many obstacles there are,
+which is what collision handling, the sensors and the parking planner all
+need. Negative distances are inside an obstacle.
+
+No SFML in here so the planner can use it headless.
+*/
+
+enum ObstacleType {
+    WALL,
+    BARRIER,
+    PARKED_TRAILER,
+    LOADING_DOCK
+};
+
+// Oriented rectangle
+struct Obstacle {
+    float x, y;
+    float halfLength, halfWidth;
+    float angle; // degrees
+    ObstacleType type;
+
+    Obstacle(float px, float py, float length, float width, float a = 0.0f,
+             ObstacleType t = BARRIER) {
+        x = px;
+        y = py;
+        halfLength = length / 2;
+        halfWidth = width / 2;
+        angle = a;
+        type = t;
+    }
+
+    // Signed distance from a point to the rectangle
+    float distanceTo(float px, float py) const {
+        float radians = angle * M_PI / 180.0f;
+        float c = std::cos(radians);
+        float s = std::sin(radians);
+        float dx = px - x;
+        float dy = py - y;
+        float qx = std::abs(c * dx + s * dy) - halfLength;
+        float qy = std::abs(-s * dx + c * dy) - halfWidth;
+        float ox = std::max(qx, 0.0f);
+        float oy = std::max(qy, 0.0f);
+        return std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f);
+    }
+
+    // Half extents of the axis-aligned bounding box
+    void halfExtents(float& ex, float& ey) const {
+        float radians = angle * M_PI / 180.0f;
+        float c = std::abs(std::cos(radians));
+        float s = std::abs(std::sin(radians));
+        ex = c * halfLength + s * halfWidth;
+        ey = s * halfLength + c * halfWidth;
+    }
+};
+
+class DistanceField {
+public:
+    float width, height;
+    float cellSize;
+    float maxDistance;  // values are clamped here, far away is far away
+    int cols, rows;
+    std::vector<float> values;  // samples at (c * cellSize, r * cellSize)
+
+    DistanceField() {
+        width = 0.0f;
+        height = 0.0f;
+        cellSize = 4.0f;
+        maxDistance = 200.0f;
+        cols = 0;
+        rows = 0;
+        halfDiagonal = 0.0f;
+    }
+
+    bool empty() const {
+        return values.empty();
+    }
+
+    // Each obstacle only touches the samples within maxDistance of it, so
+    // building is proportional to the area the obstacles cover rather than
+    // yard area times obstacle count
+    void build(float w, float h, const std::vector<Obstacle>& obstacles,
+               float cell = 4.0f, float range = 200.0f) {
+        width = w;
+        height = h;
+        cellSize = cell;
+        maxDistance = range;
+        halfDiagonal = cellSize * 0.7072f;
+        cols = (int)std::ceil(width / cellSize) + 1;
+        rows = (int)std::ceil(height / cellSize) + 1;
+        values.assign(cols * rows, maxDistance);
+
+        for (const Obstacle& o : obstacles) {
+            float ex, ey;
+            o.halfExtents(ex, ey);
+            ex += maxDistance;
+            ey += maxDistance;
+            int c0 = std::max(0, (int)std::floor((o.x - ex) / cellSize));
+            int c1 = std::min(cols - 1, (int)std::ceil((o.x + ex) / cellSize));
+            int r0 = std::max(0, (int)std::floor((o.y - ey) / cellSize));
+            int r1 = std::min(rows - 1, (int)std::ceil((o.y + ey) / cellSize));
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    float& v = values[r * cols + c];
+                    v = std::min(v, o.distanceTo(c * cellSize, r * cellSize));
+                }
+            }
+        }
+    }
+
+    // Bilinear distance. Outside the field counts as solid.
+    float distance(float x, float y) const {
+        if (values.empty()) return maxDistance;
+
+        float outside = outsideDistance(x, y);
+        if (outside > 0.0f) return -outside;
+
+        float fx = x / cellSize;
+        float fy = y / cellSize;
+        int c = std::min((int)fx, cols - 2);
+        int r = std::min((int)fy, rows - 2);
+        float tx = fx - c;
+        float ty = fy - r;
+
+        const float* row0 = &values[r * cols + c];
+        const float* row1 = row0 + cols;
+        float top = row0[0] + (row0[1] - row0[0]) * tx;
+        float bottom = row1[0] + (row1[1] - row1[0]) * tx;
+        return top + (bottom - top) * ty;
+    }
+
+    // Nearest sample less half a cell diagonal: never more than the true
+    // distance, and cheaper than distance() for footprint checks
+    float lowerBound(float x, float y) const {
+        if (x < 0.0f || y < 0.0f) return -1.0f;
+        int c = (int)(x / cellSize + 0.5f);
+        int r = (int)(y / cellSize + 0.5f);
+        if (c >= cols || r >= rows) return -1.0f;
+        return values[r * cols + c] - halfDiagonal;
+    }
+
+    // Direction of increasing distance (away from the nearest obstacle)
+    void gradient(float x, float y, float& gx, float& gy) const {
+        float h = cellSize;
+        gx = distance(x + h, y) - distance(x - h, y);
+        gy = distance(x, y + h) - distance(x, y - h);
+        float length = std::sqrt(gx * gx + gy * gy);
+        if (length > 1e-6f) {
+            gx /= length;
+            gy /= length;
+        } else {
+            gx = 0.0f;
+            gy = 0.0f;
+        }
+    }
+
+    // Sphere tracing: the distance at a point is a step that can't pass
+    // through anything. Returns how far the ray gets, up to range.
+    //
+    // There is no step limit: a ray running along a wall takes steps as
+    // small as its clearance, and stopping early would report a short
+    // or max-range reading instead of the real hit. Every step is at
+    // least the hit threshold, so a ray takes at most range / kHitDistance
+    // steps (400 for a 200 px sensor).
+    float raymarch(float x, float y, float radians, float range) const {
+        const float kHitDistance = 0.5f;
+        float dirX = std::cos(radians);
+        float dirY = std::sin(radians);
+        float travelled = 0.0f;
+        while (travelled < range) {
+            float d = distance(x + dirX * travelled, y + dirY * travelled);
+            if (d < kHitDistance) return travelled;
+            travelled += d;
+        }
+        return range;
+    }
+
+private:
+    float halfDiagonal;
+
+    float outsideDistance(float x, float y) const {
+        float ox = std::max(std::max(-x, x - (cols - 1) * cellSize), 0.0f);
+        float oy = std::max(std::max(-y, y - (rows - 1) * cellSize), 0.0f);
+        return std::sqrt(ox * ox + oy * oy);
+    }
+};
+
+#endif // DISTANCE_FIELD_H
@@ -5,6 +5,7 @@
 #include "Car.h"
 #include "SemiTruck.h"
 #include "Lane.h"
+#include "DistanceField.h"
 
 class Environment {
     public:
@@ -13,6 +14,12 @@ class Environment {
         sf::Color wallColor;
         sf::Color groundColor;
         Road* road;  // Pointer to road with lanes
+
+        // Obstacle layer: walls plus whatever the depot adds, with a
+        // signed-distance field for collision and sensor queries
+        std::vector<Obstacle> obstacles;
+        DistanceField field;
+        bool fieldDirty;
     
     Environment(float w, float h) {
         width = w;
@@ -21,6 +28,15 @@ class Environment {
         wallColor = sf::Color(60, 60, 60);
         groundColor = sf::Color(34, 139, 34);  // Grass green for sides
         road = nullptr;
+
+        // Barriers on the edges. They carry on past the window so the
+        // distance field inside them points back into the yard.
+        float depth = wallThickness + 100.0f;
+        float outer = wallThickness - depth / 2;
+        addObstacle(Obstacle(width / 2, outer, width + 2 * depth, depth, 0.0f, WALL));
+        addObstacle(Obstacle(width / 2, height - outer, width + 2 * depth, depth, 0.0f, WALL));
+        addObstacle(Obstacle(outer, height / 2, depth, height + 2 * depth, 0.0f, WALL));
+        addObstacle(Obstacle(width - outer, height / 2, depth, height + 2 * depth, 0.0f, WALL));
     }
     
     ~Environment() {
@@ -31,6 +47,20 @@ class Environment {
         road = r;
     }
 
+    void addObstacle(const Obstacle& obstacle) {
+        obstacles.push_back(obstacle);
+        fieldDirty = true;
+    }
+
+    // Distance field for the current layout, rebuilt after obstacles change
+    const DistanceField& getField() {
+        if (fieldDirty) {
+            field.build(width, height, obstacles);
+            fieldDirty = false;
+        }
+        return field;
+    }
+
     void draw(sf::RenderWindow& window) {
         // Draw ground (grass everywhere as base)
         sf::RectangleShape ground(sf::Vector2f(width, height));
@@ -42,32 +72,25 @@ class Environment {
             road->draw(window);
         }
 
-        // Draw walls (barriers on edges) - make them look like barriers/fences
-        sf::Color barrierColor = sf::Color(180, 50, 50); // Red barriers
-        
-        // Top wall
-        sf::RectangleShape topWall(sf::Vector2f(width, wallThickness));
-        topWall.setFillColor(barrierColor);
-        topWall.setPosition(0, 0);
-        window.draw(topWall);
-
-        // Bottom Wall
-        sf::RectangleShape bottomWall(sf::Vector2f(width, wallThickness));
-        bottomWall.setFillColor(barrierColor);
-        bottomWall.setPosition(0, height - wallThickness);
-        window.draw(bottomWall);
-        
-        // Left wall
-        sf::RectangleShape leftWall(sf::Vector2f(wallThickness, height));
-        leftWall.setFillColor(barrierColor);
-        leftWall.setPosition(0, 0);
-        window.draw(leftWall);
-        
-        // Right wall
-        sf::RectangleShape rightWall(sf::Vector2f(wallThickness, height));
-        rightWall.setFillColor(barrierColor);
-        rightWall.setPosition(width - wallThickness, 0);
-        window.draw(rightWall);
+        // Draw obstacles (walls look like red barriers)
+        for (const Obstacle& o : obstacles) {
+            sf::RectangleShape shape(sf::Vector2f(o.halfLength * 2, o.halfWidth * 2));
+            shape.setOrigin(o.halfLength, o.halfWidth);
+            shape.setPosition(o.x, o.y);
+            shape.setRotation(o.angle);
+            shape.setFillColor(obstacleColor(o.type));
+            window.draw(shape);
+        }
+    }
+
+    static sf::Color obstacleColor(ObstacleType type) {
+        switch (type) {
+            case WALL: return sf::Color(180, 50, 50);
+            case BARRIER: return sf::Color(230, 140, 30);
+            case PARKED_TRAILER: return sf::Color(120, 120, 120);
+            case LOADING_DOCK: return sf::Color(70, 70, 90);
+            default: return sf::Color::White;
+        }
     }
 
     void handleCarCollision(Car & car) {
@@ -111,11 +134,7 @@ class Environment {
     }
     
     void handleSemiCollision(SemiTruck & semiTruck) {
-        bool collisionOccurred = false;
-
-        // Calculate true corners of rotated cab and trailer
-        float cab_radians = semiTruck.cab_angle * M_PI / 180.0f;
-        float trailer_radians = semiTruck.trailer_angle *  M_PI / 180.0f;
+        const DistanceField& sdf = getField();
 
         // Cab dimensions
         float cab_half_length = semiTruck.cab_length / 2.0f;
@@ -125,103 +144,63 @@ class Environment {
         float trailer_half_length = semiTruck.trailer_length / 2.0f;
         float trailer_half_width = 12.5f;
 
-        // Calculate cab corners (4 corners of a rectangle)
-        float cab_corners_x[4], cab_corners_y[4];
-        float cos_cab = std::cos(cab_radians);
-        float sin_cab = std::sin(cab_radians);
-
-        // APPLY ROTATION MATRIX
-        // Front right corner
-        cab_corners_x[0] = semiTruck.cab_x + cos_cab * cab_half_length - sin_cab * cab_half_width;
-        cab_corners_y[0] = semiTruck.cab_y + sin_cab * cab_half_length + cos_cab * cab_half_width;
-        
-        // Front left corner
-        cab_corners_x[1] = semiTruck.cab_x + cos_cab * cab_half_length + sin_cab * cab_half_width;
-        cab_corners_y[1] = semiTruck.cab_y + sin_cab * cab_half_length - cos_cab * cab_half_width;
-        
-        // Back left corner
-        cab_corners_x[2] = semiTruck.cab_x - cos_cab * cab_half_length + sin_cab * cab_half_width;
-        cab_corners_y[2] = semiTruck.cab_y - sin_cab * cab_half_length - cos_cab * cab_half_width;
-        
-        // Back right corner
-        cab_corners_x[3] = semiTruck.cab_x - cos_cab * cab_half_length - sin_cab * cab_half_width;
-        cab_corners_y[3] = semiTruck.cab_y - sin_cab * cab_half_length + cos_cab * cab_half_width;
-    
-        // Calculate trailer corners
-        float trailer_corners_x[4], trailer_corners_y[4];
-        float cos_trailer = std::cos(trailer_radians);
-        float sin_trailer = std::sin(trailer_radians);
-
-        // Apply rotation matrix
-        trailer_corners_x[0] = semiTruck.trailer_x + cos_trailer * trailer_half_length - sin_trailer * trailer_half_width;
-        trailer_corners_y[0] = semiTruck.trailer_y + sin_trailer * trailer_half_length + cos_trailer * trailer_half_width;
-        trailer_corners_x[1] = semiTruck.trailer_x + cos_trailer * trailer_half_length + sin_trailer * trailer_half_width;
-        trailer_corners_y[1] = semiTruck.trailer_y + sin_trailer * trailer_half_length - cos_trailer * trailer_half_width;
-        trailer_corners_x[2] = semiTruck.trailer_x - cos_trailer * trailer_half_length + sin_trailer * trailer_half_width;
-        trailer_corners_y[2] = semiTruck.trailer_y - sin_trailer * trailer_half_length - cos_trailer * trailer_half_width;
-        trailer_corners_x[3] = semiTruck.trailer_x - cos_trailer * trailer_half_length - sin_trailer * trailer_half_width;
-        trailer_corners_y[3] = semiTruck.trailer_y - sin_trailer * trailer_half_length + cos_trailer * trailer_half_width;
-        
-
-        // Check cab corners against walls
-        for (int i = 0; i < 4; i++) {
-            // Left wall
-            if (cab_corners_x[i] < wallThickness) {
-                semiTruck.cab_x += (wallThickness - cab_corners_x[i]);
-                semiTruck.cab_speed *= -.5f;
-                collisionOccurred = true;
-            } 
-            // Right wall
-            if (cab_corners_x[i] > width - wallThickness) {
-                semiTruck.cab_x -= (cab_corners_x[i] - (width - wallThickness));
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-            // Top wall
-            if (cab_corners_y[i] < wallThickness) {
-                semiTruck.cab_y += (wallThickness - cab_corners_y[i]);
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-            // Bottom wall
-            if (cab_corners_y[i] > height - wallThickness) {
-                semiTruck.cab_y -= (cab_corners_y[i] - (height - wallThickness));
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-        }
-
-        // Check all trailer corners against walls
-        for (int i = 0; i < 4; i++) {
-            // Left wall
-            if (trailer_corners_x[i] < wallThickness) {
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-            // Right wall
-            if (trailer_corners_x[i] > width - wallThickness) {
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-            // Top wall
-            if (trailer_corners_y[i] < wallThickness) {
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
-            // Bottom wall
-            if (trailer_corners_y[i] > height - wallThickness) {
-                semiTruck.cab_speed *= -0.5f;
-                collisionOccurred = true;
-            }
+        // Deepest point of the cab inside an obstacle
+        float cabPenetration = 0.0f;
+        float cabPushX = 0.0f, cabPushY = 0.0f;
+        deepestPoint(sdf, semiTruck.cab_x, semiTruck.cab_y, semiTruck.cab_angle,
+                     cab_half_length, cab_half_width, cabPenetration, cabPushX, cabPushY);
+
+        // Trailer only bounces, the cab is what gets pushed out
+        float trailerPenetration = 0.0f;
+        float trailerPushX = 0.0f, trailerPushY = 0.0f;
+        deepestPoint(sdf, semiTruck.trailer_x, semiTruck.trailer_y, semiTruck.trailer_angle,
+                     trailer_half_length, trailer_half_width, trailerPenetration, trailerPushX, trailerPushY);
+
+        if (cabPenetration > 0.0f) {
+            semiTruck.cab_x += cabPushX * cabPenetration;
+            semiTruck.cab_y += cabPushY * cabPenetration;
         }
 
         // Pass collision to semiTruck object
-        if (collisionOccurred) {
+        if (cabPenetration > 0.0f || trailerPenetration > 0.0f) {
+            semiTruck.cab_speed *= -0.5f;
             semiTruck.onCollision();
         }
-
     }
 
+    private:
+        // Samples the outline of a rotated rectangle against the distance
+        // field, a few px apart so thin obstacles can't slip between corners.
+        // Cost depends on the truck, not on how many obstacles there are.
+        static void deepestPoint(const DistanceField& sdf, float cx, float cy, float angle,
+                                 float halfLength, float halfWidth,
+                                 float& penetration, float& pushX, float& pushY) {
+            const float spacing = 10.0f;
+            float radians = angle * M_PI / 180.0f;
+            float c = std::cos(radians);
+            float s = std::sin(radians);
+
+            int alongLength = (int)std::ceil(2 * halfLength / spacing);
+            int alongWidth = (int)std::ceil(2 * halfWidth / spacing);
+            for (int i = 0; i <= alongLength; i++) {
+                for (int j = 0; j <= alongWidth; j++) {
+                    // Outline only
+                    if (i != 0 && i != alongLength && j != 0 && j != alongWidth) continue;
+
+                    float u = -halfLength + 2 * halfLength * i / alongLength;
+                    float v = -halfWidth + 2 * halfWidth * j / alongWidth;
+                    float px = cx + c * u - s * v;
+                    float py = cy + s * u + c * v;
+
+                    float d = sdf.distance(px, py);
+                    if (-d > penetration) {
+                        penetration = -d;
+                        sdf.gradient(px, py, pushX, pushY);
+                    }
+                }
+            }
+        }
+
 };
 
 #endif
\ No newline at end of file
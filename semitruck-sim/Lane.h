@@ -5,6 +5,7 @@
 #include <cmath>
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include "SemiTruck.h"
 
 // Represents a point on the road centerline
@@ -18,6 +19,8 @@ struct RoadPoint {
 class Lane {
 public:
     std::vector<RoadPoint> centerline;  // Points defining the lane center
+    std::vector<float> arcLengths;       // Distance along the lane to each point
+    float totalLength;                   // Once round the loop
     float width;                         // Lane width in pixels
     int laneNumber;                      // Which lane (0=inner, 1=middle, 2=outer)
     
@@ -27,6 +30,7 @@ public:
     Lane(float laneWidth, int laneNum) {
         this->width = laneWidth;
         this->laneNumber = laneNum;
+        totalLength = 0.0f;
         
         laneColor = sf::Color(80, 80, 80);      // Dark gray road
         lineColor = sf::Color(255, 255, 255);   // White lane markings
@@ -55,6 +59,56 @@ public:
             
             centerline.emplace_back(baseX + offsetX, baseY + offsetY, angle);
         }
+
+        computeArcLengths();
+    }
+
+    void computeArcLengths() {
+        arcLengths.resize(centerline.size());
+        totalLength = 0.0f;
+        for (size_t i = 0; i < centerline.size(); i++) {
+            arcLengths[i] = totalLength;
+            const RoadPoint& p1 = centerline[i];
+            const RoadPoint& p2 = centerline[(i + 1) % centerline.size()];
+            totalLength += std::sqrt((p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y));
+        }
+    }
+
+    // Position and direction a distance s along the lane (wraps round)
+    void pointAt(float s, float& x, float& y, float& angle) const {
+        s = std::fmod(s, totalLength);
+        if (s < 0.0f) s += totalLength;
+
+        // Last point at or before s
+        int i = (int)(std::upper_bound(arcLengths.begin(), arcLengths.end(), s) - arcLengths.begin()) - 1;
+        int next = (i + 1) % centerline.size();
+        float segment = ((size_t)next == 0 ? totalLength : arcLengths[next]) - arcLengths[i];
+        float t = (s - arcLengths[i]) / segment;
+
+        const RoadPoint& p1 = centerline[i];
+        const RoadPoint& p2 = centerline[next];
+        x = p1.x + (p2.x - p1.x) * t;
+        y = p1.y + (p2.y - p1.y) * t;
+
+        float turn = p2.angle - p1.angle;
+        while (turn > 180.0f) turn -= 360.0f;
+        while (turn < -180.0f) turn += 360.0f;
+        angle = p1.angle + turn * t;
+    }
+
+    // Distance along the lane of the point closest to the truck
+    float getArcLength(const SemiTruck& truck) const {
+        if (centerline.empty()) return 0.0f;
+
+        int closestIdx = findClosestPointIndex(truck);
+        const RoadPoint& closest = centerline[closestIdx];
+        float radians = closest.angle * M_PI / 180.0f;
+        float along = (truck.cab_x - closest.x) * std::cos(radians) +
+                      (truck.cab_y - closest.y) * std::sin(radians);
+
+        float s = std::fmod(arcLengths[closestIdx] + along, totalLength);
+        if (s < 0.0f) s += totalLength;
+        return s;
     }
     
     // Find the closest point on the centerline to the truck
@@ -0,0 +1,844 @@
+#ifndef PARKING_PLANNER_H
+#define PARKING_PLANNER_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <queue>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include "DistanceField.h"
+
+/*
+Hybrid A* parking planner for the cab + trailer rig.
+
+Search state is (x, y, cab angle, hitch angle). Successors come from a
+motion-primitive lattice that is integrated once with the same kinematics
+as SemiTruck::updateCab/updateTrailer and cached in a binary file together
+with an obstacle-free non-holonomic heuristic table.
+
+No SFML in here so the planner can run headless.
+*/
+
+// Rig dimensions, defaults match the SemiTruck constructor
+struct RigGeometry {
+    float cab_length, cab_width;
+    float trailer_length, trailer_width;
+    float hitch_distance_from_cab_rear;      // cab centre -> hitch
+    float hitch_distance_from_trailer_front; // hitch -> trailer centre
+    float maxSpeed;
+    float turnRate;                          // deg/s at max speed, full lock
+
+    RigGeometry() {
+        cab_length = 40.0f;
+        cab_width = 30.0f;
+        trailer_length = 80.0f;
+        trailer_width = 25.0f;
+        hitch_distance_from_cab_rear = cab_length / 2;
+        hitch_distance_from_trailer_front = trailer_length / 2;
+        maxSpeed = 200.0f;
+        turnRate = 120.0f;
+    }
+
+    // Steering in SemiTruck turns the cab by turnRate * (speed / maxSpeed),
+    // so full lock is a fixed curvature regardless of speed
+    float maxCurvature() const {
+        return (turnRate * M_PI / 180.0f) / maxSpeed;
+    }
+
+    // Footprint is covered by discs: 2 over the cab, 3 over the trailer
+    float cabRadius() const {
+        float q = cab_length / 4;
+        float w = cab_width / 2;
+        return std::sqrt(q * q + w * w);
+    }
+
+    float trailerRadius() const {
+        float q = trailer_length / 6;
+        float w = trailer_width / 2;
+        return std::sqrt(q * q + w * w);
+    }
+
+    // Disc centres for a cab pose (angles in radians). First two are the cab.
+    void discCenters(float x, float y, float cab, float hitch, float* cx, float* cy) const {
+        float c = std::cos(cab);
+        float s = std::sin(cab);
+        float q = cab_length / 4;
+        cx[0] = x + c * q;  cy[0] = y + s * q;
+        cx[1] = x - c * q;  cy[1] = y - s * q;
+
+        float hitchX = x - c * hitch_distance_from_cab_rear;
+        float hitchY = y - s * hitch_distance_from_cab_rear;
+        float trailer = cab - hitch;
+        float tc = std::cos(trailer);
+        float ts = std::sin(trailer);
+        float tx = hitchX - tc * hitch_distance_from_trailer_front;
+        float ty = hitchY - ts * hitch_distance_from_trailer_front;
+        float tq = trailer_length / 3;
+        for (int i = 0; i < 3; i++) {
+            cx[2 + i] = tx + tc * tq * (1 - i);
+            cy[2 + i] = ty + ts * tq * (1 - i);
+        }
+    }
+};
+
+// Planner pose: cab centre, cab heading and hitch angle (cab - trailer), degrees
+struct RigPose {
+    float x, y;
+    float cab_angle;
+    float hitch_angle;
+};
+
+// One sample of a planned path
+struct PathPoint {
+    float x, y;
+    float cab_angle;   // degrees
+    float hitch_angle; // degrees
+    int direction;     // +1 forward, -1 reverse
+    float steer;       // -1 full left .. +1 full right
+};
+
+class MotionPrimitiveLattice {
+public:
+    static const int kHeadingBins = 72;  // 5 degrees
+    static const int kHitchBins = 9;     // 5 degrees, centred on 0
+    static const int kSteerLevels = 5;
+    static const int kActions = 2 * kSteerLevels;
+    static const int kSamples = 4;
+    static const int kDiscs = 5;  // 2 over the cab, 3 over the trailer
+
+    struct Primitive {
+        // Offsets from the start pose, world frame (angles in radians)
+        float dx[kSamples], dy[kSamples];
+        float cab[kSamples], hitch[kSamples];
+        // Footprint disc centres at each sample, relative to the start pose
+        float discX[kSamples][kDiscs], discY[kSamples][kDiscs];
+        float length;
+        float steer;
+        int8_t direction;
+        int8_t valid;          // false if the hitch goes past hitchLimit
+        int16_t endHeading;
+        int16_t endHitch;
+    };
+
+    float hitchBinWidth;  // radians
+    float hitchLimit;     // radians
+    std::vector<Primitive> primitives;
+
+    MotionPrimitiveLattice() {
+        hitchBinWidth = 5.0f * M_PI / 180.0f;
+        hitchLimit = 20.0f * M_PI / 180.0f;
+    }
+
+    static float headingBinWidth() {
+        return 2.0f * M_PI / kHeadingBins;
+    }
+
+    static float steerFor(int steerIdx) {
+        static const float levels[kSteerLevels] = {-1.0f, -0.5f, 0.0f, 0.5f, 1.0f};
+        return levels[steerIdx];
+    }
+
+    static int actionIndex(int direction, int steerIdx) {
+        return (direction > 0 ? 0 : kSteerLevels) + steerIdx;
+    }
+
+    float hitchCenter(int k) const {
+        return (k - kHitchBins / 2) * hitchBinWidth;
+    }
+
+    int hitchBin(float hitch) const {
+        int k = (int)std::lround(hitch / hitchBinWidth) + kHitchBins / 2;
+        return std::min(std::max(k, 0), kHitchBins - 1);
+    }
+
+    static int headingBin(float radians) {
+        int h = (int)std::lround(radians / headingBinWidth()) % kHeadingBins;
+        return h < 0 ? h + kHeadingBins : h;
+    }
+
+    const Primitive& get(int heading, int hitch, int action) const {
+        return primitives[(heading * kHitchBins + hitch) * kActions + action];
+    }
+
+    void build(const RigGeometry& rig) {
+        primitives.assign(kHeadingBins * kHitchBins * kActions, Primitive());
+
+        // Every arc turns the cab by whole heading bins so end poses land
+        // back on the lattice: 3 at full lock, 2 at half lock. Those two
+        // have no common factor, so every heading can reach every other.
+        float maxCurv = rig.maxCurvature();
+        float baseLength = 3.0f * headingBinWidth() / maxCurv;
+        float ds = 0.25f;
+        float Lt = rig.hitch_distance_from_trailer_front;
+
+        // Backing up, full lock can only hold the hitch while
+        // sin(hitch) < maxCurvature * Lt. Keep a margin so the controller
+        // can still correct, anything past that is a jackknife.
+        hitchLimit = 0.8f * std::asin(std::min(1.0f, maxCurv * Lt));
+
+        for (int h = 0; h < kHeadingBins; h++) {
+            for (int k = 0; k < kHitchBins; k++) {
+                for (int a = 0; a < kActions; a++) {
+                    Primitive& p = primitives[(h * kHitchBins + k) * kActions + a];
+                    int direction = (a < kSteerLevels) ? 1 : -1;
+                    float steer = steerFor(a % kSteerLevels);
+                    p.direction = direction;
+                    p.steer = steer;
+                    p.length = (std::abs(steer) == 0.5f) ? baseLength * 4.0f / 3.0f : baseLength;
+                    p.valid = 1;
+
+                    float x = 0.0f, y = 0.0f;
+                    float cab = h * headingBinWidth();
+                    float trailer = cab - hitchCenter(k);
+                    int steps = (int)std::lround(p.length / ds);
+                    int sample = 0;
+
+                    for (int i = 1; i <= steps; i++) {
+                        // Same ordering as SemiTruck::update: steer, move cab, drag trailer
+                        cab += direction * ds * steer * maxCurv;
+                        x += direction * ds * std::cos(cab);
+                        y += direction * ds * std::sin(cab);
+                        trailer += direction * ds / Lt * std::sin(cab - trailer);
+
+                        float hitch = std::remainder(cab - trailer, 2.0f * (float)M_PI);
+                        if (std::abs(hitch) > hitchLimit) p.valid = 0;
+
+                        if (i * kSamples >= (sample + 1) * steps) {
+                            p.dx[sample] = x;
+                            p.dy[sample] = y;
+                            p.cab[sample] = cab;
+                            p.hitch[sample] = hitch;
+                            rig.discCenters(x, y, cab, hitch, p.discX[sample], p.discY[sample]);
+                            sample++;
+                        }
+                    }
+
+                    p.endHeading = headingBin(p.cab[kSamples - 1]);
+                    p.endHitch = hitchBin(p.hitch[kSamples - 1]);
+                }
+            }
+        }
+    }
+};
+
+// Obstacle-free cost-to-go tabulated in the goal frame, in whole pixels.
+// With hitchBins == kHitchBins the table covers the full (x, y, cab angle,
+// hitch angle) state; with hitchBins == 1 it only tracks the cab, which is
+// cheap enough to cover a much larger window.
+class NonholonomicHeuristic {
+public:
+    float cellSize;
+    int halfCells;
+    int hitchBins;
+    std::vector<uint16_t> table;
+
+    static const uint16_t kUnreached = 0xffff;
+
+    NonholonomicHeuristic(float cell, int half, int hitch) {
+        cellSize = cell;
+        halfCells = half;
+        hitchBins = hitch;
+    }
+
+    int side() const {
+        return 2 * halfCells + 1;
+    }
+
+    size_t size() const {
+        return (size_t)side() * side() * MotionPrimitiveLattice::kHeadingBins * hitchBins;
+    }
+
+    int index(int ix, int iy, int h, int k) const {
+        return ((iy * side() + ix) * MotionPrimitiveLattice::kHeadingBins + h) * hitchBins + k;
+    }
+
+    // Dijkstra outwards from the goal pose (origin, heading bin 0, straight
+    // hitch). The rig kinematics are reversible, so the state reached by a
+    // primitive from here can drive back to here with the same steering in
+    // the opposite direction; that reversed move is what gets costed.
+    void build(const MotionPrimitiveLattice& lattice, float reverseFactor) {
+        const int H = MotionPrimitiveLattice::kHeadingBins;
+        const int K = hitchBins;
+        const int centerHitch = MotionPrimitiveLattice::kHitchBins / 2;
+        const bool cabOnly = (hitchBins == 1);
+        const int last = MotionPrimitiveLattice::kSamples - 1;
+        std::vector<float> cost(size(), std::numeric_limits<float>::infinity());
+
+        typedef std::pair<float, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        int goal = index(halfCells, halfCells, 0, cabOnly ? 0 : centerHitch);
+        cost[goal] = 0.0f;
+        open.push(Entry(0.0f, goal));
+
+        while (!open.empty()) {
+            Entry top = open.top();
+            open.pop();
+            int idx = top.second;
+            if (top.first > cost[idx]) continue;
+
+            int k = idx % K;
+            int h = (idx / K) % H;
+            int cell = idx / (K * H);
+            float x = (cell % side() - halfCells) * cellSize;
+            float y = (cell / side() - halfCells) * cellSize;
+
+            for (int a = 0; a < MotionPrimitiveLattice::kActions; a++) {
+                // Cab motion does not depend on the hitch, so the cab-only
+                // table can use the straight-hitch primitives throughout
+                const MotionPrimitiveLattice::Primitive& p = lattice.get(h, cabOnly ? centerHitch : k, a);
+                if (!p.valid && !cabOnly) continue;
+
+                int nx = (int)std::lround((x + p.dx[last]) / cellSize) + halfCells;
+                int ny = (int)std::lround((y + p.dy[last]) / cellSize) + halfCells;
+                if (nx < 0 || ny < 0 || nx >= side() || ny >= side()) continue;
+
+                int nidx = index(nx, ny, p.endHeading, cabOnly ? 0 : p.endHitch);
+                float g = top.first + p.length * (p.direction > 0 ? reverseFactor : 1.0f);
+                if (g < cost[nidx]) {
+                    cost[nidx] = g;
+                    open.push(Entry(g, nidx));
+                }
+            }
+        }
+
+        table.resize(cost.size());
+        for (size_t i = 0; i < cost.size(); i++) {
+            table[i] = std::isinf(cost[i]) ? kUnreached
+                                           : (uint16_t)std::min(cost[i], 65534.0f);
+        }
+    }
+
+    // Returns a negative value when the query is outside the table
+    float lookup(float dx, float dy, int relHeading, int hitch) const {
+        int ix = (int)std::lround(dx / cellSize) + halfCells;
+        int iy = (int)std::lround(dy / cellSize) + halfCells;
+        if (ix < 0 || iy < 0 || ix >= side() || iy >= side()) return -1.0f;
+        uint16_t v = table[index(ix, iy, relHeading, hitchBins == 1 ? 0 : hitch)];
+        return v == kUnreached ? -1.0f : (float)v;
+    }
+};
+
+class ParkingPlanner {
+public:
+    RigGeometry rig;
+    MotionPrimitiveLattice lattice;
+    NonholonomicHeuristic nearHeuristic;  // trailer-aware, the whole yard
+    NonholonomicHeuristic farHeuristic;   // cab only, where the hitch table has no entry
+
+    // Yard bounds and obstacles
+    float yardWidth, yardHeight;
+    std::vector<Obstacle> obstacles;
+
+    // Search parameters
+    float cellSize;
+    float reverseFactor;
+    float switchPenalty;
+    float steerPenalty;
+    float heuristicWeight;
+    float goalTolerance;
+    float safetyMargin;
+    float clearanceCellSize;
+    int maxExpansions;
+    int shotInterval;
+
+    // Stats from the last plan
+    int expansions;
+    float planTimeMs;
+
+    ParkingPlanner(float width, float height)
+        : nearHeuristic(20.0f, 40, MotionPrimitiveLattice::kHitchBins),
+          farHeuristic(20.0f, 40, 1) {
+        yardWidth = width;
+        yardHeight = height;
+
+        cellSize = 15.0f;
+        reverseFactor = 1.5f;
+        switchPenalty = 60.0f;
+        steerPenalty = 1.05f;
+        heuristicWeight = 2.0f;
+        goalTolerance = 15.0f;
+        safetyMargin = 3.0f;
+        clearanceCellSize = 4.0f;
+        maxExpansions = 200000;
+        shotInterval = 10;
+
+        expansions = 0;
+        planTimeMs = 0.0f;
+        clearanceDirty = true;
+    }
+
+    void addObstacle(const Obstacle& obstacle) {
+        obstacles.push_back(obstacle);
+        clearanceDirty = true;
+    }
+
+    // Load the lattice and heuristic table from the cache file, rebuilding
+    // (and rewriting the file) if it is missing or was built for another rig.
+    // Also samples the clearance grid so the first plan doesn't pay for it.
+    bool loadOrBuild(const std::string& path) {
+        if (clearanceDirty) buildClearanceGrid();
+        if (load(path)) return true;
+
+        buildTables();
+        save(path);
+        return false;
+    }
+
+    // Plan from the current pose to the goal pose. Returns an empty path if
+    // no plan was found.
+    std::vector<PathPoint> plan(const RigPose& start, const RigPose& goal) {
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<PathPoint> path;
+        expansions = 0;
+
+        if (lattice.primitives.empty()) {
+            buildTables();
+        }
+
+        goalX = goal.x;
+        goalY = goal.y;
+        goalHeading = MotionPrimitiveLattice::headingBin(goal.cab_angle * M_PI / 180.0f);
+        float goalRadians = goalHeading * MotionPrimitiveLattice::headingBinWidth();
+        goalCos = std::cos(goalRadians);
+        goalSin = std::sin(goalRadians);
+        if (clearanceDirty) buildClearanceGrid();
+        buildHolonomicHeuristic();
+
+        // Keeps its capacity between plans
+        nodes.clear();
+        visited.clear();
+        nodes.reserve(1 << 16);
+        visited.reserve(1 << 16);
+        std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+
+        Node startNode;
+        startNode.x = start.x;
+        startNode.y = start.y;
+        startNode.heading = MotionPrimitiveLattice::headingBin(start.cab_angle * M_PI / 180.0f);
+        startNode.hitch = lattice.hitchBin(start.hitch_angle * M_PI / 180.0f);
+        startNode.g = 0.0f;
+        startNode.parent = -1;
+        startNode.action = -1;
+        startNode.direction = 0;
+        startNode.closed = false;
+        nodes.push_back(startNode);
+        visited[key(startNode)] = 0;
+        open.push(OpenEntry(heuristicWeight * heuristicCost(startNode), 0));
+
+        int goalNode = -1;
+        while (!open.empty() && expansions < maxExpansions) {
+            int current = open.top().second;
+            open.pop();
+            if (nodes[current].closed) continue;
+            nodes[current].closed = true;
+            expansions++;
+
+            if (isGoal(nodes[current])) {
+                goalNode = current;
+                break;
+            }
+
+            // Once inside the heuristic table, try to descend it straight to
+            // the goal before expanding further
+            if (expansions % shotInterval == 0 || nodes[current].g == 0.0f) {
+                goalNode = tableShot(current);
+                if (goalNode >= 0) break;
+            }
+
+            for (int a = 0; a < MotionPrimitiveLattice::kActions; a++) {
+                // Copy, nodes may reallocate below
+                Node from = nodes[current];
+                const MotionPrimitiveLattice::Primitive& p = lattice.get(from.heading, from.hitch, a);
+                if (!p.valid) continue;
+                if (!primitiveIsFree(from, p)) continue;
+
+                Node next;
+                next.x = from.x + p.dx[MotionPrimitiveLattice::kSamples - 1];
+                next.y = from.y + p.dy[MotionPrimitiveLattice::kSamples - 1];
+                next.heading = p.endHeading;
+                next.hitch = p.endHitch;
+                next.direction = p.direction;
+                next.parent = current;
+                next.action = a;
+                next.closed = false;
+
+                next.g = from.g + moveCost(from, p);
+
+                uint64_t k = key(next);
+                auto it = visited.find(k);
+                if (it != visited.end()) {
+                    Node& existing = nodes[it->second];
+                    if (existing.closed || existing.g <= next.g) continue;
+                    existing = next;
+                    open.push(OpenEntry(next.g + heuristicWeight * heuristicCost(next), it->second));
+                } else {
+                    int idx = (int)nodes.size();
+                    nodes.push_back(next);
+                    visited[k] = idx;
+                    open.push(OpenEntry(next.g + heuristicWeight * heuristicCost(next), idx));
+                }
+            }
+        }
+
+        if (goalNode >= 0) {
+            reconstruct(goalNode, path);
+        }
+
+        auto t1 = std::chrono::steady_clock::now();
+        planTimeMs = std::chrono::duration<float, std::milli>(t1 - t0).count();
+        return path;
+    }
+
+    // Footprint test for a pose (angles in degrees)
+    bool isFree(const RigPose& pose) {
+        if (clearanceDirty) buildClearanceGrid();
+
+        float cx[MotionPrimitiveLattice::kDiscs], cy[MotionPrimitiveLattice::kDiscs];
+        rig.discCenters(pose.x, pose.y, pose.cab_angle * M_PI / 180.0f,
+                        pose.hitch_angle * M_PI / 180.0f, cx, cy);
+        return discsAreFree(cx, cy);
+    }
+
+private:
+    struct Node {
+        float x, y;
+        int heading, hitch;
+        float g;
+        int parent;
+        int action;
+        int direction;
+        bool closed;
+    };
+
+    typedef std::pair<float, int> OpenEntry;
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, int> visited;
+
+    // Goal in lattice terms
+    float goalX, goalY;
+    int goalHeading;
+    float goalCos, goalSin;
+
+    // Obstacle clearance sampled on a grid
+    bool clearanceDirty;
+    DistanceField field;
+
+    // 2D obstacle-aware distance to goal
+    int holoCols, holoRows;
+    std::vector<float> holoCost;
+
+    static const uint32_t kCacheMagic = 0x50524b32; // "PRK2"
+
+    void buildTables() {
+        lattice.build(rig);
+        nearHeuristic.build(lattice, reverseFactor);
+        farHeuristic.build(lattice, reverseFactor);
+    }
+
+    uint64_t key(const Node& n) const {
+        uint64_t ix = (uint64_t)(int)std::floor(n.x / cellSize) & 0xffff;
+        uint64_t iy = (uint64_t)(int)std::floor(n.y / cellSize) & 0xffff;
+        return (ix << 32) | (iy << 16) | ((uint64_t)n.heading << 8) | (uint64_t)n.hitch;
+    }
+
+    bool isGoal(const Node& n) const {
+        float dx = n.x - goalX;
+        float dy = n.y - goalY;
+        int centerHitch = MotionPrimitiveLattice::kHitchBins / 2;
+        return dx * dx + dy * dy < goalTolerance * goalTolerance &&
+               n.heading == goalHeading &&
+               n.hitch == centerHitch;
+    }
+
+    // Cost of driving primitive p on from a node: reversing, steering and
+    // changing direction all cost extra
+    float moveCost(const Node& from, const MotionPrimitiveLattice::Primitive& p) const {
+        float cost = p.length;
+        if (p.direction < 0) cost *= reverseFactor;
+        if (p.steer != 0.0f) cost *= steerPenalty;
+        if (from.direction != 0 && from.direction != p.direction) cost += switchPenalty;
+        return cost;
+    }
+
+    // Sample the obstacle distance once per layout so footprint checks are
+    // a lookup. Outside the yard counts as blocked.
+    void buildClearanceGrid() {
+        field.build(yardWidth, yardHeight, obstacles, clearanceCellSize);
+        clearanceDirty = false;
+    }
+
+    float clearance(float x, float y) const {
+        return field.lowerBound(x, y);
+    }
+
+    bool discsAreFree(const float* cx, const float* cy) const {
+        float cabLimit = rig.cabRadius() + safetyMargin;
+        float trailerLimit = rig.trailerRadius() + safetyMargin;
+        for (int i = 0; i < MotionPrimitiveLattice::kDiscs; i++) {
+            float limit = (i < 2) ? cabLimit : trailerLimit;
+            if (clearance(cx[i], cy[i]) < limit) return false;
+        }
+        return true;
+    }
+
+    bool primitiveIsFree(const Node& from, const MotionPrimitiveLattice::Primitive& p) const {
+        float cx[MotionPrimitiveLattice::kDiscs], cy[MotionPrimitiveLattice::kDiscs];
+        for (int i = 0; i < MotionPrimitiveLattice::kSamples; i++) {
+            for (int d = 0; d < MotionPrimitiveLattice::kDiscs; d++) {
+                cx[d] = from.x + p.discX[i][d];
+                cy[d] = from.y + p.discY[i][d];
+            }
+            if (!discsAreFree(cx, cy)) return false;
+        }
+        return true;
+    }
+
+    void buildHolonomicHeuristic() {
+        holoCols = (int)std::ceil(yardWidth / cellSize);
+        holoRows = (int)std::ceil(yardHeight / cellSize);
+        holoCost.assign(holoCols * holoRows, std::numeric_limits<float>::infinity());
+
+        // A cell is passable if the trailer's half width fits around its centre
+        float radius = rig.trailer_width / 2;
+        std::vector<char> passable(holoCols * holoRows);
+        for (int r = 0; r < holoRows; r++) {
+            for (int c = 0; c < holoCols; c++) {
+                float cx = (c + 0.5f) * cellSize;
+                float cy = (r + 0.5f) * cellSize;
+                passable[r * holoCols + c] = clearance(cx, cy) > radius;
+            }
+        }
+
+        int gc = std::min(std::max((int)(goalX / cellSize), 0), holoCols - 1);
+        int gr = std::min(std::max((int)(goalY / cellSize), 0), holoRows - 1);
+
+        typedef std::pair<float, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        holoCost[gr * holoCols + gc] = 0.0f;
+        open.push(Entry(0.0f, gr * holoCols + gc));
+
+        const int dc[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+        const int dr[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+        const float step[8] = {1, 1, 1, 1, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f};
+
+        while (!open.empty()) {
+            Entry top = open.top();
+            open.pop();
+            if (top.first > holoCost[top.second]) continue;
+            int c = top.second % holoCols;
+            int r = top.second / holoCols;
+
+            for (int i = 0; i < 8; i++) {
+                int nc = c + dc[i];
+                int nr = r + dr[i];
+                if (nc < 0 || nr < 0 || nc >= holoCols || nr >= holoRows) continue;
+                int n = nr * holoCols + nc;
+                if (!passable[n]) continue;
+                float g = top.first + step[i] * cellSize;
+                if (g < holoCost[n]) {
+                    holoCost[n] = g;
+                    open.push(Entry(g, n));
+                }
+            }
+        }
+    }
+
+    float heuristicCost(const Node& n) const {
+        float dx = n.x - goalX;
+        float dy = n.y - goalY;
+
+        float holo = std::sqrt(dx * dx + dy * dy);
+        int c = (int)(n.x / cellSize);
+        int r = (int)(n.y / cellSize);
+        if (c >= 0 && r >= 0 && c < holoCols && r < holoRows &&
+            !std::isinf(holoCost[r * holoCols + c])) {
+            holo = holoCost[r * holoCols + c];
+        }
+
+        float far = tableCost(farHeuristic, n.x, n.y, n.heading, n.hitch);
+        float near = tableCost(nearHeuristic, n.x, n.y, n.heading, n.hitch);
+        return std::max(std::max(holo, far), near);
+    }
+
+    // Non-holonomic table lookup, negative outside the table
+    float tableCost(const NonholonomicHeuristic& table, float x, float y, int heading, int hitch) const {
+        // Rotate into the goal frame
+        float dx = x - goalX;
+        float dy = y - goalY;
+        float gx = goalCos * dx + goalSin * dy;
+        float gy = -goalSin * dx + goalCos * dy;
+        int rel = (heading - goalHeading + MotionPrimitiveLattice::kHeadingBins) %
+                  MotionPrimitiveLattice::kHeadingBins;
+        return table.lookup(gx, gy, rel, hitch);
+    }
+
+    // Follow the steepest descent of the heuristic table from a node, adding
+    // the moves as nodes. Returns the goal node, or -1 if the descent stalls
+    // or hits an obstacle.
+    int tableShot(int from) {
+        const int last = MotionPrimitiveLattice::kSamples - 1;
+        float value = tableCost(nearHeuristic, nodes[from].x, nodes[from].y, nodes[from].heading, nodes[from].hitch);
+        if (value < 0) return -1;
+
+        int current = from;
+        for (int step = 0; step < 64; step++) {
+            const Node& n = nodes[current];
+            if (isGoal(n)) return current;
+
+            int bestAction = -1;
+            float bestValue = value;
+            for (int a = 0; a < MotionPrimitiveLattice::kActions; a++) {
+                const MotionPrimitiveLattice::Primitive& p = lattice.get(n.heading, n.hitch, a);
+                if (!p.valid) continue;
+                float v = tableCost(nearHeuristic, n.x + p.dx[last], n.y + p.dy[last], p.endHeading, p.endHitch);
+                if (v >= 0 && v < bestValue) {
+                    bestValue = v;
+                    bestAction = a;
+                }
+            }
+            if (bestAction < 0) return -1;
+
+            const MotionPrimitiveLattice::Primitive& p = lattice.get(n.heading, n.hitch, bestAction);
+            if (!primitiveIsFree(n, p)) return -1;
+
+            Node next;
+            next.x = n.x + p.dx[last];
+            next.y = n.y + p.dy[last];
+            next.heading = p.endHeading;
+            next.hitch = p.endHitch;
+            next.direction = p.direction;
+            next.parent = current;
+            next.action = bestAction;
+            next.closed = true;
+            next.g = n.g + moveCost(n, p);
+            nodes.push_back(next);
+
+            current = (int)nodes.size() - 1;
+            value = bestValue;
+        }
+        return -1;
+    }
+
+    void reconstruct(int goalNode, std::vector<PathPoint>& path) const {
+        std::vector<int> chain;
+        for (int i = goalNode; i >= 0; i = nodes[i].parent) chain.push_back(i);
+        std::reverse(chain.begin(), chain.end());
+
+        const Node& first = nodes[chain[0]];
+        PathPoint p0;
+        p0.x = first.x;
+        p0.y = first.y;
+        p0.cab_angle = first.heading * MotionPrimitiveLattice::headingBinWidth() * 180.0f / M_PI;
+        p0.hitch_angle = lattice.hitchCenter(first.hitch) * 180.0f / M_PI;
+        p0.direction = chain.size() > 1 ? nodes[chain[1]].direction : 1;
+        p0.steer = 0.0f;
+        path.push_back(p0);
+
+        for (size_t c = 1; c < chain.size(); c++) {
+            const Node& from = nodes[chain[c - 1]];
+            const Node& to = nodes[chain[c]];
+            const MotionPrimitiveLattice::Primitive& p = lattice.get(from.heading, from.hitch, to.action);
+            for (int i = 0; i < MotionPrimitiveLattice::kSamples; i++) {
+                PathPoint point;
+                point.x = from.x + p.dx[i];
+                point.y = from.y + p.dy[i];
+                point.cab_angle = p.cab[i] * 180.0f / M_PI;
+                point.hitch_angle = p.hitch[i] * 180.0f / M_PI;
+                point.direction = p.direction;
+                point.steer = p.steer;
+                path.push_back(point);
+            }
+        }
+    }
+
+    // Cache layout: magic, rig parameters, lattice primitives, near table, far table
+    struct CacheHeader {
+        uint32_t magic;
+        int32_t headingBins, hitchBins, actions, samples;
+        int32_t nearHalfCells, farHalfCells;
+        float nearCellSize, farCellSize;
+        float reverseFactor;
+        float rigParams[8];
+    };
+
+    CacheHeader makeHeader() const {
+        CacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = kCacheMagic;
+        header.headingBins = MotionPrimitiveLattice::kHeadingBins;
+        header.hitchBins = MotionPrimitiveLattice::kHitchBins;
+        header.actions = MotionPrimitiveLattice::kActions;
+        header.samples = MotionPrimitiveLattice::kSamples;
+        header.nearHalfCells = nearHeuristic.halfCells;
+        header.farHalfCells = farHeuristic.halfCells;
+        header.nearCellSize = nearHeuristic.cellSize;
+        header.farCellSize = farHeuristic.cellSize;
+        header.reverseFactor = reverseFactor;
+        float params[8] = {rig.cab_length, rig.cab_width, rig.trailer_length, rig.trailer_width,
+                           rig.hitch_distance_from_cab_rear, rig.hitch_distance_from_trailer_front,
+                           rig.maxSpeed, rig.turnRate};
+        std::memcpy(header.rigParams, params, sizeof(params));
+        return header;
+    }
+
+    bool load(const std::string& path) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        CacheHeader expected = makeHeader();
+        CacheHeader header;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                  std::memcmp(&header, &expected, sizeof(header)) == 0;
+
+        if (ok) {
+            lattice.primitives.resize(MotionPrimitiveLattice::kHeadingBins *
+                                      MotionPrimitiveLattice::kHitchBins *
+                                      MotionPrimitiveLattice::kActions);
+            nearHeuristic.table.resize(nearHeuristic.size());
+            farHeuristic.table.resize(farHeuristic.size());
+            ok = readArray(file, lattice.primitives) &&
+                 readArray(file, nearHeuristic.table) &&
+                 readArray(file, farHeuristic.table);
+        }
+        std::fclose(file);
+
+        if (!ok) {
+            lattice.primitives.clear();
+            nearHeuristic.table.clear();
+            farHeuristic.table.clear();
+        }
+        return ok;
+    }
+
+    bool save(const std::string& path) const {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        CacheHeader header = makeHeader();
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  writeArray(file, lattice.primitives) &&
+                  writeArray(file, nearHeuristic.table) &&
+                  writeArray(file, farHeuristic.table);
+        std::fclose(file);
+        return ok;
+    }
+
+    template <typename T>
+    static bool readArray(FILE* file, std::vector<T>& data) {
+        return std::fread(data.data(), sizeof(T), data.size(), file) == data.size();
+    }
+
+    template <typename T>
+    static bool writeArray(FILE* file, const std::vector<T>& data) {
+        return std::fwrite(data.data(), sizeof(T), data.size(), file) == data.size();
+    }
+};
+
+#endif // PARKING_PLANNER_H
@@ -0,0 +1,77 @@
+#ifndef PARKINGSPOT_H
+#define PARKINGSPOT_H
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include "SemiTruck.h"
+
+// A loading bay the truck has to back its trailer into.
+// (x, y) is the centre of the bay, targetAngle is the heading of the cab
+// once parked (cab facing out of the bay, trailer inside it).
+class ParkingSpot {
+public:
+    float x, y;
+    float targetAngle;
+    float length, width;
+    bool isParked;
+
+    // Tolerances for calling the truck parked
+    float positionTolerance;
+    float angleTolerance;
+
+    ParkingSpot(float px, float py, float angle) {
+        x = px;
+        y = py;
+        targetAngle = angle;
+        length = 150.0f;
+        width = 60.0f;
+        isParked = false;
+
+        positionTolerance = 12.0f;
+        angleTolerance = 6.0f;
+    }
+
+    // Where the cab centre sits when the rig is centred in the bay.
+    // The rig (cab + trailer) is 120px long and its centre is 40px behind
+    // the cab centre.
+    float goalCabX() const {
+        return x + std::cos(targetAngle * M_PI / 180.0f) * 40.0f;
+    }
+
+    float goalCabY() const {
+        return y + std::sin(targetAngle * M_PI / 180.0f) * 40.0f;
+    }
+
+    void update(const SemiTruck& truck) {
+        float dx = goalCabX() - truck.cab_x;
+        float dy = goalCabY() - truck.cab_y;
+        float distance = std::sqrt(dx * dx + dy * dy);
+
+        float cabAngleDiff = targetAngle - truck.cab_angle;
+        while (cabAngleDiff > 180.0f) cabAngleDiff -= 360.0f;
+        while (cabAngleDiff < -180.0f) cabAngleDiff += 360.0f;
+
+        float trailerAngleDiff = targetAngle - truck.trailer_angle;
+        while (trailerAngleDiff > 180.0f) trailerAngleDiff -= 360.0f;
+        while (trailerAngleDiff < -180.0f) trailerAngleDiff += 360.0f;
+
+        isParked = distance < positionTolerance &&
+                   std::abs(cabAngleDiff) < angleTolerance &&
+                   std::abs(trailerAngleDiff) < angleTolerance &&
+                   std::abs(truck.cab_speed) < 1.0f;
+    }
+
+    void draw(sf::RenderWindow& window) {
+        sf::RectangleShape bay(sf::Vector2f(length, width));
+        bay.setOrigin(length / 2, width / 2);
+        bay.setPosition(x, y);
+        bay.setRotation(targetAngle);
+        bay.setFillColor(sf::Color(0, 0, 0, 0));
+        bay.setOutlineThickness(3);
+        if (isParked) bay.setOutlineColor(sf::Color::Green);
+        else bay.setOutlineColor(sf::Color::Yellow);
+        window.draw(bay);
+    }
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
 #include <iostream>
+#include "DistanceField.h"
 
 class SemiTruck{
     public:
@@ -168,37 +169,12 @@ class SemiTruck{
         }
     }
 
-    void updateSensors(float envWidth, float envHeight, float wallThickness) {
+    // Raymarch each sensor through the environment's distance field
+    void updateSensors(const DistanceField& field) {
         for (int i = 0; i < numSensors; i++) {
             float sensorWorldAngle = cab_angle + sensorAngles[i];
             float radians = sensorWorldAngle * M_PI / 180.0f;
-
-            // ray from cab to max sensor range
-            float minDist = maxSensorRange;
-
-            // Check intersections with each wall
-            // Left wall 
-            if (std::cos(radians) < 0) {
-                float dist = (cab_x - wallThickness) / -std::cos(radians);
-                if (dist > 0 && dist < minDist) minDist = dist;
-            }
-            // Right wall
-            if (std::cos(radians) > 0) {
-                float dist = (envWidth - wallThickness - cab_x) / std::cos(radians);
-                if (dist > 0 && dist < minDist) minDist = dist;
-            }
-            // Top wall
-            if (std::sin(radians) < 0) {
-                float dist = (cab_y - wallThickness) / -std::sin(radians);
-                if (dist > 0 && dist < minDist) minDist = dist;
-            }
-            // Bottom wall
-            if (std::sin(radians) > 0) {
-                float dist = (envHeight - wallThickness - cab_y) / std::sin(radians);
-                if (dist > 0 && dist < minDist) minDist = dist;
-            }
-
-            sensorDistances[i] = minDist;
+            sensorDistances[i] = field.raymarch(cab_x, cab_y, radians, maxSensorRange);
         }
     }
 
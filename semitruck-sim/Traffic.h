@@ -0,0 +1,469 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "SemiTruck.h"
+#include "Lane.h"
+
+/*
+NPC traffic on the Road.
+
+Car following is the Intelligent Driver Model (IDM) and lane changes use
+MOBIL. NPCs are kept in lane coordinates (distance s along their lane)
+instead of as full SemiTruck/Car objects, so thousands of them are cheap
+to step.
+
+Each lane keeps its vehicle ids sorted by s. The leader and follower of a
+vehicle are its neighbours in that list, and the list is re-sorted with an
+insertion sort every step. That is O(n) because vehicles hardly ever
+overtake within a lane. The ego truck is synced into the lists every step
+so NPCs queue behind it and take it into account when changing lanes.
+*/
+
+enum VehicleKind {
+    NPC_TRUCK,
+    NPC_CAR,
+    EGO
+};
+
+// IDM and MOBIL parameters for one driver (px, px/s, px/s^2)
+struct DriverParams {
+    float desiredSpeed;   // v0
+    float timeHeadway;    // T, seconds
+    float maxAccel;       // a
+    float comfortDecel;   // b
+    float minGap;         // s0, bumper to bumper when stopped
+    float politeness;     // p, how much the gain of others counts
+    float length;         // front bumper to rear
+};
+
+struct TrafficVehicle {
+    VehicleKind kind;
+    DriverParams params;
+    int lane;
+    int rank;               // index in the lane's sorted list
+    float s;                // front bumper, along the lane
+    float speed;
+    float accel;
+
+    // Lane change in progress, drawn sliding across from fromLane
+    int fromLane;
+    float changeProgress;   // 0 to 1, 1 once settled
+    float decisionTimer;    // seconds until MOBIL is asked again
+};
+
+class Traffic {
+public:
+    std::vector<TrafficVehicle> vehicles;
+    std::vector<std::vector<int>> laneOrder;  // vehicle ids, s ascending
+    int egoIndex;
+
+    // MOBIL
+    float changeThreshold;   // advantage needed to bother changing
+    float safeDecel;         // hardest braking a change may force on others
+    float laneChangeTime;
+    float decisionInterval;
+
+    // Stats
+    int laneChanges;
+
+    Traffic() {
+        egoIndex = -1;
+
+        changeThreshold = 10.0f;
+        safeDecel = 120.0f;
+        laneChangeTime = 2.0f;
+        decisionInterval = 1.0f;
+
+        laneChanges = 0;
+    }
+
+    static DriverParams truckParams() {
+        DriverParams p;
+        p.desiredSpeed = 110.0f;
+        p.timeHeadway = 1.5f;
+        p.maxAccel = 60.0f;
+        p.comfortDecel = 90.0f;
+        p.minGap = 20.0f;
+        p.politeness = 0.5f;
+        p.length = 120.0f;
+        return p;
+    }
+
+    static DriverParams carParams() {
+        DriverParams p;
+        p.desiredSpeed = 150.0f;
+        p.timeHeadway = 1.0f;
+        p.maxAccel = 120.0f;
+        p.comfortDecel = 150.0f;
+        p.minGap = 15.0f;
+        p.politeness = 0.2f;
+        p.length = 40.0f;
+        return p;
+    }
+
+    // Spread `count` vehicles over the lanes, a mix of trucks and cars with
+    // some spread in desired speed. A lane only takes as many as fit
+    // bumper to bumper at their minimum gaps; returns how many were placed.
+    int spawn(const Road& road, int count, float truckFraction = 0.4f, unsigned seed = 1) {
+        laneOrder.resize(road.lanes.size());
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        int lanes = (int)road.lanes.size();
+        int placed = 0;
+        for (int lane = 0; lane < lanes; lane++) {
+            int wanted = count / lanes + (lane < count % lanes ? 1 : 0);
+            float laneLength = road.lanes[lane].totalLength;
+
+            std::vector<TrafficVehicle> queue;
+            float used = 0.0f;
+            for (int i = 0; i < wanted; i++) {
+                TrafficVehicle v;
+                v.kind = (unit(rng) < truckFraction) ? NPC_TRUCK : NPC_CAR;
+                v.params = (v.kind == NPC_TRUCK) ? truckParams() : carParams();
+                v.params.desiredSpeed *= 0.9f + 0.2f * unit(rng);
+                float footprint = v.params.length + v.params.minGap;
+                if (used + footprint > laneLength) break;
+                used += footprint;
+                queue.push_back(v);
+            }
+
+            // Share out what is left of the lane as extra spacing
+            float slack = queue.empty() ? 0.0f : (laneLength - used) / queue.size();
+            float s = 0.0f;
+            for (TrafficVehicle& v : queue) {
+                s += v.params.length;
+                v.lane = lane;
+                v.rank = 0;
+                v.s = s;
+                v.speed = 0.5f * v.params.desiredSpeed;
+                v.accel = 0.0f;
+                v.fromLane = lane;
+                v.changeProgress = 1.0f;
+                v.decisionTimer = decisionInterval * unit(rng);
+                s += v.params.minGap + slack;
+
+                laneOrder[lane].push_back((int)vehicles.size());
+                vehicles.push_back(v);
+                placed++;
+            }
+        }
+        sortLanes(road);
+        return placed;
+    }
+
+    void update(const Road& road, const SemiTruck* ego, float dt) {
+        if (laneOrder.size() != road.lanes.size()) laneOrder.resize(road.lanes.size());
+        if (ego) syncEgo(road, *ego);
+
+        // Car following
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            if ((int)i == egoIndex) continue;
+            vehicles[i].accel = followAccel((int)i, road);
+        }
+
+        // Lane changes, a few vehicles per step
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            TrafficVehicle& v = vehicles[i];
+            if ((int)i == egoIndex || v.changeProgress < 1.0f) continue;
+            v.decisionTimer -= dt;
+            if (v.decisionTimer > 0.0f) continue;
+            v.decisionTimer += decisionInterval;
+            considerLaneChange((int)i, road);
+        }
+
+        // Integrate
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            if ((int)i == egoIndex) continue;
+            TrafficVehicle& v = vehicles[i];
+            float newSpeed = std::max(0.0f, v.speed + v.accel * dt);
+            v.s += 0.5f * (v.speed + newSpeed) * dt;
+            v.speed = newSpeed;
+            if (v.changeProgress < 1.0f) {
+                v.changeProgress = std::min(1.0f, v.changeProgress + dt / laneChangeTime);
+            }
+        }
+
+        sortLanes(road);
+    }
+
+    // Bumper-to-bumper gap from the ego to the vehicle ahead, -1 if none
+    float egoGap(const Road& road) const {
+        if (egoIndex < 0) return -1.0f;
+        int leader = leaderOf(egoIndex);
+        if (leader < 0) return -1.0f;
+        return gapBetween(egoIndex, leader, road);
+    }
+
+    // All NPCs in one vertex array, one draw call
+    void draw(sf::RenderWindow& window, const Road& road) const {
+        sf::VertexArray quads(sf::Quads);
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            const TrafficVehicle& v = vehicles[i];
+            if ((int)i == egoIndex) continue;
+
+            if (v.kind == NPC_TRUCK) {
+                // Trailer then cab, both laid along the lane
+                addBox(quads, road, v, v.s - 40.0f - 40.0f, 80.0f, 25.0f, sf::Color(200, 200, 200));
+                addBox(quads, road, v, v.s - 20.0f, 40.0f, 30.0f, sf::Color(60, 110, 200));
+            } else {
+                addBox(quads, road, v, v.s - 20.0f, 40.0f, 20.0f, sf::Color(240, 200, 40));
+            }
+        }
+        window.draw(quads);
+    }
+
+private:
+    // Distance from a to b going forwards round a loop of the given length
+    static float ahead(float from, float to, float length) {
+        float d = to - from;
+        if (d < 0.0f) d += length;
+        return d;
+    }
+
+    int leaderOf(int id) const {
+        const std::vector<int>& order = laneOrder[vehicles[id].lane];
+        if (order.size() < 2) return -1;
+        return order[(vehicles[id].rank + 1) % order.size()];
+    }
+
+    int followerOf(int id) const {
+        const std::vector<int>& order = laneOrder[vehicles[id].lane];
+        if (order.size() < 2) return -1;
+        return order[(vehicles[id].rank + order.size() - 1) % order.size()];
+    }
+
+    float gapBetween(int follower, int leader, const Road& road) const {
+        float length = road.lanes[vehicles[leader].lane].totalLength;
+        return ahead(vehicles[follower].s, vehicles[leader].s, length) - vehicles[leader].params.length;
+    }
+
+    // IDM acceleration; a negative gap means no vehicle ahead
+    static float idm(const DriverParams& p, float speed, float leaderSpeed, float gap) {
+        float ratio = speed / p.desiredSpeed;
+        float freeRoad = p.maxAccel * (1.0f - ratio * ratio * ratio * ratio);
+        if (gap < 0.0f) return freeRoad;
+
+        float desiredGap = p.minGap + std::max(0.0f, speed * p.timeHeadway +
+                           speed * (speed - leaderSpeed) / (2.0f * std::sqrt(p.maxAccel * p.comfortDecel)));
+        float interaction = desiredGap / std::max(gap, 0.1f);
+        float accel = freeRoad - p.maxAccel * interaction * interaction;
+        return std::max(accel, -4.0f * p.comfortDecel);
+    }
+
+    float followAccel(int id, const Road& road) const {
+        int leader = leaderOf(id);
+        const TrafficVehicle& v = vehicles[id];
+        if (leader < 0) return idm(v.params, v.speed, 0.0f, -1.0f);
+        return idm(v.params, v.speed, vehicles[leader].speed, std::max(0.0f, gapBetween(id, leader, road)));
+    }
+
+    // MOBIL: change if my gain plus p times the gain of the followers
+    // affected beats the threshold, and nobody has to brake too hard
+    void considerLaneChange(int id, const Road& road) {
+        TrafficVehicle& me = vehicles[id];
+        int current = me.lane;
+
+        int bestLane = -1;
+        float bestIncentive = changeThreshold;
+        for (int direction = -1; direction <= 1; direction += 2) {
+            int target = current + direction;
+            if (target < 0 || target >= (int)road.lanes.size()) continue;
+
+            float incentive;
+            if (evaluateChange(id, target, road, incentive) && incentive > bestIncentive) {
+                bestIncentive = incentive;
+                bestLane = target;
+            }
+        }
+        if (bestLane < 0) return;
+
+        // Move to the other lane's list at the matching distance
+        float scale = road.lanes[bestLane].totalLength / road.lanes[current].totalLength;
+        std::vector<int>& order = laneOrder[current];
+        order.erase(order.begin() + me.rank);
+        refreshRanks(current);
+
+        me.s *= scale;
+        me.fromLane = current;
+        me.lane = bestLane;
+        me.changeProgress = 0.0f;
+        insertSorted(id);
+        laneChanges++;
+    }
+
+    bool evaluateChange(int id, int target, const Road& road, float& incentive) const {
+        const TrafficVehicle& me = vehicles[id];
+        const Lane& lane = road.lanes[target];
+        float s = me.s * lane.totalLength / road.lanes[me.lane].totalLength;
+
+        // New neighbours: first vehicle ahead of s and the one behind it
+        const std::vector<int>& order = laneOrder[target];
+        int newLeader = -1, newFollower = -1;
+        if (!order.empty()) {
+            int index = firstAhead(order, s);
+            newLeader = order[index % order.size()];
+            newFollower = order[(index + order.size() - 1) % order.size()];
+        }
+
+        // My acceleration after the change
+        float myAccel = idm(me.params, me.speed, 0.0f, -1.0f);
+        if (newLeader >= 0) {
+            float gap = ahead(s, vehicles[newLeader].s, lane.totalLength) - vehicles[newLeader].params.length;
+            if (gap < me.params.minGap) return false;
+            myAccel = idm(me.params, me.speed, vehicles[newLeader].speed, gap);
+        }
+
+        // New follower, before and after I cut in
+        float newFollowerGain = 0.0f;
+        if (newFollower >= 0) {
+            const TrafficVehicle& f = vehicles[newFollower];
+            float gap = ahead(f.s, s, lane.totalLength) - me.params.length;
+            if (gap < f.params.minGap) return false;
+            float after = idm(f.params, f.speed, me.speed, gap);
+            if (after < -safeDecel) return false;
+
+            float before = idm(f.params, f.speed, 0.0f, -1.0f);
+            if (newLeader >= 0 && newLeader != newFollower) {
+                before = idm(f.params, f.speed, vehicles[newLeader].speed, gapBetween(newFollower, newLeader, road));
+            }
+            newFollowerGain = after - before;
+        }
+
+        // Old follower, behind me now and behind my leader after
+        float oldFollowerGain = 0.0f;
+        int oldFollower = followerOf(id);
+        int oldLeader = leaderOf(id);
+        if (oldFollower >= 0) {
+            const TrafficVehicle& f = vehicles[oldFollower];
+            float before = f.accel;
+            float after = idm(f.params, f.speed, 0.0f, -1.0f);
+            if (oldLeader >= 0 && oldLeader != oldFollower) {
+                after = idm(f.params, f.speed, vehicles[oldLeader].speed, gapBetween(oldFollower, oldLeader, road));
+            }
+            oldFollowerGain = after - before;
+        }
+
+        incentive = myAccel - me.accel + me.params.politeness * (newFollowerGain + oldFollowerGain);
+        return true;
+    }
+
+    // Index of the first vehicle with s greater than the given s (may be
+    // order.size(), meaning the list wraps round to the front)
+    int firstAhead(const std::vector<int>& order, float s) const {
+        int lo = 0, hi = (int)order.size();
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (vehicles[order[mid]].s <= s) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    void insertSorted(int id) {
+        std::vector<int>& order = laneOrder[vehicles[id].lane];
+        order.insert(order.begin() + firstAhead(order, vehicles[id].s), id);
+        refreshRanks(vehicles[id].lane);
+    }
+
+    void refreshRanks(int lane) {
+        const std::vector<int>& order = laneOrder[lane];
+        for (size_t k = 0; k < order.size(); k++) vehicles[order[k]].rank = (int)k;
+    }
+
+    // Wrap round the loop and restore the order. Insertion sort, the lists
+    // are almost sorted already.
+    void sortLanes(const Road& road) {
+        for (size_t lane = 0; lane < laneOrder.size(); lane++) {
+            std::vector<int>& order = laneOrder[lane];
+            float length = road.lanes[lane].totalLength;
+            for (int id : order) {
+                TrafficVehicle& v = vehicles[id];
+                if (v.s >= length) v.s -= length;
+            }
+
+            for (size_t k = 1; k < order.size(); k++) {
+                int id = order[k];
+                float s = vehicles[id].s;
+                size_t j = k;
+                while (j > 0 && vehicles[order[j - 1]].s > s) {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+                order[j] = id;
+            }
+            refreshRanks((int)lane);
+        }
+    }
+
+    // Keep the ego's entry in step with the real truck
+    void syncEgo(const Road& road, const SemiTruck& truck) {
+        int lane = road.getClosestLaneIndex(truck);
+        float s = road.lanes[lane].getArcLength(truck) + truck.cab_length / 2;
+
+        if (egoIndex < 0) {
+            TrafficVehicle v;
+            v.kind = EGO;
+            v.params = truckParams();
+            v.lane = lane;
+            v.rank = 0;
+            v.s = 0.0f;
+            v.accel = 0.0f;
+            v.fromLane = lane;
+            v.changeProgress = 1.0f;
+            v.decisionTimer = 0.0f;
+            egoIndex = (int)vehicles.size();
+            vehicles.push_back(v);
+            laneOrder[lane].push_back(egoIndex);
+        }
+
+        TrafficVehicle& ego = vehicles[egoIndex];
+        if (lane != ego.lane) {
+            std::vector<int>& order = laneOrder[ego.lane];
+            order.erase(order.begin() + ego.rank);
+            refreshRanks(ego.lane);
+            ego.lane = lane;
+            ego.s = std::fmod(s, road.lanes[lane].totalLength);
+            insertSorted(egoIndex);
+        }
+        ego.s = std::fmod(s, road.lanes[lane].totalLength);
+        ego.speed = std::max(0.0f, truck.cab_speed);
+        ego.fromLane = lane;
+    }
+
+    // Pose a distance s along the vehicle's lane, sliding across from its
+    // old lane while a change is in progress
+    void poseAt(const Road& road, const TrafficVehicle& v, float s, float& x, float& y, float& angle) const {
+        road.lanes[v.lane].pointAt(s, x, y, angle);
+        if (v.changeProgress >= 1.0f) return;
+
+        float fx, fy, fangle;
+        const Lane& from = road.lanes[v.fromLane];
+        from.pointAt(s * from.totalLength / road.lanes[v.lane].totalLength, fx, fy, fangle);
+        float t = v.changeProgress * v.changeProgress * (3.0f - 2.0f * v.changeProgress);
+        x = fx + (x - fx) * t;
+        y = fy + (y - fy) * t;
+    }
+
+    void addBox(sf::VertexArray& quads, const Road& road, const TrafficVehicle& v,
+                float center, float length, float width, sf::Color color) const {
+        float x, y, angle;
+        poseAt(road, v, center, x, y, angle);
+        float radians = angle * M_PI / 180.0f;
+        float c = std::cos(radians), s = std::sin(radians);
+        float hl = length / 2, hw = width / 2;
+
+        const float corners[4][2] = {{hl, hw}, {hl, -hw}, {-hl, -hw}, {-hl, hw}};
+        for (int k = 0; k < 4; k++) {
+            float u = corners[k][0], w = corners[k][1];
+            quads.append(sf::Vertex(sf::Vector2f(x + c * u - s * w, y + s * u + c * w), color));
+        }
+    }
+};
+
+#endif // TRAFFIC_H
@@ -7,6 +7,7 @@
 #include "Lane.h"
 #include "SemiTruck.h"
 #include "Controller.h"
+#include "Traffic.h"
 
 int main() {
     // Create window - larger to fit the full oval track
@@ -46,25 +47,10 @@ int main() {
     Controller controller;
     controller.setTargetLane(1); // Middle lane
 
-    // Autonomous NPC Truck 1
-    float truck2_startX = WINDOW_WIDTH / 2;
-    float truck2_startY = WINDOW_HEIGHT / 2 - (WINDOW_HEIGHT / 2 - 80);
-    float truck2_startAngle = 0.0f; // facing right
-    SemiTruck semiTruck2(truck2_startX, truck2_startY, truck2_startAngle, 80.0f, true);
-
-    Controller controller2;
-    controller2.setTargetLane(0);
-    controller2.enable(); // start in autonomous mode
-
-    // Autonomous NPC Truck 2
-    float truck3_startX = WINDOW_WIDTH / 2;
-    float truck3_startY = WINDOW_HEIGHT / 2 - (WINDOW_HEIGHT / 2 - 80);
-    float truck3_startAngle = 0.0f; // facing right
-    SemiTruck semiTruck3(truck3_startX, truck3_startY, truck3_startAngle, 80.0f, true);
-
-    Controller controller3;
-    controller3.setTargetLane(2);
-    controller3.enable(); // start in autonomous mode
+    // NPC traffic: IDM car following and MOBIL lane changes
+    const int NPC_COUNT = 24;
+    Traffic traffic;
+    int npcCount = traffic.spawn(road, NPC_COUNT);
 
     
     // Performance metrics
@@ -137,23 +123,11 @@ int main() {
         
         // Player semi truck
         semiTruck.update(dt);
-        semiTruck.updateSensors(WINDOW_WIDTH, WINDOW_HEIGHT, 
-                               environment.wallThickness);
+        semiTruck.updateSensors(environment.getField());
         environment.handleSemiCollision(semiTruck);
 
-        // NPC Semi truck 1
-        controller2.update(semiTruck2, road, dt);
-        semiTruck2.update(dt);
-        semiTruck2.updateSensors(WINDOW_WIDTH, WINDOW_HEIGHT, 
-                               environment.wallThickness);
-        environment.handleSemiCollision(semiTruck2);
-
-        // NPC Semi truck 2
-        controller3.update(semiTruck3, road, dt);
-        semiTruck3.update(dt);
-        semiTruck3.updateSensors(WINDOW_WIDTH, WINDOW_HEIGHT, 
-                               environment.wallThickness);
-        environment.handleSemiCollision(semiTruck3);
+        // NPC traffic reacts to the ego truck
+        traffic.update(road, &semiTruck, dt);
 
         
         // Update metrics
@@ -182,9 +156,8 @@ int main() {
         window.clear();
         
         environment.draw(window);
+        traffic.draw(window, road);
         semiTruck.draw(window);
-        semiTruck2.draw(window);
-        semiTruck3.draw(window);
 
         // Draw controller guidance visualization
         /*
@@ -223,6 +196,10 @@ int main() {
            << "Heading Error: " << std::setprecision(1) << headingError << " deg\n"
            << "Dist to Left: " << std::setprecision(0) << distToLeft << " px\n"
            << "Dist to Right: " << std::setprecision(0) << distToRight << " px\n\n"
+           << "--- Traffic ---\n"
+           << "NPC Vehicles: " << npcCount << "\n"
+           << "Gap Ahead: " << std::setprecision(0) << traffic.egoGap(road) << " px\n"
+           << "Lane Changes: " << traffic.laneChanges << "\n\n"
            << "--- Performance ---\n"
            << "Distance: " << std::setprecision(0) << totalDistanceTraveled << " px\n"
            << "Time in Lane: " << std::setprecision(1) 
@@ -237,7 +214,7 @@ int main() {
         text.setPosition(WINDOW_WIDTH - 290, 10);  // Move to top-right corner
         
         // Add semi-transparent background for readability
-        sf::RectangleShape textBg(sf::Vector2f(280, 500));
+        sf::RectangleShape textBg(sf::Vector2f(280, 580));
         textBg.setPosition(WINDOW_WIDTH - 295, 5);
         textBg.setFillColor(sf::Color(0, 0, 0, 180));
         window.draw(textBg);
@@ -0,0 +1,167 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include "Environment.h"
+#include "SemiTruck.h"
+#include "ParkingSpot.h"
+#include "ParkingPlanner.h"
+#include "Controller_parking.h"
+
+int main() {
+    const float WINDOW_WIDTH = 1400.0f;
+    const float WINDOW_HEIGHT = 900.0f;
+
+    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT),
+                           "Semi Truck Parking");
+    window.setFramerateLimit(60);
+
+    // Load font for text
+    sf::Font font;
+    if (!font.loadFromFile("/System/Library/Fonts/Helvetica.ttc")) {
+        // Try Windows font path
+        if (!font.loadFromFile("C:\\Windows\\Fonts\\arial.ttf")) {
+            // Try Linux font path
+            if (!font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf")) {
+                std::cout << "Warning: Could not load font. Text will not display." << std::endl;
+            }
+        }
+    }
+
+    // Yard with a row of loading bays along the top wall
+    Environment environment(WINDOW_WIDTH, WINDOW_HEIGHT);
+    float wall = environment.wallThickness;
+    float bayX = WINDOW_WIDTH / 2;
+    float bayY = wall + 75.0f;
+    ParkingSpot spot(bayX, bayY, 90.0f); // cab faces out of the bay (down)
+
+    // Trailers parked in the bays either side, and the dock the bays back onto
+    for (int i = -3; i <= 3; i++) {
+        if (i == 0) continue;
+        environment.addObstacle(Obstacle(bayX + i * 100.0f, wall + 70.0f, 120.0f, 30.0f, 90.0f, PARKED_TRAILER));
+    }
+    environment.addObstacle(Obstacle(bayX - 450.0f, wall + 15.0f, 200.0f, 30.0f, 0.0f, LOADING_DOCK));
+    environment.addObstacle(Obstacle(bayX + 450.0f, wall + 15.0f, 200.0f, 30.0f, 0.0f, LOADING_DOCK));
+
+    // The planner works from the same obstacle layer
+    ParkingPlanner planner(WINDOW_WIDTH, WINDOW_HEIGHT);
+    for (const Obstacle& obstacle : environment.obstacles) {
+        planner.addObstacle(obstacle);
+    }
+
+    // Lattice and heuristic table are built once and cached on disk
+    sf::Clock buildTimer;
+    bool cached = planner.loadOrBuild("build/parking_lattice.bin");
+    std::cout << (cached ? "Loaded" : "Built") << " parking tables in "
+              << buildTimer.getElapsedTime().asMilliseconds() << " ms" << std::endl;
+
+    float startX = 300.0f;
+    float startY = 600.0f;
+    float startAngle = 0.0f;
+    SemiTruck semiTruck(startX, startY, startAngle, 0.0f, false);
+
+    Controller controller;
+    controller.setPlanner(&planner);
+
+    sf::Clock clock;
+    sf::Clock loopTimer;
+
+    while (window.isOpen()) {
+        loopTimer.restart();
+
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                window.close();
+            }
+
+            if (event.type == sf::Event::KeyPressed) {
+                // Toggle autonomous parking with spacebar
+                if (event.key.code == sf::Keyboard::Space) {
+                    controller.toggle();
+                    std::cout << "Auto Park: " << (controller.isEnabled ? "ON" : "OFF")
+                             << std::endl;
+                }
+
+                // Plan again from where the truck is now
+                if (event.key.code == sf::Keyboard::P) {
+                    controller.replan();
+                }
+
+                // Reset on R key
+                if (event.key.code == sf::Keyboard::R) {
+                    semiTruck = SemiTruck(startX, startY, startAngle, 0.0f, false);
+                    controller.disable();
+                    controller.replan();
+                    std::cout << "System reset" << std::endl;
+                }
+            }
+        }
+
+        // Update physics
+        float dt = clock.restart().asSeconds();
+
+        if (controller.isEnabled) {
+            controller.update(semiTruck, spot, dt);
+        } else {
+            semiTruck.handleInput(dt);
+        }
+
+        semiTruck.update(dt);
+        semiTruck.updateSensors(environment.getField());
+        environment.handleSemiCollision(semiTruck);
+        spot.update(semiTruck);
+
+        // Drawing
+        window.clear();
+
+        environment.draw(window);
+        spot.draw(window);
+        controller.drawPath(window);
+        semiTruck.draw(window);
+
+        // Draw UI
+        sf::Text text;
+        text.setFont(font);
+        text.setCharacterSize(16);
+        text.setFillColor(sf::Color::White);
+
+        float hitch = semiTruck.cab_angle - semiTruck.trailer_angle;
+        while (hitch > 180.0f) hitch -= 360.0f;
+        while (hitch < -180.0f) hitch += 360.0f;
+
+        std::stringstream ss;
+        ss << "=== PARKING SYSTEM ===\n"
+           << "Mode: " << (controller.isEnabled ? "AUTONOMOUS" : "MANUAL") << "\n"
+           << "State: " << controller.getStateName() << "\n"
+           << "Parked: " << (spot.isParked ? "YES" : "NO") << "\n\n"
+           << "--- Truck Status ---\n"
+           << "Position: (" << std::fixed << std::setprecision(0)
+           << semiTruck.cab_x << ", " << semiTruck.cab_y << ")\n"
+           << "Heading: " << std::setprecision(0) << semiTruck.cab_angle << " deg\n"
+           << "Hitch: " << std::setprecision(1) << hitch << " deg\n"
+           << "Speed: " << std::setprecision(1) << semiTruck.cab_speed << " px/s\n"
+           << "Collision: " << (semiTruck.isColliding ? "YES" : "NO") << "\n\n"
+           << "--- Planner ---\n"
+           << "Path Points: " << controller.path.size() << "\n"
+           << "Expansions: " << planner.expansions << "\n"
+           << "Plan Time: " << std::setprecision(1) << planner.planTimeMs << " ms\n"
+           << "Replans: " << controller.replans << "\n"
+           << "Latency: " << std::setprecision(3) << loopTimer.getElapsedTime().asSeconds() * 1000.0f << " ms\n\n"
+           << "Space: auto park  P: replan  R: reset\n";
+
+        text.setString(ss.str());
+        text.setPosition(WINDOW_WIDTH - 290, 10);
+
+        // Add semi-transparent background for readability
+        sf::RectangleShape textBg(sf::Vector2f(280, 400));
+        textBg.setPosition(WINDOW_WIDTH - 295, 5);
+        textBg.setFillColor(sf::Color(0, 0, 0, 180));
+        window.draw(textBg);
+
+        window.draw(text);
+        window.display();
+    }
+
+    return 0;
+}